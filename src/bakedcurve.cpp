@@ -0,0 +1,135 @@
+#include "bakedcurve.hpp"
+
+namespace xna {
+	static BakedCurveLoop BakeLoop(CurveLoopType loopType, CurveKeyCollection& keys, bool pre) {
+		BakedCurveLoop loop;
+
+		if (keys.Count() <= 1)
+			return loop;
+
+		auto const& first = keys.Index(0);
+		auto const& last = keys.Index(keys.Count() - 1);
+
+		switch (loopType) {
+		case CurveLoopType::Linear:
+			loop.Slope = pre ? first.TangentIn() : last.TangentOut();
+			break;
+		case CurveLoopType::Cycle:
+			loop.Cycle = 1.0;
+			break;
+		case CurveLoopType::CycleOffset:
+			loop.Cycle = 1.0;
+			loop.Offset = last.Value() - first.Value();
+			break;
+		case CurveLoopType::Oscillate:
+			loop.Cycle = 1.0;
+			loop.Mirror = true;
+			break;
+		default:
+			break;
+		}
+
+		return loop;
+	}
+
+	BakedCurve::BakedCurve(Curve& curve, size_t sampleCount) {
+		Resample(curve, sampleCount);
+	}
+
+	void BakedCurve::Resample(Curve& curve, size_t sampleCount) {
+		auto& keys = curve.Keys();
+		const auto count = std::max<size_t>(sampleCount, 2);
+
+		layout = BakedCurveLayout();
+		layout.SampleCount = count;
+
+		if (keys.Count() > 0) {
+			layout.Start = keys.Index(0).Position();
+			layout.End = keys.Index(keys.Count() - 1).Position();
+			layout.Range = layout.End - layout.Start;
+		}
+
+		if (layout.Range > 1.4012984643248171E-45) {
+			layout.InvRange = 1.0 / layout.Range;
+			layout.InvStep = static_cast<double>(count - 1) / layout.Range;
+		}
+
+		layout.PreLoop = BakeLoop(curve.PreLoop(), keys, true);
+		layout.PostLoop = BakeLoop(curve.PostLoop(), keys, false);
+
+		samples.resize(count + 1);
+
+		for (size_t i = 0; i < count; ++i)
+			samples[i] = layout.Start + layout.Range * static_cast<double>(i) / static_cast<double>(count - 1);
+
+		samples[count - 1] = layout.End;
+		curve.Evaluate(std::span<const double>(samples.data(), count), std::span<double>(samples.data(), count));
+		samples[count] = samples[count - 1];
+	}
+
+	BakedCurve BakedCurve::FromTolerance(Curve& curve, double tolerance, size_t maxSampleCount) {
+		BakedCurve baked(curve, 2);
+
+		if (baked.layout.InvStep == 0.0)
+			return baked;
+
+		std::vector<double> midpoints;
+		std::vector<double> resampled;
+
+		while (baked.layout.SampleCount * 2 - 1 <= maxSampleCount) {
+			const auto intervals = baked.layout.SampleCount - 1;
+			const auto& layout = baked.layout;
+
+			midpoints.resize(intervals);
+
+			for (size_t i = 0; i < intervals; ++i)
+				midpoints[i] = layout.Start + layout.Range * static_cast<double>(2 * i + 1) / static_cast<double>(2 * intervals);
+
+			curve.Evaluate(midpoints, midpoints);
+
+			double error = 0.0;
+
+			for (size_t i = 0; i < intervals; ++i) {
+				const auto lerped = (baked.samples[i] + baked.samples[i + 1]) * 0.5;
+				error = std::max(error, std::abs(midpoints[i] - lerped));
+			}
+
+			if (error <= tolerance)
+				break;
+
+			const auto count = intervals * 2 + 1;
+			resampled.resize(count + 1);
+
+			for (size_t i = 0; i < intervals; ++i) {
+				resampled[2 * i] = baked.samples[i];
+				resampled[2 * i + 1] = midpoints[i];
+			}
+
+			resampled[count - 1] = baked.samples[intervals];
+			resampled[count] = baked.samples[intervals];
+
+			baked.samples.swap(resampled);
+			baked.layout.SampleCount = count;
+			baked.layout.InvStep = static_cast<double>(count - 1) / baked.layout.Range;
+		}
+
+		return baked;
+	}
+
+	void BakedCurve::Evaluate(std::span<const double> positions, std::span<double> results) const {
+		const auto count = std::min(positions.size(), results.size());
+
+		for (size_t i = 0; i < count; ++i)
+			results[i] = layout.Evaluate(samples.data(), positions[i]);
+	}
+
+	size_t BakedCurveTable::Add(BakedCurve const& curve) {
+		auto layout = curve.layout;
+		layout.SampleOffset = samples.size();
+
+		samples.insert(samples.end(), curve.samples.begin(), curve.samples.end());
+		layouts.push_back(layout);
+
+		return layouts.size() - 1;
+	}
+}
\ No newline at end of file
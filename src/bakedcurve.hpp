@@ -0,0 +1,136 @@
+#ifndef XNA_BAKEDCURVE_HPP
+#define XNA_BAKEDCURVE_HPP
+
+#include "curve.hpp"
+#include <span>
+#include <vector>
+
+namespace xna {
+	//How a baked curve behaves outside its key range on one side. Every loop
+	//type is expressed through the same four terms so that lookups select
+	//between them instead of branching on CurveLoopType.
+	struct BakedCurveLoop {
+		//1 for Cycle, CycleOffset and Oscillate, 0 otherwise.
+		double Cycle{ 0.0 };
+		//Value gained per cycle by CycleOffset.
+		double Offset{ 0.0 };
+		//Whether odd cycles run backwards (Oscillate).
+		bool Mirror{ false };
+		//Tangent extrapolated by Linear.
+		double Slope{ 0.0 };
+	};
+
+	//Where a baked curve's samples start in its sample array, and how
+	//positions map onto them. Samples are spaced evenly over [Start, End] and
+	//followed by one copy of the last sample, so a lookup at End reads no
+	//further than that.
+	struct BakedCurveLayout {
+		size_t SampleOffset{ 0 };
+		size_t SampleCount{ 0 };
+		double Start{ 0.0 };
+		double End{ 0.0 };
+		double Range{ 0.0 };
+		double InvRange{ 0.0 };
+		double InvStep{ 0.0 };
+		BakedCurveLoop PreLoop;
+		BakedCurveLoop PostLoop;
+
+		double Evaluate(double const* samples, double position) const {
+			const auto before = position < Start;
+			auto const& loop = before ? PreLoop : PostLoop;
+
+			//The same cycle count as Curve::CalcCycle, only applied outside
+			//the key range on a side that cycles.
+			auto num = (position - Start) * InvRange;
+			num = num < 0.0 ? num - 1.0 : num;
+			const auto outside = before || position > End;
+			const auto cycle = outside ? static_cast<double>(static_cast<cslong>(num)) * loop.Cycle : 0.0;
+
+			auto t = position - cycle * Range;
+			t = loop.Mirror && (static_cast<cslong>(cycle) & 1) != 0 ? Start + End - t : t;
+
+			const auto clamped = std::clamp(t, Start, End);
+			const auto u = (clamped - Start) * InvStep;
+			const auto index = static_cast<size_t>(u);
+			const auto amount = u - static_cast<double>(index);
+			const auto sample = samples + SampleOffset + index;
+
+			return sample[0] + (sample[1] - sample[0]) * amount
+				+ cycle * loop.Offset + loop.Slope * (t - clamped);
+		}
+	};
+
+	//A Curve resampled at evenly spaced positions and evaluated in constant
+	//time by linear interpolation. Loop types behave as on the source curve.
+	//Accuracy depends on the sample count; a Step key is smeared over one
+	//sample interval.
+	class BakedCurve {
+	public:
+		static constexpr size_t DefaultMaxSampleCount = 4097;
+
+		BakedCurve() = default;
+
+		//Bakes curve at sampleCount evenly spaced positions, at least two.
+		BakedCurve(Curve& curve, size_t sampleCount);
+
+		//Bakes curve with the fewest samples, halving the sample interval each
+		//time, whose interpolation stays within tolerance of the curve at the
+		//middle of every interval. Stops once another halving would exceed
+		//maxSampleCount.
+		static BakedCurve FromTolerance(Curve& curve, double tolerance, size_t maxSampleCount = DefaultMaxSampleCount);
+
+		double Evaluate(double position) const {
+			return layout.Evaluate(samples.data(), position);
+		}
+
+		//Evaluates as many positions as results holds.
+		void Evaluate(std::span<const double> positions, std::span<double> results) const;
+
+		constexpr BakedCurveLayout const& Layout() const { return layout; }
+		constexpr size_t SampleCount() const { return layout.SampleCount; }
+
+		std::span<const double> Samples() const {
+			return std::span<const double>(samples.data(), layout.SampleCount);
+		}
+
+	private:
+		BakedCurveLayout layout;
+		std::vector<double> samples;
+
+		void Resample(Curve& curve, size_t sampleCount);
+
+		friend class BakedCurveTable;
+	};
+
+	//Many baked curves sharing one contiguous sample array, addressed by the
+	//index Add returns. Suited to particle-over-life and tweening lookups,
+	//where one system walks many small curves every frame.
+	class BakedCurveTable {
+	public:
+		//Copies curve's samples into the table and returns its index.
+		size_t Add(BakedCurve const& curve);
+
+		size_t Add(Curve& curve, size_t sampleCount) {
+			return Add(BakedCurve(curve, sampleCount));
+		}
+
+		double Evaluate(size_t curve, double position) const {
+			return layouts[curve].Evaluate(samples.data(), position);
+		}
+
+		constexpr size_t Count() const { return layouts.size(); }
+		constexpr BakedCurveLayout const& Layout(size_t curve) const { return layouts[curve]; }
+		std::span<const double> Samples() const { return samples; }
+
+		void Clear() {
+			layouts.clear();
+			samples.clear();
+		}
+
+	private:
+		std::vector<BakedCurveLayout> layouts;
+		std::vector<double> samples;
+	};
+}
+
+#endif
\ No newline at end of file
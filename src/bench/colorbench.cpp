@@ -0,0 +1,91 @@
+//Measures the bulk Color operations against their per-color forms.
+//
+//	colorbench [pixels]
+//
+//Each operation runs over buffers of random RGBA32 pixels, 1M by default,
+//and the best of seven runs is reported in megapixels per second.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+#include "../color.hpp"
+
+using xna::Color;
+
+template <typename TFunction>
+static double Megapixels(size_t pixels, TFunction const& function) {
+	auto best = 1e30;
+
+	for (csint run = 0; run < 7; ++run) {
+		const auto start = std::chrono::steady_clock::now();
+		function();
+		const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+		best = std::min(best, elapsed.count());
+	}
+
+	return static_cast<double>(pixels) / best / 1e6;
+}
+
+static void Report(char const* name, double perColor, double bulk) {
+	std::printf("%-22s %10.0f %10.0f %8.1fx\n", name, perColor, bulk, bulk / perColor);
+}
+
+int main(int argc, char** argv) {
+	const auto parsed = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 0;
+	const auto pixels = parsed > 0 ? static_cast<size_t>(parsed) : static_cast<size_t>(1) << 20;
+
+	std::mt19937 random(1);
+	std::vector<csuint> first(pixels);
+	std::vector<csuint> second(pixels);
+	std::vector<csuint> premultiplied(pixels);
+	std::vector<csuint> result(pixels);
+
+	std::generate(first.begin(), first.end(), random);
+	std::generate(second.begin(), second.end(), random);
+	Color::FromNonPremultiplied(first, premultiplied);
+
+	std::printf("%zu pixels, best of 7 runs, megapixels per second\n\n", pixels);
+	std::printf("%-22s %10s %10s %9s\n", "", "per-color", "bulk", "speedup");
+
+	Report("Lerp",
+		Megapixels(pixels, [&] {
+			for (size_t i = 0; i < pixels; ++i)
+				result[i] = Color::Lerp(Color(first[i]), Color(second[i]), 0.3).PackedValue();
+		}),
+		Megapixels(pixels, [&] { Color::Lerp(first, second, 0.3, result); }));
+
+	Report("Multiply",
+		Megapixels(pixels, [&] {
+			for (size_t i = 0; i < pixels; ++i)
+				result[i] = Color::Multiply(Color(first[i]), 0.7).PackedValue();
+		}),
+		Megapixels(pixels, [&] { Color::Multiply(first, 0.7, result); }));
+
+	Report("FromNonPremultiplied",
+		Megapixels(pixels, [&] {
+			for (size_t i = 0; i < pixels; ++i) {
+				const Color color(first[i]);
+				result[i] = Color::FromNonPremultiplied(color.R(), color.G(), color.B(), color.A()).PackedValue();
+			}
+		}),
+		Megapixels(pixels, [&] { Color::FromNonPremultiplied(first, result); }));
+
+	Report("AlphaBlend",
+		Megapixels(pixels, [&] {
+			for (size_t i = 0; i < pixels; ++i)
+				result[i] = Color::AlphaBlend(Color(premultiplied[i]), Color(second[i])).PackedValue();
+		}),
+		Megapixels(pixels, [&] { Color::AlphaBlend(premultiplied, second, result); }));
+
+	//Keeps the last results observable so the loops are not optimized away.
+	csuint checksum = 0;
+
+	for (const auto value : result)
+		checksum ^= value;
+
+	std::printf("\nchecksum %08X\n", checksum);
+	return 0;
+}
\ No newline at end of file
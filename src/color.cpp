@@ -1 +1,251 @@
-#include "color.hpp"
\ No newline at end of file
+#include "color.hpp"
+#include <algorithm>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define XNA_COLOR_AVX2
+#endif
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define XNA_COLOR_SSE2
+#endif
+
+namespace xna {
+	//The integer operations the bulk kernels need, for one register width.
+	//Pixels are widened to 16 bits per channel, two halves at a time; every
+	//unpack is undone by a pack within the same 128-bit lane, so the AVX2 lane
+	//split never reorders pixels.
+#ifdef XNA_COLOR_SSE2
+	struct ColorLanesSse2 {
+		using Vector = __m128i;
+		static constexpr size_t Pixels = 4;
+
+		static Vector Load(csuint const* source) { return _mm_loadu_si128(reinterpret_cast<Vector const*>(source)); }
+		static void Store(csuint* destination, Vector value) { _mm_storeu_si128(reinterpret_cast<Vector*>(destination), value); }
+		static Vector Set16(csshort value) { return _mm_set1_epi16(value); }
+		static Vector Set64(cslong value) { return _mm_set1_epi64x(value); }
+		static Vector Zero() { return _mm_setzero_si128(); }
+		static Vector Low(Vector value) { return _mm_unpacklo_epi8(value, Zero()); }
+		static Vector High(Vector value) { return _mm_unpackhi_epi8(value, Zero()); }
+		static Vector Pack(Vector low, Vector high) { return _mm_packus_epi16(low, high); }
+		static Vector Add(Vector a, Vector b) { return _mm_add_epi16(a, b); }
+		static Vector Sub(Vector a, Vector b) { return _mm_sub_epi16(a, b); }
+		static Vector SubSaturate(Vector a, Vector b) { return _mm_subs_epu16(a, b); }
+		static Vector MulLow(Vector a, Vector b) { return _mm_mullo_epi16(a, b); }
+		static Vector MulHigh(Vector a, Vector b) { return _mm_mulhi_epi16(a, b); }
+		static Vector MulHighUnsigned(Vector a, Vector b) { return _mm_mulhi_epu16(a, b); }
+		static Vector ShiftRight(Vector value, int count) { return _mm_srli_epi16(value, count); }
+		static Vector And(Vector a, Vector b) { return _mm_and_si128(a, b); }
+		static Vector AndNot(Vector a, Vector b) { return _mm_andnot_si128(a, b); }
+		static Vector Or(Vector a, Vector b) { return _mm_or_si128(a, b); }
+
+		//Copies each pixel's alpha into its four channels.
+		static Vector Alpha(Vector value) {
+			return _mm_shufflehi_epi16(_mm_shufflelo_epi16(value, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+		}
+	};
+#endif
+
+#ifdef XNA_COLOR_AVX2
+	struct ColorLanesAvx2 {
+		using Vector = __m256i;
+		static constexpr size_t Pixels = 8;
+
+		static Vector Load(csuint const* source) { return _mm256_loadu_si256(reinterpret_cast<Vector const*>(source)); }
+		static void Store(csuint* destination, Vector value) { _mm256_storeu_si256(reinterpret_cast<Vector*>(destination), value); }
+		static Vector Set16(csshort value) { return _mm256_set1_epi16(value); }
+		static Vector Set64(cslong value) { return _mm256_set1_epi64x(value); }
+		static Vector Zero() { return _mm256_setzero_si256(); }
+		static Vector Low(Vector value) { return _mm256_unpacklo_epi8(value, Zero()); }
+		static Vector High(Vector value) { return _mm256_unpackhi_epi8(value, Zero()); }
+		static Vector Pack(Vector low, Vector high) { return _mm256_packus_epi16(low, high); }
+		static Vector Add(Vector a, Vector b) { return _mm256_add_epi16(a, b); }
+		static Vector Sub(Vector a, Vector b) { return _mm256_sub_epi16(a, b); }
+		static Vector SubSaturate(Vector a, Vector b) { return _mm256_subs_epu16(a, b); }
+		static Vector MulLow(Vector a, Vector b) { return _mm256_mullo_epi16(a, b); }
+		static Vector MulHigh(Vector a, Vector b) { return _mm256_mulhi_epi16(a, b); }
+		static Vector MulHighUnsigned(Vector a, Vector b) { return _mm256_mulhi_epu16(a, b); }
+		static Vector ShiftRight(Vector value, int count) { return _mm256_srli_epi16(value, count); }
+		static Vector And(Vector a, Vector b) { return _mm256_and_si256(a, b); }
+		static Vector AndNot(Vector a, Vector b) { return _mm256_andnot_si256(a, b); }
+		static Vector Or(Vector a, Vector b) { return _mm256_or_si256(a, b); }
+
+		static Vector Alpha(Vector value) {
+			return _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(value, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+		}
+	};
+#endif
+
+	//c1 + ((c2 - c1) * weight >> 16) for a weight below 65536. Weights of
+	//32768 and up do not fit a signed 16-bit multiply, so the high half is
+	//taken of (weight - 65536) and the difference added back.
+	template <typename L>
+	static size_t LerpPixels(csuint const* value1, csuint const* value2, csuint* result, size_t index, size_t count, csint weight) {
+		const auto factor = L::Set16(static_cast<csshort>(weight));
+		const auto carry = L::Set16(weight >= 32768 ? -1 : 0);
+
+		const auto lerp = [&](typename L::Vector a, typename L::Vector b) {
+			const auto difference = L::Sub(b, a);
+			return L::Add(L::Add(a, L::MulHigh(difference, factor)), L::And(difference, carry));
+		};
+
+		for (; index + L::Pixels <= count; index += L::Pixels) {
+			const auto a = L::Load(value1 + index);
+			const auto b = L::Load(value2 + index);
+			L::Store(result + index, L::Pack(lerp(L::Low(a), L::Low(b)), lerp(L::High(a), L::High(b))));
+		}
+
+		return index;
+	}
+
+	//c * scale >> 16 with scale split into its high and low 16 bits, then
+	//clamped to 255: x - max(x - 255, 0).
+	template <typename L>
+	static size_t MultiplyPixels(csuint const* value, csuint* result, size_t index, size_t count, csuint scale) {
+		const auto high = L::Set16(static_cast<csshort>(scale >> 16));
+		const auto low = L::Set16(static_cast<csshort>(scale & 0xFFFF));
+		const auto max = L::Set16(byte_max);
+
+		const auto multiply = [&](typename L::Vector channels) {
+			const auto product = L::Add(L::MulLow(channels, high), L::MulHighUnsigned(channels, low));
+			return L::Sub(product, L::SubSaturate(product, max));
+		};
+
+		for (; index + L::Pixels <= count; index += L::Pixels) {
+			const auto pixels = L::Load(value + index);
+			L::Store(result + index, L::Pack(multiply(L::Low(pixels)), multiply(L::High(pixels))));
+		}
+
+		return index;
+	}
+
+	//c * a / 255 truncated, using x / 255 == (x + 1 + (x >> 8)) >> 8 for
+	//x <= 65535. Alpha passes through.
+	template <typename L>
+	static size_t PremultiplyPixels(csuint const* value, csuint* result, size_t index, size_t count) {
+		const auto one = L::Set16(1);
+		const auto alphaMask = L::Set64(static_cast<cslong>(0xFFFF000000000000ULL));
+
+		const auto premultiply = [&](typename L::Vector channels) {
+			const auto product = L::MulLow(channels, L::Alpha(channels));
+			const auto quotient = L::ShiftRight(L::Add(L::Add(product, one), L::ShiftRight(product, 8)), 8);
+			return L::Or(L::AndNot(alphaMask, quotient), L::And(alphaMask, channels));
+		};
+
+		for (; index + L::Pixels <= count; index += L::Pixels) {
+			const auto pixels = L::Load(value + index);
+			L::Store(result + index, L::Pack(premultiply(L::Low(pixels)), premultiply(L::High(pixels))));
+		}
+
+		return index;
+	}
+
+	//s + round(d * (255 - sa) / 255), with round(x / 255) computed as
+	//(t + (t >> 8)) >> 8 for t = x + 128. The pack saturates at 255.
+	template <typename L>
+	static size_t AlphaBlendPixels(csuint const* source, csuint const* destination, csuint* result, size_t index, size_t count) {
+		const auto half = L::Set16(128);
+		const auto max = L::Set16(byte_max);
+
+		const auto blend = [&](typename L::Vector s, typename L::Vector d) {
+			const auto product = L::Add(L::MulLow(d, L::Sub(max, L::Alpha(s))), half);
+			return L::Add(s, L::ShiftRight(L::Add(product, L::ShiftRight(product, 8)), 8));
+		};
+
+		for (; index + L::Pixels <= count; index += L::Pixels) {
+			const auto s = L::Load(source + index);
+			const auto d = L::Load(destination + index);
+			L::Store(result + index, L::Pack(blend(L::Low(s), L::Low(d)), blend(L::High(s), L::High(d))));
+		}
+
+		return index;
+	}
+
+	//Scalar forms of the kernels above, with the weight and scale already in
+	//fixed point, for the remaining pixels and for targets without SSE2.
+	static constexpr csuint LerpPixel(csuint value1, csuint value2, csint weight) {
+		const auto lerp = [=](csint shift) {
+			const csint channel1 = tobyte(value1 >> shift);
+			const csint channel2 = tobyte(value2 >> shift);
+			return touint(channel1 + ((channel2 - channel1) * weight >> 16)) << shift;
+		};
+
+		return lerp(0) | lerp(8) | lerp(16) | lerp(24);
+	}
+
+	static constexpr csuint MultiplyPixel(csuint value, csuint scale) {
+		const auto multiply = [=](csint shift) {
+			const auto channel = tobyte(value >> shift) * scale >> 16;
+			return (channel > byte_max ? byte_max : channel) << shift;
+		};
+
+		return multiply(0) | multiply(8) | multiply(16) | multiply(24);
+	}
+
+	void Color::Lerp(std::span<const csuint> value1, std::span<const csuint> value2, double amount, std::span<csuint> result) {
+		const auto count = std::min({ value1.size(), value2.size(), result.size() });
+		const auto weight = toint(PackUtils::PackUNorm(65536, amount));
+
+		if (weight == 65536) {
+			std::copy_n(value2.begin(), count, result.begin());
+			return;
+		}
+
+		size_t index = 0;
+#ifdef XNA_COLOR_AVX2
+		index = LerpPixels<ColorLanesAvx2>(value1.data(), value2.data(), result.data(), index, count, weight);
+#endif
+#ifdef XNA_COLOR_SSE2
+		index = LerpPixels<ColorLanesSse2>(value1.data(), value2.data(), result.data(), index, count, weight);
+#endif
+		for (; index < count; ++index)
+			result[index] = LerpPixel(value1[index], value2[index], weight);
+	}
+
+	void Color::Multiply(std::span<const csuint> value, double scale, std::span<csuint> result) {
+		const auto count = std::min(value.size(), result.size());
+		const auto scaled = scale * 65536.0;
+		const csuint fixedScale = scaled >= 0.0 ? (scaled <= 16777215.0 ? static_cast<csuint>(scaled) : 16777215U) : 0U;
+
+		size_t index = 0;
+#ifdef XNA_COLOR_AVX2
+		index = MultiplyPixels<ColorLanesAvx2>(value.data(), result.data(), index, count, fixedScale);
+#endif
+#ifdef XNA_COLOR_SSE2
+		index = MultiplyPixels<ColorLanesSse2>(value.data(), result.data(), index, count, fixedScale);
+#endif
+		for (; index < count; ++index)
+			result[index] = MultiplyPixel(value[index], fixedScale);
+	}
+
+	void Color::FromNonPremultiplied(std::span<const csuint> value, std::span<csuint> result) {
+		const auto count = std::min(value.size(), result.size());
+
+		size_t index = 0;
+#ifdef XNA_COLOR_AVX2
+		index = PremultiplyPixels<ColorLanesAvx2>(value.data(), result.data(), index, count);
+#endif
+#ifdef XNA_COLOR_SSE2
+		index = PremultiplyPixels<ColorLanesSse2>(value.data(), result.data(), index, count);
+#endif
+		for (; index < count; ++index) {
+			const Color color(value[index]);
+			result[index] = FromNonPremultiplied(color.R(), color.G(), color.B(), color.A()).packedValue;
+		}
+	}
+
+	void Color::AlphaBlend(std::span<const csuint> source, std::span<const csuint> destination, std::span<csuint> result) {
+		const auto count = std::min({ source.size(), destination.size(), result.size() });
+
+		size_t index = 0;
+#ifdef XNA_COLOR_AVX2
+		index = AlphaBlendPixels<ColorLanesAvx2>(source.data(), destination.data(), result.data(), index, count);
+#endif
+#ifdef XNA_COLOR_SSE2
+		index = AlphaBlendPixels<ColorLanesSse2>(source.data(), destination.data(), result.data(), index, count);
+#endif
+		for (; index < count; ++index)
+			result[index] = AlphaBlend(Color(source[index]), Color(destination[index])).packedValue;
+	}
+}
\ No newline at end of file
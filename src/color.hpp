@@ -3,9 +3,12 @@
 
 #include "graphics/packedvector.hpp"
 #include "csharp/integralnumeric.hpp"
+#include <span>
 
 namespace xna {
 	struct Color : IPackedVectorT<csuint> {
+		static constexpr PackedFormat Format{ PackedKind::UNorm, { { 0, 8 }, { 8, 8 }, { 16, 8 }, { 24, 8 } } };
+
 		constexpr Color() = default;
 
 		constexpr Color(csuint packedValue) :
@@ -55,15 +58,15 @@ namespace xna {
 			packedValue(PackHelper(vector.X, vector.Y, vector.Z, vector.W)) {
 		}
 
-		virtual constexpr void PackFromVector4(Vector4 const& vector) override {
+		constexpr void PackFromVector4(Vector4 const& vector) {
 			packedValue = PackHelper(vector.X, vector.Y, vector.Z, vector.W);
 		}
 
-		virtual constexpr csuint PackedValue() const {
+		constexpr csuint PackedValue() const {
 			return packedValue;
 		}
 
-		virtual constexpr void PackedValue(csuint const& value) {
+		constexpr void PackedValue(csuint const& value) {
 			packedValue = value;
 		}
 
@@ -97,7 +100,7 @@ namespace xna {
 			return vector3;
 		}
 
-		virtual constexpr Vector4 ToVector4() const override {
+		constexpr Vector4 ToVector4() const {
 			Vector4 vector4;
 			vector4.X = PackUtils::UnpackUNorm(byte_max, packedValue);
 			vector4.Y = PackUtils::UnpackUNorm(byte_max, packedValue >> 8);
@@ -201,6 +204,32 @@ namespace xna {
 			return color;
 		}
 
+		//Premultiplied source-over compositing, as BlendState.AlphaBlend: each
+		//destination channel is scaled by the inverse source alpha, rounded, and
+		//added to the source channel, saturating at 255.
+		static constexpr Color AlphaBlend(Color const& source, Color const& destination) {
+			const auto inverseAlpha = byte_max - toint(source.packedValue >> 24);
+			csuint packed = 0;
+
+			for (csint shift = 0; shift < 32; shift += 8) {
+				const auto product = toint(tobyte(destination.packedValue >> shift)) * inverseAlpha + 128;
+				const auto channel = toint(tobyte(source.packedValue >> shift)) + ((product + (product >> 8)) >> 8);
+				packed |= touint(channel > byte_max ? byte_max : channel) << shift;
+			}
+
+			return Color(packed);
+		}
+
+		//Bulk versions over packed RGBA values, as laid out in textures and
+		//vertex buffers. Each writes as many values as the shortest span holds,
+		//and gives exactly the per-color result. result may be one of the inputs.
+		//Pixels are processed with AVX2 or SSE2 integer math where available.
+		static void Lerp(std::span<const csuint> value1, std::span<const csuint> value2, double amount, std::span<csuint> result);
+		static void Multiply(std::span<const csuint> value, double scale, std::span<csuint> result);
+		//FromNonPremultiplied(r, g, b, a) for each value.
+		static void FromNonPremultiplied(std::span<const csuint> value, std::span<csuint> result);
+		static void AlphaBlend(std::span<const csuint> source, std::span<const csuint> destination, std::span<csuint> result);
+
 		constexpr bool Equals(Color const& other) const {
 			return packedValue == other.packedValue;
 		}
@@ -213,11 +242,11 @@ namespace xna {
 			return Color::Multiply(value, scale);
 		}
 
-		friend constexpr Color operator==(Color const& a, Color const& b) {
+		friend constexpr bool operator==(Color const& a, Color const& b) {
 			return a.Equals(b);
 		}
 
-		friend constexpr Color operator!=(Color const& a, Color const& b) {
+		friend constexpr bool operator!=(Color const& a, Color const& b) {
 			return !a.Equals(b);
 		}
 
@@ -388,6 +417,8 @@ namespace xna {
 		static constexpr Color Yellow() { return Color(4278255615U); }
 		static constexpr Color YellowGreen() { return Color(4281519514U); }
 	};
+
+	static_assert(PackedVector<Color> && sizeof(Color) == 4);
 }
 
 #endif
\ No newline at end of file
@@ -5,23 +5,31 @@
 #include "../csharp/stream/stream.hpp"
 #include "../csharp/stream/reader.hpp"
 #include "../content/lzxdecoder.hpp"
+#include "../content/contentpackage.hpp"
 #include "../csharp/io/path.hpp"
 #include "../titlecontainer.hpp"
+#include "../utilities/atomtable.hpp"
 #include <string>
+#include <algorithm>
 #include <any>
+#include <future>
 #include <map>
+#include <memory_resource>
+#include <string_view>
+#include <unordered_map>
 #include <vector>
 #include <memory>
 
 namespace xna {
 	class ContentReader;
 
-	class ContentManager : std::enable_shared_from_this<ContentManager> {
+	class ContentManager : public std::enable_shared_from_this<ContentManager> {
 	public:
 		ContentManager() {
 		}
 
-		ContentManager(std::string const& rootDirectory) {
+		ContentManager(std::string const& rootDirectory) :
+			RootDirectory(rootDirectory) {
 		}
 
 		static void ReloadGraphicsContent() {
@@ -31,22 +39,57 @@ namespace xna {
 		T LoadLocalized(std::string const& assetName) {
 		}
 
+		//Returns the cached asset when it was already loaded by this manager,
+		//which is also how external references between assets are deduplicated.
 		template <typename T>
 		T Load(std::string const& assetName) {
+			if (assetName.empty())
+				return T();
+
+			return Load<T>(AssetAtom(assetName));
+		}
+
+		//Loads by interned asset name, see AssetAtom. A cached asset then costs
+		//one integer lookup, with no string hashing or allocation.
+		template <typename T>
+		T Load(Atom assetName) {
+			if (assetName == AtomTable::Empty)
+				return T();
+
+			const auto it = loadedAssets.find(assetName);
+
+			if (it != loadedAssets.end()) {
+				if (const auto asset = std::any_cast<T>(&it->second))
+					return *asset;
+			}
+
+			auto result = ReadAsset<T>(std::string(AtomTable::Default().Name(assetName)));
+			loadedAssets.insert_or_assign(assetName, result);
+
+			return result;
+		}
+
+		//Interns assetName in the form assets are cached under, with '/' separators.
+		static Atom AssetAtom(std::string_view assetName) {
+			if (assetName.find('\\') == std::string_view::npos)
+				return AtomTable::Default().Intern(assetName);
+
+			std::string key(assetName);
+			Replace(key, '\\', '/');
+
+			return AtomTable::Default().Intern(key);
 		}
 
 		virtual void Unload() {
 			loadedAssets.clear();
+			prefetched.clear();
 		}
 		
 		virtual void UnloadAsset(std::string const& assetName) {			
 			if (assetName.empty())
 				return;
 
-			if (!loadedAssets.contains(assetName))
-				return;
-
-			loadedAssets.erase(assetName);
+			loadedAssets.erase(AssetAtom(assetName));
 		}
 
 		virtual void UnloadAssets(std::vector<std::string> assetNames) {
@@ -63,23 +106,121 @@ namespace xna {
 			return cs::Path::Combine(TitleContainer::Location(), RootDirectory);
 		}	
 
+		//Starts reading the .xnb files of assetNames in one batch, e.g. everything a
+		//level needs, so the Load calls that follow find their bytes in memory.
+		//Assets already loaded, already prefetched or found in a package are skipped.
+		void Prefetch(std::vector<std::string> const& assetNames) {
+			std::vector<std::string> rootedPaths;
+			std::vector<std::string> relativePaths;
+			std::vector<Atom> rootedAssets;
+			std::vector<Atom> relativeAssets;
+
+			for (auto const& assetName : assetNames) {
+				if (assetName.empty())
+					continue;
+
+				const auto key = AssetAtom(assetName);
+
+				if (loadedAssets.contains(key) || prefetched.contains(key))
+					continue;
+
+				auto const& assetPath = AssetPath(key);
+
+				if (std::any_of(packages.begin(), packages.end(),
+					[&assetPath](auto const& package) { return package->Contains(assetPath); }))
+					continue;
+
+				if (cs::Path::IsPathRooted(assetPath)) {
+					rootedPaths.push_back(assetPath);
+					rootedAssets.push_back(key);
+				}
+				else {
+					relativePaths.push_back(assetPath);
+					relativeAssets.push_back(key);
+				}
+			}
+
+			auto rooted = AsyncIO::Default().ReadFiles(rootedPaths);
+			auto relative = TitleContainer::OpenStreamsAsync(relativePaths);
+
+			for (size_t i = 0; i < rooted.size(); ++i)
+				prefetched.emplace(rootedAssets[i], std::move(rooted[i]));
+
+			for (size_t i = 0; i < relative.size(); ++i)
+				prefetched.emplace(relativeAssets[i], std::move(relative[i]));
+		}
+
+		//Upstream of the per-load arenas that hold transient decode state. Defaults
+		//to the default memory resource at construction.
+		std::pmr::memory_resource* DecodeMemoryResource() const {
+			return decodeMemory;
+		}
+
+		void DecodeMemoryResource(std::pmr::memory_resource* resource) {
+			decodeMemory = resource ? resource : std::pmr::get_default_resource();
+		}
+
+		//Assets found in a package are opened from it instead of the file system.
+		//Packages are searched in the order they were added.
+		void AddPackage(std::shared_ptr<ContentPackage> const& package) {
+			if (package)
+				packages.push_back(package);
+		}
+
 	protected:
 		virtual std::shared_ptr<cs::Stream> OpenStream(std::string const& assetName) {
-			auto assetPath = cs::Path::Combine(RootDirectory, assetName) + ".xnb";
+			const auto key = AssetAtom(assetName);
+			auto const& assetPath = AssetPath(key);
+
+			for (auto const& package : packages) {
+				if (auto stream = package->OpenStream(assetPath))
+					return stream;
+			}
 
-			std::shared_ptr<cs::Stream> stream;
+			const auto prefetch = prefetched.find(key);
+
+			if (prefetch != prefetched.end()) {
+				auto stream = prefetch->second.get();
+				prefetched.erase(prefetch);
+
+				if (stream)
+					return stream;
+			}
 
 			if (cs::Path::IsPathRooted(assetPath)) {
-				//
+				return cs::File::OpenRead(assetPath);
 			}
 
-			return stream;
+			return TitleContainer::OpenStream(assetPath);
 		}
 
 		template <typename T>
 		T ReadAsset(std::string const& assetName); //Usa ContentReader
 
 		virtual std::map<std::string, std::any> LoadedAssets() {
+			std::map<std::string, std::any> assets;
+
+			for (auto const& [assetName, asset] : loadedAssets)
+				assets.emplace(AtomTable::Default().Name(assetName), asset);
+
+			return assets;
+		}
+
+		//The .xnb path of an asset under RootDirectory, built once per asset.
+		std::string const& AssetPath(Atom assetName) {
+			if (assetPathsRoot != RootDirectory) {
+				assetPaths.clear();
+				assetPathsRoot = RootDirectory;
+			}
+
+			auto found = assetPaths.find(assetName);
+
+			if (found == assetPaths.end()) {
+				auto assetPath = cs::Path::Combine(RootDirectory, std::string(AtomTable::Default().Name(assetName))) + ".xnb";
+				found = assetPaths.emplace(assetName, std::move(assetPath)).first;
+			}
+
+			return found->second;
 		}
 
 		virtual void ReloadGraphicsAssets() {
@@ -97,8 +238,8 @@ namespace xna {
 			const auto assetName = originalAssetName;
 			auto stream = OpenStream(assetName);
 
-			auto xnbReader = std::make_shared<cs::BinaryReader>(stream);
-			auto reader = GetContentReaderFromXnb(assetName, stream, nullptr);
+			auto xnbReader = std::make_shared<cs::BinaryReader>(stream, cs::BinaryReader::MinBufferSize);
+			auto reader = GetContentReaderFromXnb(assetName, stream, xnbReader, std::pmr::get_default_resource());
 			
 			reader->ReadAsset<T>(currentAsset);
 
@@ -112,9 +253,18 @@ namespace xna {
 	private:
 		static constexpr csbyte ContentCompressedLzx = 0x80;
 		static constexpr csbyte ContentCompressedLz4 = 0x40;
+		//"XNB", platform, version, flags and the int32 file length.
+		static constexpr csint XnbHeaderSize = 10;
+		//First block of a load arena; it grows geometrically from there.
+		static constexpr size_t DecodeArenaInitialSize = 16 * 1024;
 
 		static std::vector<std::shared_ptr<ContentManager>> ContentManagers;		
-		std::map<std::string, std::any> loadedAssets;
+		std::unordered_map<Atom, std::any> loadedAssets;
+		std::unordered_map<Atom, std::string> assetPaths;
+		std::string assetPathsRoot;
+		std::vector<std::shared_ptr<ContentPackage>> packages;
+		std::unordered_map<Atom, std::future<std::shared_ptr<cs::MemoryStream>>> prefetched;
+		std::pmr::memory_resource* decodeMemory{ std::pmr::get_default_resource() };
 
 		static constexpr std::vector<char> targetPlatformIdentifiers() {
 			return std::vector<char>
@@ -149,7 +299,9 @@ namespace xna {
 		static void RemoveContentManager(std::shared_ptr<ContentManager>& contentManager) {
 		}
 
-		std::shared_ptr<ContentReader> GetContentReaderFromXnb(std::string const& originalAssetName, std::shared_ptr<cs::Stream>& stream, std::shared_ptr<cs::BinaryReader>& xnbReader);
+		//Compressed payloads and the reader itself are allocated from decodeMemory.
+		std::shared_ptr<ContentReader> GetContentReaderFromXnb(std::string const& originalAssetName, std::shared_ptr<cs::Stream>& stream,
+			std::shared_ptr<cs::BinaryReader>& xnbReader, std::pmr::memory_resource* decodeMemory);
 	};
 }
 
@@ -0,0 +1,293 @@
+#include "contentpackage.hpp"
+#include "lz4codec.hpp"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+
+namespace xna {
+	static constexpr csulong FnvOffsetBasis = 14695981039346656037ULL;
+	static constexpr csulong FnvPrime = 1099511628211ULL;
+	static constexpr csulong Lz4MaxExpansion = 255;
+
+	static csulong AlignUp(csulong value, csulong alignment) {
+		return (value + alignment - 1) / alignment * alignment;
+	}
+
+	static bool NameEquals(std::string_view stored, std::string_view name) {
+		if (stored.size() != name.size())
+			return false;
+
+		for (size_t i = 0; i < name.size(); ++i) {
+			const auto c = name[i] == '\\' ? '/' : name[i];
+
+			if (stored[i] != c)
+				return false;
+		}
+
+		return true;
+	}
+
+	csulong ContentPackage::HashName(std::string_view name) {
+		auto hash = FnvOffsetBasis;
+
+		for (const auto c : name) {
+			hash ^= static_cast<csbyte>(c == '\\' ? '/' : c);
+			hash *= FnvPrime;
+		}
+
+		return hash;
+	}
+
+	std::shared_ptr<ContentPackage> ContentPackage::Open(std::string const& path) {
+		auto file = MappedFile::Open(path);
+
+		if (!file)
+			return nullptr;
+
+		const auto data = file->Data();
+
+		if (data.size() < sizeof(ContentPackageHeader))
+			return nullptr;
+
+		ContentPackageHeader header;
+		std::memcpy(&header, data.data(), sizeof(header));
+
+		if (header.Magic != Magic || header.Version != Version)
+			return nullptr;
+
+		const auto entriesSize = static_cast<csulong>(header.EntryCount) * sizeof(ContentPackageEntry);
+
+		if (header.IndexSize < entriesSize || header.IndexSize > data.size() - sizeof(ContentPackageHeader))
+			return nullptr;
+
+		auto package = std::make_shared<ContentPackage>();
+		package->_entries = std::span<const ContentPackageEntry>(
+			reinterpret_cast<ContentPackageEntry const*>(data.data() + sizeof(ContentPackageHeader)), header.EntryCount);
+		package->_names = data.subspan(sizeof(ContentPackageHeader) + entriesSize, header.IndexSize - entriesSize);
+
+		//Everything is checked once here so lookups can trust the index,
+		//including the hash order Find binary searches on.
+		csulong previousHash = 0;
+
+		for (auto const& entry : package->_entries) {
+			if (entry.NameHash < previousHash)
+				return nullptr;
+
+			previousHash = entry.NameHash;
+
+			if (static_cast<csulong>(entry.NameOffset) + entry.NameLength > package->_names.size())
+				return nullptr;
+
+			if (entry.Offset > data.size() || entry.StoredSize > data.size() - entry.Offset)
+				return nullptr;
+
+			//Lz4 expands a byte into at most 255, so a larger Size can only be
+			//corrupt and must not reach the allocation in OpenStream.
+			if (entry.Compression == ContentPackageCompression::Lz4
+				&& (entry.Size > static_cast<csulong>(int_max) || entry.Size > entry.StoredSize * Lz4MaxExpansion))
+				return nullptr;
+		}
+
+		package->_file = file;
+		return package;
+	}
+
+	std::string_view ContentPackage::Name(csint index) const {
+		if (index < 0 || index >= Count())
+			return std::string_view();
+
+		auto const& entry = _entries[index];
+		return std::string_view(reinterpret_cast<char const*>(_names.data()) + entry.NameOffset, entry.NameLength);
+	}
+
+	ContentPackageEntry const* ContentPackage::Find(std::string_view name) const {
+		const auto hash = HashName(name);
+
+		auto it = std::lower_bound(_entries.begin(), _entries.end(), hash,
+			[](ContentPackageEntry const& entry, csulong value) { return entry.NameHash < value; });
+
+		for (; it != _entries.end() && it->NameHash == hash; ++it) {
+			const auto stored = std::string_view(reinterpret_cast<char const*>(_names.data()) + it->NameOffset, it->NameLength);
+
+			if (NameEquals(stored, name))
+				return &*it;
+		}
+
+		return nullptr;
+	}
+
+	std::shared_ptr<cs::Stream> ContentPackage::OpenStream(std::string_view name) const {
+		const auto entry = Find(name);
+
+		if (!entry)
+			return nullptr;
+
+		const auto stored = _file->Data().subspan(entry->Offset, entry->StoredSize);
+
+		switch (entry->Compression) {
+		case ContentPackageCompression::None:
+			return std::make_shared<ContentPackageStream>(_file, stored);
+		case ContentPackageCompression::Lz4: {
+			auto decompressed = std::make_shared<std::vector<csbyte>>(entry->Size);
+
+			const auto size = Lz4Codec::Decompress(stored, *decompressed);
+
+			if (size < 0 || static_cast<csulong>(size) != entry->Size)
+				return nullptr;
+
+			return std::make_shared<ContentPackageStream>(decompressed, *decompressed);
+		}
+		default:
+			return nullptr;
+		}
+	}
+
+	cslong ContentPackageStream::Seek(cslong offset, cs::SeekOrigin origin) {
+		if (!_isOpen)
+			return -1;
+
+		cslong position = 0;
+
+		switch (origin) {
+		case cs::SeekOrigin::Begin:
+			position = offset;
+			break;
+		case cs::SeekOrigin::Current:
+			position = _position + offset;
+			break;
+		case cs::SeekOrigin::End:
+			position = static_cast<cslong>(_data.size()) + offset;
+			break;
+		default:
+			return -1;
+		}
+
+		if (position < 0)
+			return -1;
+
+		_position = position;
+		return _position;
+	}
+
+	csint ContentPackageStream::Read(std::vector<csbyte>& buffer, csint offset, csint count) {
+		if (!_isOpen || offset < 0 || count < 0 || buffer.size() - offset < static_cast<size_t>(count))
+			return -1;
+
+		return Read(std::span<csbyte>(buffer.data() + offset, static_cast<size_t>(count)));
+	}
+
+	csint ContentPackageStream::Read(std::span<csbyte> buffer) {
+		if (!_isOpen)
+			return -1;
+
+		const auto remaining = static_cast<cslong>(_data.size()) - _position;
+
+		if (remaining <= 0)
+			return 0;
+
+		const auto n = remaining < static_cast<cslong>(buffer.size()) ? static_cast<size_t>(remaining) : buffer.size();
+		std::memcpy(buffer.data(), _data.data() + _position, n);
+		_position += static_cast<cslong>(n);
+
+		return static_cast<csint>(n);
+	}
+
+	csint ContentPackageStream::ReadByte() {
+		if (!_isOpen || _position >= static_cast<cslong>(_data.size()))
+			return -1;
+
+		return _data[static_cast<size_t>(_position++)];
+	}
+
+	bool ContentPackageWriter::Add(std::string const& name, std::vector<csbyte> const& data, ContentPackageCompression compression) {
+		if (name.empty() || name.size() > 0xFFFF || compression == ContentPackageCompression::Lzx)
+			return false;
+
+		auto normalized = name;
+		std::replace(normalized.begin(), normalized.end(), '\\', '/');
+
+		for (auto const& pending : _pending) {
+			if (pending.Name == normalized)
+				return false;
+		}
+
+		PendingEntry entry{ normalized, data.size(), ContentPackageCompression::None, data };
+
+		if (compression == ContentPackageCompression::Lz4 && !data.empty()) {
+			std::vector<csbyte> compressed(static_cast<size_t>(Lz4Codec::MaxCompressedSize(static_cast<csint>(data.size()))));
+			const auto size = Lz4Codec::Compress(data, compressed);
+
+			if (size > 0 && static_cast<size_t>(size) < data.size()) {
+				compressed.resize(static_cast<size_t>(size));
+				entry.Compression = ContentPackageCompression::Lz4;
+				entry.Data = std::move(compressed);
+			}
+		}
+
+		_pending.push_back(std::move(entry));
+		return true;
+	}
+
+	bool ContentPackageWriter::Save(std::string const& path) const {
+		std::vector<ContentPackageEntry> entries(_pending.size());
+		std::string names;
+
+		for (size_t i = 0; i < _pending.size(); ++i) {
+			auto& entry = entries[i];
+			entry.NameHash = ContentPackage::HashName(_pending[i].Name);
+			entry.StoredSize = _pending[i].Data.size();
+			entry.Size = _pending[i].Size;
+			entry.NameOffset = static_cast<csuint>(names.size());
+			entry.NameLength = static_cast<csushort>(_pending[i].Name.size());
+			entry.Compression = _pending[i].Compression;
+			entry.Reserved = 0;
+
+			names += _pending[i].Name;
+		}
+
+		ContentPackageHeader header{};
+		header.Magic = ContentPackage::Magic;
+		header.Version = ContentPackage::Version;
+		header.EntryCount = static_cast<csuint>(entries.size());
+		header.Alignment = _alignment;
+		header.IndexSize = entries.size() * sizeof(ContentPackageEntry) + names.size();
+
+		auto offset = AlignUp(sizeof(header) + header.IndexSize, _alignment);
+
+		for (auto& entry : entries) {
+			entry.Offset = offset;
+			offset = AlignUp(offset + entry.StoredSize, _alignment);
+		}
+
+		//Blobs stay in insertion order; only the index is sorted for lookups.
+		std::vector<size_t> order(entries.size());
+
+		for (size_t i = 0; i < order.size(); ++i)
+			order[i] = i;
+
+		std::stable_sort(order.begin(), order.end(),
+			[&entries](size_t a, size_t b) { return entries[a].NameHash < entries[b].NameHash; });
+
+		std::ofstream file(path, std::ios::binary | std::ios::trunc);
+
+		if (!file.is_open())
+			return false;
+
+		file.write(reinterpret_cast<char const*>(&header), sizeof(header));
+
+		for (const auto i : order)
+			file.write(reinterpret_cast<char const*>(&entries[i]), sizeof(ContentPackageEntry));
+
+		file.write(names.data(), static_cast<std::streamsize>(names.size()));
+
+		for (size_t i = 0; i < entries.size(); ++i) {
+			const auto padding = static_cast<csulong>(entries[i].Offset) - static_cast<csulong>(file.tellp());
+			const std::vector<char> zeros(static_cast<size_t>(padding), 0);
+
+			file.write(zeros.data(), static_cast<std::streamsize>(zeros.size()));
+			file.write(reinterpret_cast<char const*>(_pending[i].Data.data()), static_cast<std::streamsize>(_pending[i].Data.size()));
+		}
+
+		return file.good();
+	}
+}
\ No newline at end of file
@@ -0,0 +1,169 @@
+#ifndef XNA_CONTENT_CONTENTPACKAGE_HPP
+#define XNA_CONTENT_CONTENTPACKAGE_HPP
+
+#include <memory>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "../csharp/integralnumeric.hpp"
+#include "../csharp/stream/stream.hpp"
+#include "../utilities/mappedfile.hpp"
+
+//Package layout
+namespace xna {
+	//A content package bundles many .xnb files into one file that is memory mapped
+	//once, so opening an asset is an index lookup instead of a file system call.
+	//
+	//	ContentPackageHeader
+	//	ContentPackageEntry[EntryCount]  sorted by NameHash
+	//	names                            utf-8, not null terminated
+	//	blobs                            each starting at a multiple of Alignment
+	//
+	//All fields are little-endian.
+	enum class ContentPackageCompression : csbyte {
+		None = 0,
+		Lz4 = 1,
+		//Reserved, there is no LZX encoder to produce it.
+		Lzx = 2,
+	};
+
+	struct ContentPackageHeader {
+		csuint Magic;
+		csuint Version;
+		csuint EntryCount;
+		csuint Alignment;
+		csulong IndexSize;
+		csulong Reserved;
+	};
+
+	struct ContentPackageEntry {
+		csulong NameHash;
+		csulong Offset;
+		csulong StoredSize;
+		csulong Size;
+		csuint NameOffset;
+		csushort NameLength;
+		ContentPackageCompression Compression;
+		csbyte Reserved;
+	};
+
+	static_assert(sizeof(ContentPackageHeader) == 32);
+	static_assert(sizeof(ContentPackageEntry) == 40);
+}
+
+//ContentPackage
+namespace xna {
+	class ContentPackage {
+	public:
+		static constexpr csuint Magic = 0x4B415058; //"XPAK"
+		static constexpr csuint Version = 1;
+
+		//Returns nullptr when the file is missing or is not a valid package,
+		//including one whose index is not sorted by NameHash.
+		static std::shared_ptr<ContentPackage> Open(std::string const& path);
+
+		//FNV-1a of the name with '\\' read as '/'.
+		static csulong HashName(std::string_view name);
+
+		bool Contains(std::string_view name) const {
+			return Find(name) != nullptr;
+		}
+
+		csint Count() const {
+			return static_cast<csint>(_entries.size());
+		}
+
+		std::string_view Name(csint index) const;
+
+		//Returns a read-only stream over the entry, or nullptr when it is not
+		//in the package. Uncompressed entries are read straight from the mapping.
+		std::shared_ptr<cs::Stream> OpenStream(std::string_view name) const;
+
+	private:
+		std::shared_ptr<MappedFile> _file;
+		std::span<const ContentPackageEntry> _entries;
+		std::span<const csbyte> _names;
+
+		ContentPackageEntry const* Find(std::string_view name) const;
+	};
+}
+
+//ContentPackageStream
+namespace xna {
+	//Read-only stream over a block of memory kept alive by owner.
+	class ContentPackageStream : public cs::Stream {
+	public:
+		ContentPackageStream(std::shared_ptr<const void> owner, std::span<const csbyte> data) :
+			_owner(owner), _data(data) {
+		}
+
+		virtual bool CanRead() override {
+			return _isOpen;
+		}
+
+		virtual bool CanSeek() override {
+			return _isOpen;
+		}
+
+		virtual cslong Length() override {
+			return _isOpen ? static_cast<cslong>(_data.size()) : -1;
+		}
+
+		virtual cslong Position() override {
+			return _isOpen ? _position : -1;
+		}
+
+		virtual void Position(cslong value) override {
+			if (value >= 0)
+				_position = value;
+		}
+
+		virtual void Close() override {
+			_isOpen = false;
+			_owner = nullptr;
+			_data = std::span<const csbyte>();
+		}
+
+		virtual cslong Seek(cslong offset, cs::SeekOrigin origin) override;
+		virtual csint Read(std::vector<csbyte>& buffer, csint offset, csint count) override;
+		virtual csint Read(std::span<csbyte> buffer) override;
+		virtual csint ReadByte() override;
+
+	private:
+		std::shared_ptr<const void> _owner;
+		std::span<const csbyte> _data;
+		cslong _position{ 0 };
+		bool _isOpen{ true };
+	};
+}
+
+//ContentPackageWriter
+namespace xna {
+	class ContentPackageWriter {
+	public:
+		ContentPackageWriter(csuint alignment = 16) :
+			_alignment(alignment == 0 ? 1 : alignment) {
+		}
+
+		//Lz4 entries that do not shrink are stored uncompressed.
+		//Returns false for a duplicated or unsupported entry.
+		bool Add(std::string const& name, std::vector<csbyte> const& data,
+			ContentPackageCompression compression = ContentPackageCompression::None);
+
+		bool Save(std::string const& path) const;
+
+	private:
+		struct PendingEntry {
+			std::string Name;
+			csulong Size;
+			ContentPackageCompression Compression;
+			std::vector<csbyte> Data;
+		};
+
+		csuint _alignment;
+		std::vector<PendingEntry> _pending;
+	};
+}
+
+#endif
\ No newline at end of file
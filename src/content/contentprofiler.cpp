@@ -0,0 +1,274 @@
+#include "contentprofiler.hpp"
+#include <cstdio>
+#include <fstream>
+#include <mutex>
+
+#ifdef XNA_CONTENT_PROFILE_ALLOCATIONS
+#include <cstdlib>
+#include <new>
+#endif
+
+namespace xna {
+	std::atomic<bool> ContentProfiler::enabled{ false };
+
+	static std::mutex recordsMutex;
+	static std::vector<ContentLoadRecord> records;
+	static std::atomic<cslong> epoch{ 0 };
+	static std::atomic<csulong> nextThreadId{ 1 };
+
+	static thread_local ContentLoadScope* currentScope = nullptr;
+	static thread_local cslong threadAllocations = 0;
+	static thread_local csulong threadId = 0;
+
+	static cslong SteadyNanoseconds() {
+		return std::chrono::duration_cast<std::chrono::nanoseconds>(
+			std::chrono::steady_clock::now().time_since_epoch()).count();
+	}
+
+	static const char* PhaseName(ContentLoadPhase phase) {
+		switch (phase) {
+		case ContentLoadPhase::Open:
+			return "Open";
+		case ContentLoadPhase::Decompress:
+			return "Decompress";
+		case ContentLoadPhase::Read:
+			return "Read";
+		default:
+			return "Unknown";
+		}
+	}
+
+	static void AppendEscaped(std::string& output, std::string const& value) {
+		output += '"';
+
+		for (const auto c : value) {
+			switch (c) {
+			case '"':
+				output += "\\\"";
+				break;
+			case '\\':
+				output += "\\\\";
+				break;
+			default:
+				if (static_cast<unsigned char>(c) < 0x20) {
+					char escaped[8];
+					std::snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+					output += escaped;
+				}
+				else {
+					output += c;
+				}
+			}
+		}
+
+		output += '"';
+	}
+
+	//Nanoseconds as fractional microseconds, the unit both formats use.
+	static void AppendMicroseconds(std::string& output, cslong nanoseconds) {
+		char text[32];
+		std::snprintf(text, sizeof(text), "%.3f", static_cast<double>(nanoseconds) / 1000.0);
+		output += text;
+	}
+
+	static bool WriteText(std::string const& path, std::string const& text) {
+		std::ofstream file(path, std::ios::binary | std::ios::trunc);
+
+		if (!file.is_open())
+			return false;
+
+		file.write(text.data(), static_cast<std::streamsize>(text.size()));
+		return file.good();
+	}
+
+	void ContentProfiler::Enable(bool value) {
+		if (value) {
+			Clear();
+			epoch.store(SteadyNanoseconds(), std::memory_order_relaxed);
+		}
+
+		enabled.store(value, std::memory_order_relaxed);
+	}
+
+	std::vector<ContentLoadRecord> ContentProfiler::Records() {
+		std::lock_guard lock(recordsMutex);
+		return records;
+	}
+
+	void ContentProfiler::Clear() {
+		std::lock_guard lock(recordsMutex);
+		records.clear();
+	}
+
+	cslong ContentProfiler::Now() {
+		return SteadyNanoseconds() - epoch.load(std::memory_order_relaxed);
+	}
+
+	void ContentProfiler::Submit(ContentLoadRecord&& record) {
+		std::lock_guard lock(recordsMutex);
+		records.push_back(std::move(record));
+	}
+
+	void ContentProfiler::AddBytes(cslong bytesIn, cslong bytesOut) {
+		if (!currentScope)
+			return;
+
+		currentScope->record.BytesIn += bytesIn;
+		currentScope->record.BytesOut += bytesOut;
+	}
+
+	std::string ContentProfiler::ToJson() {
+		const auto snapshot = Records();
+		std::string output = "{\"assets\":[";
+
+		for (size_t i = 0; i < snapshot.size(); ++i) {
+			auto const& record = snapshot[i];
+
+			if (i > 0)
+				output += ',';
+
+			output += "\n{\"name\":";
+			AppendEscaped(output, record.AssetName);
+			output += ",\"thread\":" + std::to_string(record.ThreadId);
+			output += ",\"depth\":" + std::to_string(record.Depth);
+			output += ",\"start\":";
+			AppendMicroseconds(output, record.Start);
+			output += ",\"total\":";
+			AppendMicroseconds(output, record.Duration);
+			output += ",\"open\":";
+			AppendMicroseconds(output, record.PhaseTime(ContentLoadPhase::Open));
+			output += ",\"decompress\":";
+			AppendMicroseconds(output, record.PhaseTime(ContentLoadPhase::Decompress));
+			output += ",\"read\":";
+			AppendMicroseconds(output, record.PhaseTime(ContentLoadPhase::Read));
+			output += ",\"bytesIn\":" + std::to_string(record.BytesIn);
+			output += ",\"bytesOut\":" + std::to_string(record.BytesOut);
+			output += ",\"allocations\":" + std::to_string(record.Allocations);
+			output += '}';
+		}
+
+		output += "\n]}\n";
+		return output;
+	}
+
+	std::string ContentProfiler::ToChromeTrace() {
+		const auto snapshot = Records();
+		std::string output = "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+		bool first = true;
+
+		const auto appendEvent = [&output, &first](std::string const& name, const char* category,
+			cslong start, cslong duration, csulong thread) {
+			output += first ? "\n" : ",\n";
+			first = false;
+
+			output += "{\"name\":";
+			AppendEscaped(output, name);
+			output += ",\"cat\":\"";
+			output += category;
+			output += "\",\"ph\":\"X\",\"pid\":1,\"tid\":" + std::to_string(thread) + ",\"ts\":";
+			AppendMicroseconds(output, start);
+			output += ",\"dur\":";
+			AppendMicroseconds(output, duration);
+		};
+
+		for (auto const& record : snapshot) {
+			appendEvent(record.AssetName, "content", record.Start, record.Duration, record.ThreadId);
+			output += ",\"args\":{\"bytesIn\":" + std::to_string(record.BytesIn);
+			output += ",\"bytesOut\":" + std::to_string(record.BytesOut);
+			output += ",\"allocations\":" + std::to_string(record.Allocations) + "}}";
+
+			for (auto const& span : record.Phases) {
+				appendEvent(PhaseName(span.Phase), "content.phase", span.Start, span.Duration, record.ThreadId);
+				output += '}';
+			}
+		}
+
+		output += "\n]}\n";
+		return output;
+	}
+
+	bool ContentProfiler::SaveJson(std::string const& path) {
+		return WriteText(path, ToJson());
+	}
+
+	bool ContentProfiler::SaveChromeTrace(std::string const& path) {
+		return WriteText(path, ToChromeTrace());
+	}
+
+	ContentLoadScope::ContentLoadScope(std::string const& assetName) {
+		if (!ContentProfiler::Enabled())
+			return;
+
+		if (threadId == 0)
+			threadId = nextThreadId.fetch_add(1, std::memory_order_relaxed);
+
+		active = true;
+		parent = currentScope;
+		currentScope = this;
+
+		record.AssetName = assetName;
+		record.ThreadId = threadId;
+		record.Depth = parent ? parent->record.Depth + 1 : 0;
+		//Reserved up front so the profiler's own allocations stay out of the count.
+		record.Phases.reserve(4);
+		allocationsAtStart = threadAllocations;
+		record.Start = ContentProfiler::Now();
+	}
+
+	ContentLoadScope::~ContentLoadScope() {
+		if (!active)
+			return;
+
+		record.Duration = ContentProfiler::Now() - record.Start;
+#ifdef XNA_CONTENT_PROFILE_ALLOCATIONS
+		record.Allocations = threadAllocations - allocationsAtStart;
+#endif
+		currentScope = parent;
+
+		ContentProfiler::Submit(std::move(record));
+	}
+
+	ContentPhaseScope::ContentPhaseScope(ContentLoadPhase phase) :
+		scope(currentScope), phase(phase) {
+		if (!scope)
+			return;
+
+		start = ContentProfiler::Now();
+		outer = scope->phase;
+		scope->phase = this;
+
+		if (outer)
+			scope->record.Phases.push_back({ outer->phase, outer->start, start - outer->start });
+	}
+
+	ContentPhaseScope::~ContentPhaseScope() {
+		if (!scope)
+			return;
+
+		const auto now = ContentProfiler::Now();
+		scope->record.Phases.push_back({ phase, start, now - start });
+		scope->phase = outer;
+
+		if (outer)
+			outer->start = now;
+	}
+}
+
+#ifdef XNA_CONTENT_PROFILE_ALLOCATIONS
+void* operator new(std::size_t size) {
+	++xna::threadAllocations;
+
+	if (void* memory = std::malloc(size == 0 ? 1 : size))
+		return memory;
+
+	throw std::bad_alloc();
+}
+
+void operator delete(void* memory) noexcept {
+	std::free(memory);
+}
+
+void operator delete(void* memory, std::size_t) noexcept {
+	std::free(memory);
+}
+#endif
\ No newline at end of file
@@ -0,0 +1,135 @@
+#ifndef XNA_CONTENT_CONTENTPROFILER_HPP
+#define XNA_CONTENT_CONTENTPROFILER_HPP
+
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <vector>
+#include "../csharp/integralnumeric.hpp"
+
+//Records
+namespace xna {
+	enum class ContentLoadPhase : csbyte {
+		//OpenStream plus the XNB header, not counting Decompress.
+		Open,
+		Decompress,
+		//ContentReader::ReadAsset, including nested external reference loads.
+		Read,
+	};
+
+	struct ContentLoadPhaseSpan {
+		ContentLoadPhase Phase;
+		//Nanoseconds since the profiler was enabled.
+		cslong Start;
+		cslong Duration;
+	};
+
+	struct ContentLoadRecord {
+		std::string AssetName;
+		cslong Start{ 0 };
+		cslong Duration{ 0 };
+		//Size of the .xnb file and of its payload once decompressed.
+		cslong BytesIn{ 0 };
+		cslong BytesOut{ 0 };
+		//-1 unless allocation counting is compiled in, see ContentProfiler.
+		cslong Allocations{ -1 };
+		//Nesting level; external references load at Depth + 1.
+		csint Depth{ 0 };
+		csulong ThreadId{ 0 };
+		std::vector<ContentLoadPhaseSpan> Phases;
+
+		cslong PhaseTime(ContentLoadPhase phase) const {
+			cslong total = 0;
+
+			for (auto const& span : Phases) {
+				if (span.Phase == phase)
+					total += span.Duration;
+			}
+
+			return total;
+		}
+	};
+}
+
+//ContentProfiler
+namespace xna {
+	class ContentPhaseScope;
+
+	//Collects a ContentLoadRecord for every asset ContentManager reads from disk.
+	//While disabled each load costs one relaxed atomic load.
+	//
+	//Allocation counts need XNA_CONTENT_PROFILE_ALLOCATIONS defined when building
+	//contentprofiler.cpp, which replaces the global operator new with a counting one.
+	class ContentProfiler {
+	public:
+		static bool Enabled() {
+			return enabled.load(std::memory_order_relaxed);
+		}
+
+		//Enabling resets the time origin and the collected records.
+		static void Enable(bool value);
+
+		static std::vector<ContentLoadRecord> Records();
+		static void Clear();
+
+		//{"assets":[...]} with one object per record, times in microseconds.
+		static std::string ToJson();
+		//Chrome trace event format, for chrome://tracing or Perfetto.
+		static std::string ToChromeTrace();
+
+		static bool SaveJson(std::string const& path);
+		static bool SaveChromeTrace(std::string const& path);
+
+		//Bytes of the asset being loaded on this thread.
+		static void AddBytes(cslong bytesIn, cslong bytesOut);
+
+	private:
+		friend class ContentLoadScope;
+		friend class ContentPhaseScope;
+
+		static std::atomic<bool> enabled;
+
+		static cslong Now();
+		static void Submit(ContentLoadRecord&& record);
+	};
+
+	//Times one asset load. Does nothing when the profiler is disabled.
+	class ContentLoadScope {
+	public:
+		ContentLoadScope(std::string const& assetName);
+		~ContentLoadScope();
+
+		ContentLoadScope(ContentLoadScope const&) = delete;
+		ContentLoadScope& operator=(ContentLoadScope const&) = delete;
+
+	private:
+		ContentLoadRecord record;
+		ContentLoadScope* parent{ nullptr };
+		ContentPhaseScope* phase{ nullptr };
+		cslong allocationsAtStart{ 0 };
+		bool active{ false };
+
+		friend class ContentProfiler;
+		friend class ContentPhaseScope;
+	};
+
+	//Adds a phase span to the load running on this thread, if any. Phases are
+	//exclusive: a nested phase pauses the enclosing one, which resumes as a new
+	//span once the nested phase ends.
+	class ContentPhaseScope {
+	public:
+		ContentPhaseScope(ContentLoadPhase phase);
+		~ContentPhaseScope();
+
+		ContentPhaseScope(ContentPhaseScope const&) = delete;
+		ContentPhaseScope& operator=(ContentPhaseScope const&) = delete;
+
+	private:
+		ContentLoadScope* scope;
+		ContentPhaseScope* outer{ nullptr };
+		ContentLoadPhase phase;
+		cslong start{ 0 };
+	};
+}
+
+#endif
\ No newline at end of file
@@ -1,14 +1,281 @@
 #include "contentreader.hpp"
+#include "readers.hpp"
+#include "lz4codec.hpp"
+#include <mutex>
 
 namespace xna {
+	ContentTypeReader::~ContentTypeReader() {
+	}
+
 	void ContentTypeReader::Initialize(ContentTypeReaderManager& manager) {
 	}
 
-	std::vector<std::shared_ptr<ContentTypeReader>> ContentTypeReaderManager::LoadAssetReaders(ContentReader& reader) {
-		return std::vector<std::shared_ptr<ContentTypeReader>>();
+	std::shared_mutex ContentTypeReaderManager::_cacheMutex;
+	std::unordered_map<std::string, ContentTypeReaderManager::TypeCreator> ContentTypeReaderManager::_typeCreators;
+	std::unordered_map<Atom, std::shared_ptr<ContentTypeReader>> ContentTypeReaderManager::_readersByName;
+	std::unordered_map<cs::Type, std::shared_ptr<ContentTypeReader>> ContentTypeReaderManager::_contentReadersCache;
+
+	static std::once_flag builtinReadersFlag;
+
+	std::pmr::vector<std::shared_ptr<ContentTypeReader>> ContentTypeReaderManager::LoadAssetReaders(ContentReader& reader) {
+		//Builtins only fill names nobody registered, so creators added before
+		//the first load keep overriding them.
+		std::call_once(builtinReadersFlag, RegisterBuiltinReaders);
+
+		const auto numberOfReaders = reader.Read7BitEncodedInt();
+		std::pmr::vector<std::shared_ptr<ContentTypeReader>> contentReaders(reader.DecodeMemory());
+
+		if (numberOfReaders <= 0)
+			return contentReaders;
+
+		contentReaders.resize(static_cast<size_t>(numberOfReaders));
+
+		//Reader names are assembly qualified and long; the buffer keeps its capacity
+		//across assets, so resolving a known reader allocates nothing.
+		thread_local std::string originalReaderTypeString;
+		std::pmr::vector<std::pair<csint, Atom>> createdReaders(reader.DecodeMemory());
+
+		for (csint i = 0; i < numberOfReaders; ++i) {
+			reader.ReadString(originalReaderTypeString);
+			const auto readerTypeVersion = reader.ReadInt32();
+			const auto readerTypeName = AtomTable::Default().Intern(originalReaderTypeString);
+
+			auto created = false;
+			auto typeReader = ResolveReader(readerTypeName, created);
+
+			//An unknown reader, or one written for another version of it, leaves
+			//the rest of the asset undecodable.
+			if (!typeReader || readerTypeVersion != typeReader->TypeVersion()) {
+				contentReaders.clear();
+				return contentReaders;
+			}
+
+			if (created)
+				createdReaders.emplace_back(i, readerTypeName);
+
+			contentReaders[i] = typeReader;
+			_contentReaders.emplace(typeReader->TargetType(), typeReader);
+		}
+
+		//New readers are initialized once the whole table is known and without the
+		//registry lock, since collection readers look up their element readers
+		//through GetTypeReader here.
+		for (auto const& [index, readerTypeName] : createdReaders) {
+			auto& typeReader = contentReaders[index];
+			typeReader->Initialize(*this);
+
+			typeReader = PublishReader(readerTypeName, typeReader);
+			_contentReaders.insert_or_assign(typeReader->TargetType(), typeReader);
+		}
+
+		return contentReaders;
+	}
+
+	void ContentTypeReaderManager::AddTypeCreator(std::string const& typeString, TypeCreator const& createFunction) {
+		std::unique_lock lock(_cacheMutex);
+		_typeCreators.insert_or_assign(typeString, createFunction);
+
+		//Readers already resolved from the replaced creator would keep winning.
+		_readersByName.clear();
+		_contentReadersCache.clear();
+	}
+
+	void ContentTypeReaderManager::TryAddTypeCreator(std::string const& typeString, TypeCreator const& createFunction) {
+		std::unique_lock lock(_cacheMutex);
+		_typeCreators.try_emplace(typeString, createFunction);
+	}
+
+	void ContentTypeReaderManager::ClearTypeCreators() {
+		{
+			std::unique_lock lock(_cacheMutex);
+			_typeCreators.clear();
+			_readersByName.clear();
+			_contentReadersCache.clear();
+		}
+
+		//The once flag in LoadAssetReaders has already fired, so the builtins
+		//would not come back on their own.
+		RegisterBuiltinReaders();
+	}
+
+	std::shared_ptr<ContentTypeReader> ContentTypeReaderManager::ResolveReader(Atom readerTypeName, bool& created) {
+		created = false;
+
+		{
+			std::shared_lock lock(_cacheMutex);
+			const auto cached = _readersByName.find(readerTypeName);
+
+			if (cached != _readersByName.end())
+				return cached->second;
+		}
+
+		const auto typeName = StripAssemblyName(std::string(AtomTable::Default().Name(readerTypeName)));
+		TypeCreator creator;
+
+		{
+			std::shared_lock lock(_cacheMutex);
+
+			//Another thread may have resolved it while the lock was released.
+			const auto cached = _readersByName.find(readerTypeName);
+
+			if (cached != _readersByName.end())
+				return cached->second;
+
+			const auto found = _typeCreators.find(typeName);
+
+			if (found == _typeCreators.end())
+				return nullptr;
+
+			creator = found->second;
+		}
+
+		//The creator runs unlocked, so it may use the registry itself.
+		auto typeReader = creator();
+		created = typeReader != nullptr;
+
+		return typeReader;
+	}
+
+	std::shared_ptr<ContentTypeReader> ContentTypeReaderManager::PublishReader(Atom readerTypeName, std::shared_ptr<ContentTypeReader> const& typeReader) {
+		std::unique_lock lock(_cacheMutex);
+
+		const auto published = _readersByName.try_emplace(readerTypeName, typeReader).first->second;
+		_contentReadersCache.try_emplace(published->TargetType(), published);
+
+		return published;
+	}
+
+	std::string ContentTypeReaderManager::StripAssemblyName(std::string const& typeName) {
+		std::string result;
+		result.reserve(typeName.size());
+
+		csint depth = 0;
+		csint skipUntilDepth = -1;
+
+		for (const auto c : typeName) {
+			if (c == '[') {
+				++depth;
+			}
+			else if (c == ']') {
+				--depth;
+
+				if (skipUntilDepth >= 0 && depth < skipUntilDepth)
+					skipUntilDepth = -1;
+			}
+			else if (c == ',' && skipUntilDepth < 0 && depth % 2 == 0) {
+				//A comma outside an argument list starts the assembly qualification.
+				if (depth == 0)
+					break;
+
+				skipUntilDepth = depth;
+				continue;
+			}
+
+			if (skipUntilDepth < 0)
+				result += c;
+		}
+
+		while (!result.empty() && result.back() == ' ')
+			result.pop_back();
+
+		return result;
+	}
+
+	using DecodeBuffer = std::pmr::vector<csbyte>;
+
+	//A buffer from memory, shared by the streams that view it. The polymorphic
+	//allocator is handed on to the vector too.
+	static std::shared_ptr<DecodeBuffer> MakeDecodeBuffer(csint size, std::pmr::memory_resource* memory) {
+		return std::allocate_shared<DecodeBuffer>(std::pmr::polymorphic_allocator<>(memory), static_cast<size_t>(size));
+	}
+
+	static std::shared_ptr<cs::MemoryStream> ViewDecodeBuffer(std::shared_ptr<DecodeBuffer> const& buffer, std::pmr::memory_resource* memory) {
+		return std::allocate_shared<cs::MemoryStream>(std::pmr::polymorphic_allocator<>(memory),
+			std::span<const csbyte>(*buffer), buffer);
+	}
+
+	//Reads the compressed section of an XNB into memory.
+	static std::shared_ptr<cs::MemoryStream> ReadPayload(cs::Stream& stream, csint size, std::pmr::memory_resource* memory) {
+		if (size <= 0)
+			return nullptr;
+
+		auto payload = MakeDecodeBuffer(size, memory);
+		size_t n = 0;
+
+		while (n < payload->size()) {
+			const auto read = stream.Read(std::span<csbyte>(*payload).subspan(n));
+
+			if (read <= 0)
+				return nullptr;
+
+			n += static_cast<size_t>(read);
+		}
+
+		return ViewDecodeBuffer(payload, memory);
+	}
+
+	static std::shared_ptr<cs::Stream> DecompressLz4(cs::MemoryStream& payload, csint decompressedSize, std::pmr::memory_resource* memory) {
+		if (decompressedSize < 0)
+			return nullptr;
+
+		auto output = MakeDecodeBuffer(decompressedSize, memory);
+
+		if (Lz4Codec::Decompress(payload.GetView(), *output) != decompressedSize)
+			return nullptr;
+
+		return ViewDecodeBuffer(output, memory);
+	}
+
+	//Walks the XNA LZX framing, as in MonoGame's LzxDecoderStream: each frame is
+	//prefixed by its compressed size and, when it is not 32KB, by its output size.
+	static std::shared_ptr<cs::Stream> DecompressLzx(std::shared_ptr<cs::MemoryStream> const& payload, csint compressedSize, csint decompressedSize,
+		std::pmr::memory_resource* memory) {
+		if (decompressedSize < 0)
+			return nullptr;
+
+		std::shared_ptr<cs::Stream> input = payload;
+		auto buffer = MakeDecodeBuffer(decompressedSize, memory);
+		cs::MemoryStream output{ std::span<csbyte>(*buffer) };
+		LzxDecoder decoder(16);
+		cslong position = 0;
+
+		while (position < compressedSize) {
+			auto hi = input->ReadByte();
+			auto lo = input->ReadByte();
+			auto blockSize = (hi << 8) | lo;
+			auto frameSize = 0x8000;
+
+			if (hi == 0xFF) {
+				hi = lo;
+				lo = input->ReadByte();
+				frameSize = (hi << 8) | lo;
+				hi = input->ReadByte();
+				lo = input->ReadByte();
+				blockSize = (hi << 8) | lo;
+				position += 5;
+			}
+			else {
+				position += 2;
+			}
+
+			if (blockSize == 0 || frameSize == 0)
+				break;
+
+			if (decoder.Decompress(input, blockSize, output, frameSize) != 0)
+				return nullptr;
+
+			position += blockSize;
+			input->Seek(position, cs::SeekOrigin::Begin);
+		}
+
+		if (output.Position() != decompressedSize)
+			return nullptr;
+
+		return ViewDecodeBuffer(buffer, memory);
 	}
 
-	std::shared_ptr<ContentReader> ContentManager::GetContentReaderFromXnb(std::string const& originalAssetName, std::shared_ptr<cs::Stream>& stream, std::shared_ptr<cs::BinaryReader>& xnbReader) {
+	std::shared_ptr<ContentReader> ContentManager::GetContentReaderFromXnb(std::string const& originalAssetName, std::shared_ptr<cs::Stream>& stream,
+		std::shared_ptr<cs::BinaryReader>& xnbReader, std::pmr::memory_resource* decodeMemory) {
 		const auto x = xnbReader->ReadByte();
 		const auto n = xnbReader->ReadByte();
 		const auto b = xnbReader->ReadByte();
@@ -32,28 +299,39 @@ namespace xna {
 		}
 
 		const auto xnbLength = xnbReader->ReadInt32();
+		const auto compressed = compressedLzx || compressedLz4;
+		const auto decompressedSize = compressed ? xnbReader->ReadInt32() : 0;
+
+		//The header reader buffers ahead; hand the stream back at the first payload byte.
+		stream = xnbReader->BaseStream();
 
 		std::shared_ptr<cs::Stream> decompressedStream;
 
-		if (compressedLzx || compressedLz4) {
+		if (compressed) {
+			ContentPhaseScope decompress(ContentLoadPhase::Decompress);
+			ContentProfiler::AddBytes(xnbLength, decompressedSize);
 
-			const auto decompressedSize = xnbReader->ReadInt32();
+			const auto compressedSize = xnbLength - XnbHeaderSize - 4;
+			auto payload = ReadPayload(*stream, compressedSize, decodeMemory);
 
-			if (compressedLzx) {
-				csint compressedSize = xnbLength - 14;
-				//decompressedStream = std::make_shared<LzxDecoderStream>(stream, decompressedSize, compressedSize);
-			}
-			else if (compressedLz4)
-			{
-				//decompressedStream = new Lz4DecoderStream(stream);
-			}
+			if (!payload)
+				return nullptr;
+
+			decompressedStream = compressedLzx
+				? DecompressLzx(payload, compressedSize, decompressedSize, decodeMemory)
+				: DecompressLz4(*payload, decompressedSize, decodeMemory);
+
+			if (!decompressedStream)
+				return nullptr;
 		}
 		else
 		{
+			ContentProfiler::AddBytes(xnbLength, xnbLength - XnbHeaderSize);
 			decompressedStream = stream;
 		}
 
-		auto reader = make_shared<ContentReader>(this->shared_from_this(), decompressedStream, originalAssetName, version);
+		auto reader = std::allocate_shared<ContentReader>(std::pmr::polymorphic_allocator<>(decodeMemory),
+			this->shared_from_this(), decompressedStream, originalAssetName, version, decodeMemory);
 
 		return reader;
 	}
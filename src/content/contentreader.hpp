@@ -5,7 +5,15 @@
 #include <string>
 #include <vector>
 #include <any>
+#include <functional>
 #include <map>
+#include <memory_resource>
+#include <shared_mutex>
+#include <unordered_map>
+#include <bit>
+#include <span>
+#include <cstring>
+#include <type_traits>
 #include "../csharp/integralnumeric.hpp"
 #include "../csharp/stream/stream.hpp"
 #include "../csharp/stream/reader.hpp"
@@ -14,7 +22,40 @@
 #include "../color.hpp"
 #include "../basic-structs.hpp"
 #include "../csharp/type.hpp"
+#include "../utilities/filehelpers.hpp"
+#include "../utilities/atomtable.hpp"
 #include "lzxdecoder.hpp"
+#include "contentprofiler.hpp"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define XNA_CONTENT_SSE2
+#endif
+
+//SharedResource
+namespace xna {
+	//A decoded shared resource, held once and handed to every fixup that references it.
+	struct SharedResource {
+		std::shared_ptr<void> Instance;
+		std::type_index Type{ typeid(void) };
+
+		template <typename T>
+		std::shared_ptr<T> As() const {
+			if (Type == typeid(T))
+				return std::static_pointer_cast<T>(Instance);
+
+			//Resources decoded by readers that only implement the std::any API.
+			if (Type == typeid(std::any)) {
+				auto boxed = std::static_pointer_cast<std::any>(Instance);
+
+				if (auto value = std::any_cast<T>(boxed.get()))
+					return std::shared_ptr<T>(boxed, value);
+			}
+
+			return nullptr;
+		}
+	};
+}
 
 //ContentTypeReader
 namespace xna {
@@ -35,6 +76,17 @@ namespace xna {
 			return existingInstance;
 		}
 
+		//Typed dispatch: reads straight into the object instance points to, which is
+		//of TargetType(). Returns false for readers that only implement the std::any API.
+		virtual bool ReadInPlace(ContentReader& input, void* instance) {
+			return false;
+		}
+
+		//Decodes a shared resource into a new heap instance.
+		virtual SharedResource ReadSharedInstance(ContentReader& input) {
+			return SharedResource{ std::make_shared<std::any>(Read(input, std::any())), typeid(std::any) };
+		}
+
 		virtual void Initialize(ContentTypeReaderManager& manager);
 
 		cs::Type TargetType() const{
@@ -61,130 +113,252 @@ namespace xna {
 			return Read(input, t);
 		}
 
+		//The default reads nothing. Reached from ReadInPlace, it means the
+		//subclass only implements the std::any API, which is then used instead.
 		virtual T Read(ContentReader& input, T& existingInstance) {
+			auto& pending = PendingInstance();
+
+			if (pending == &existingInstance)
+				pending = nullptr;
+
 			return existingInstance;
 		}
+
+		virtual bool ReadInPlace(ContentReader& input, void* instance) override {
+			auto& pending = PendingInstance();
+			const auto outer = pending;
+
+			pending = instance;
+			ReadInPlace(input, *static_cast<T*>(instance));
+
+			const auto handled = pending == instance;
+			pending = outer;
+
+			return handled;
+		}
+
+		//Override to fill large assets in place instead of returning a new T.
+		virtual void ReadInPlace(ContentReader& input, T& instance) {
+			instance = Read(input, instance);
+		}
+
+		virtual SharedResource ReadSharedInstance(ContentReader& input) override {
+			auto instance = std::make_shared<T>();
+
+			if (ReadInPlace(input, static_cast<void*>(instance.get())))
+				return SharedResource{ instance, typeid(T) };
+
+			return ContentTypeReader::ReadSharedInstance(input);
+		}
+
+	private:
+		//The instance the innermost typed ReadInPlace on this thread is filling,
+		//cleared when it reaches the default Read. Nested reads save and restore it.
+		static void const*& PendingInstance() {
+			thread_local void const* pending = nullptr;
+			return pending;
+		}
 	};
 }
 
 //ContentTypeReaderManager
 namespace xna {
+	//Resolves the type readers named in an XNB header. Resolved readers are cached
+	//process-wide by the interned full XNB name, so only the first asset using a
+	//reader pays for parsing the name and creating the reader.
 	class ContentTypeReaderManager {
 	public:
-		ContentTypeReaderManager() = default;
+		using TypeCreator = std::function<std::shared_ptr<ContentTypeReader>()>;
 
-		std::vector<std::shared_ptr<ContentTypeReader>> LoadAssetReaders(ContentReader& reader);
+		ContentTypeReaderManager(std::pmr::memory_resource* resource = std::pmr::get_default_resource()) :
+			_contentReaders(resource) {
+		}
+
+		//The returned list is allocated from reader's decode memory.
+		std::pmr::vector<std::shared_ptr<ContentTypeReader>> LoadAssetReaders(ContentReader& reader);
 
 		std::shared_ptr<ContentTypeReader> GetTypeReader(cs::Type const& targetType) {
-			/*if (_contentReaders.contains(targetType))
-				return _contentReaders[targetType];*/
+			const auto it = _contentReaders.find(targetType);
 
-			return nullptr;
+			if (it != _contentReaders.end())
+				return it->second;
+
+			std::shared_lock lock(_cacheMutex);
+			const auto cached = _contentReadersCache.find(targetType);
+
+			return cached != _contentReadersCache.end() ? cached->second : nullptr;
 		}
 
+		//Registers a reader under its type name without assembly qualification,
+		//e.g. "Microsoft.Xna.Framework.Content.Int32Reader".
+		static void AddTypeCreator(std::string const& typeString, TypeCreator const& createFunction);
+
+		template <typename TReader>
+		static void AddTypeCreator(std::string const& typeString) {
+			AddTypeCreator(typeString, [] { return std::make_shared<TReader>(); });
+		}
+
+		//As AddTypeCreator, but keeps a creator already registered under typeString.
+		static void TryAddTypeCreator(std::string const& typeString, TypeCreator const& createFunction);
+
+		template <typename TReader>
+		static void TryAddTypeCreator(std::string const& typeString) {
+			TryAddTypeCreator(typeString, [] { return std::make_shared<TReader>(); });
+		}
+
+		//Removes every creator and cached reader, then registers the builtin
+		//readers again.
+		static void ClearTypeCreators();
+
+		//Strips the assembly qualification from a type name, including the one of
+		//each generic argument.
+		static std::string StripAssemblyName(std::string const& typeName);
+
 	private:
-		static std::map<cs::Type, std::shared_ptr<ContentTypeReader>> _contentReadersCache;
-		std::map<cs::Type, std::shared_ptr<ContentTypeReader>> _contentReaders;
+		//Resolves an interned reader name as written in the XNB, assembly qualification
+		//included. A reader that is not cached yet comes back new, uninitialized and
+		//unpublished, with created set.
+		static std::shared_ptr<ContentTypeReader> ResolveReader(Atom readerTypeName, bool& created);
+
+		//Caches an initialized reader, returning the one already cached under
+		//readerTypeName if another thread published it first.
+		static std::shared_ptr<ContentTypeReader> PublishReader(Atom readerTypeName, std::shared_ptr<ContentTypeReader> const& typeReader);
+
+		static std::shared_mutex _cacheMutex;
+		static std::unordered_map<std::string, TypeCreator> _typeCreators;
+		static std::unordered_map<Atom, std::shared_ptr<ContentTypeReader>> _readersByName;
+		static std::unordered_map<cs::Type, std::shared_ptr<ContentTypeReader>> _contentReadersCache;
+		std::pmr::unordered_map<cs::Type, std::shared_ptr<ContentTypeReader>> _contentReaders;
 	};	
 }
 
 //ContentReader
 namespace xna {
-	class ContentReader : public cs::BinaryReader {
+	//Sealed, as in XNA, so its own ReadString and varint calls are not virtual.
+	class ContentReader final : public cs::BinaryReader {
 	public:
-		ContentReader(std::shared_ptr<ContentManager> manager, std::shared_ptr <cs::Stream> stream, std::string assetName, csint version) :
+		//Decode state (buffer, reader table, fixups) is allocated from resource.
+		ContentReader(std::shared_ptr<ContentManager> manager, std::shared_ptr <cs::Stream> stream, std::string assetName, csint version,
+			std::pmr::memory_resource* resource = std::pmr::get_default_resource()) :
+			BinaryReader(stream, DefaultBufferSize, resource),
 			contentManager(manager),
 			assetName(assetName),
 			version(version),
-			BinaryReader(stream) {
+			resource(resource),
+			typeReaders(resource),
+			sharedResourceFixups(resource) {
+		}
+
+		//Memory for transient decode state, e.g. scratch buffers of type readers.
+		//It is released when the load finishes, so the asset must not keep anything
+		//allocated from it.
+		std::pmr::memory_resource* DecodeMemory() const {
+			return resource;
 		}
 
 		template <typename T>
 		T ReadAsset() {
 			InitializeTypeReaders();
+
+			T result = T();
+			InnerReadObject(result);
+			ReadSharedResources();
+			return result;
 		}
 
 		template <typename T>
 		T ReadAsset(T& existingInstance) {
 			InitializeTypeReaders();
-			return ReadObject(existingInstance);
+			InnerReadObject(existingInstance);
+			ReadSharedResources();
+			return existingInstance;
 		}
 
 		void InitializeTypeReaders() {
-			typeReaderManager = std::make_shared<ContentTypeReaderManager>();
+			typeReaderManager = std::allocate_shared<ContentTypeReaderManager>(std::pmr::polymorphic_allocator<>(resource), resource);
 			typeReaders = typeReaderManager->LoadAssetReaders(*this);
 			sharedResourceCount = Read7BitEncodedInt();
 		}
 
+		//Loads the referenced asset through the ContentManager, so assets referenced
+		//from many places are decoded once and then served from its cache.
 		template <typename T>
 		T ReadExternalReference() {
-			auto externalReference = ReadString();
+			const auto externalReference = ReadString();
 
-			if (externalReference.empty())
-				//return contentManager.Load<T>(FileHelpers.ResolveRelativePath(assetName, externalReference));
+			if (externalReference.empty() || !contentManager)
 				return T();
 
-			return T();
+			return contentManager->Load<T>(FileHelpers::ResolveRelativePath(assetName, externalReference));
+		}
+
+		//Reads a shared resource index. The fixup runs once all shared resources
+		//of the asset have been decoded, after the main object.
+		template <typename T>
+		void ReadSharedResource(std::function<void(std::shared_ptr<T>)> fixup) {
+			const auto index = Read7BitEncodedInt();
+
+			if (index <= 0)
+				return;
+
+			sharedResourceFixups.emplace_back(index - 1, [fixup](SharedResource const& resource) {
+				if (auto instance = resource.template As<T>())
+					fixup(instance);
+			});
 		}
 
 		template <typename T>
 		T ReadObject() {
-			auto t = T();
-			return InnerReadObject(t);
+			T result = T();
+			InnerReadObject(result);
+			return result;
 		}
 
 		template <typename T>
 		T ReadObject(ContentTypeReader& typeReader) {
-			auto defaultT = T();
-			auto result = typeReader.Read(*this, defaultT);
+			T result = T();
+			ReadWith(typeReader, result);
 			return result;
 		}
 
 		template <typename T>
 		T ReadObject(T& existingInstance) {
-			return InnerReadObject(existingInstance);
+			InnerReadObject(existingInstance);
+			return existingInstance;
 		}
 
 		template <typename T>
 		T ReadObject(ContentTypeReader& typeReader, T& existingInstance) {
-			auto result = std::any_cast<T>(typeReader.Read(*this, existingInstance));
-			return result;
+			ReadWith(typeReader, existingInstance);
+			return existingInstance;
 		}
 
+		//Reads the type reader index and decodes the object into existingInstance.
 		template <typename T>
-		T InnerReadObject(T& existingInstance) {
-			auto typeReaderIndex = Read7BitEncodedInt();
-
-			if (typeReaderIndex == 0)
-				return existingInstance;
-
-			if (typeReaderIndex > typeReaders.size())
-				return existingInstance;
+		bool InnerReadObject(T& existingInstance) {
+			const auto typeReaderIndex = Read7BitEncodedInt();
 
-			auto& typeReader = typeReaders[typeReaderIndex - 1];
-			auto& result = std::any_cast<T>(typeReader->Read(*this, existingInstance));
+			if (typeReaderIndex <= 0 || typeReaderIndex > toint(typeReaders.size()))
+				return false;
 
-			return result;
-		}		
+			return ReadWith(*typeReaders[typeReaderIndex - 1], existingInstance);
+		}
 
 		template <typename T>
 		T ReadRawObject() {
-			auto t = T();
-			auto result = ReadRawObject(t);
+			T result = T();
+			ReadRawObject(result);
 			return result;
 		}
 
 		template <typename T>
 		T ReadRawObject(T& existingInstance) {
-			cs::Type objectType = cs::typeof<T>();
-			const auto size = typeReaders.size();
+			const std::type_index objectType = typeid(T);
 
-			for (size_t i = 0; i < size; ++i) {
-				auto& typeReader = typeReaders[i];
-
-				if (typeReader->TargetType() == objectType) {
-					auto result = ReadRawObject(typeReader, existingInstance);
-					return result;
+			for (auto& typeReader : typeReaders) {
+				if (typeReader->TargetType().TypeIndex() == objectType) {
+					ReadWith(*typeReader, existingInstance);
+					break;
 				}
 			}
 
@@ -193,8 +367,30 @@ namespace xna {
 
 		template <typename T>
 		T ReadRawObject(ContentTypeReader& typeReader, T& existingInstance) {
-			auto result = std::any_cast<T>(typeReader.Read(*this, existingInstance));
-			return result;
+			ReadWith(typeReader, existingInstance);
+			return existingInstance;
+		}
+
+		//Decodes into instance without boxing it. Readers that only override the
+		//std::any API still work, through a boxed round trip.
+		template <typename T>
+		bool ReadWith(ContentTypeReader& typeReader, T& instance) {
+			const auto targetType = typeReader.TargetType().TypeIndex();
+
+			if (targetType != typeid(T) && targetType != typeid(void))
+				return false;
+
+			if (typeReader.ReadInPlace(*this, &instance))
+				return true;
+
+			auto result = typeReader.Read(*this, std::any(instance));
+			auto value = std::any_cast<T>(&result);
+
+			if (!value)
+				return false;
+
+			instance = std::move(*value);
+			return true;
 		}
 
 		constexpr Matrix ReadMatrix() {
@@ -266,16 +462,172 @@ namespace xna {
 			return BoundingSphere(position, radius);
 		}
 
+		//Bulk readers: decode destination.size() elements in one pass straight from the
+		//reader buffer. They return how many elements were completely read.
+
+		csint ReadVector2Array(std::span<Vector2> destination) {
+			return ReadSingleArray<decltype(Vector2::X), 2>(destination);
+		}
+
+		csint ReadVector3Array(std::span<Vector3> destination) {
+			return ReadSingleArray<decltype(Vector3::X), 3>(destination);
+		}
+
+		csint ReadVector4Array(std::span<Vector4> destination) {
+			return ReadSingleArray<decltype(Vector4::X), 4>(destination);
+		}
+
+		csint ReadQuaternionArray(std::span<Quaternion> destination) {
+			return ReadSingleArray<decltype(Quaternion::X), 4>(destination);
+		}
+
+		csint ReadMatrixArray(std::span<Matrix> destination) {
+			return ReadSingleArray<decltype(Matrix::M11), 16>(destination);
+		}
+
+		//Copies the raw little-endian bytes of destination.size() elements,
+		//e.g. index buffers or already packed vertex data.
+		template <typename T>
+		csint ReadRaw(std::span<T> destination) {
+			static_assert(std::is_trivially_copyable_v<T>);
+
+			const auto bytes = AsBytes(destination);
+			const auto count = Read(bytes) / toint(sizeof(T));
+
+			if constexpr (std::endian::native == std::endian::big && sizeof(T) > 1) {
+				static_assert(std::is_arithmetic_v<T>, "ReadRaw on big-endian hosts only handles arithmetic types");
+
+				for (csint i = 0; i < count; ++i)
+					std::reverse(bytes.begin() + i * sizeof(T), bytes.begin() + (i + 1) * sizeof(T));
+			}
+
+			return count;
+		}
+
 	private:
 		std::shared_ptr<ContentManager> contentManager;
 		std::shared_ptr<ContentTypeReaderManager> typeReaderManager;
 		std::string assetName;
-		std::vector<std::shared_ptr<ContentTypeReader>> typeReaders;
 		csint version{ 0 };
+		std::pmr::memory_resource* resource;
+		std::pmr::vector<std::shared_ptr<ContentTypeReader>> typeReaders;
 		csint sharedResourceCount{ 0 };
+		std::pmr::vector<std::pair<csint, std::function<void(SharedResource const&)>>> sharedResourceFixups;
+
+		void ReadSharedResources() {
+			if (sharedResourceCount <= 0)
+				return;
+
+			std::pmr::vector<SharedResource> sharedResources(static_cast<size_t>(sharedResourceCount), resource);
+
+			for (auto& resource : sharedResources) {
+				const auto typeReaderIndex = Read7BitEncodedInt();
+
+				if (typeReaderIndex <= 0 || typeReaderIndex > toint(typeReaders.size()))
+					continue;
+
+				resource = typeReaders[typeReaderIndex - 1]->ReadSharedInstance(*this);
+			}
+
+			for (auto& [index, fixup] : sharedResourceFixups) {
+				if (index < sharedResourceCount)
+					fixup(sharedResources[index]);
+			}
+
+			sharedResourceFixups.clear();
+		}
+
+		//Reads Components singles per element into structs made only of TComponent fields.
+		template <typename TComponent, size_t Components, typename T>
+		csint ReadSingleArray(std::span<T> destination) {
+			static_assert(std::is_standard_layout_v<T> && sizeof(T) == Components * sizeof(TComponent));
+
+			auto components = reinterpret_cast<TComponent*>(destination.data());
+			const auto elementSize = toint(Components * sizeof(float));
+			const auto count = toint(destination.size()) * elementSize;
+
+			if constexpr (std::endian::native != std::endian::little) {
+				for (size_t i = 0; i < destination.size() * Components; ++i)
+					components[i] = ReadSingle();
+
+				return toint(destination.size());
+			}
+			else if constexpr (std::is_same_v<TComponent, float>) {
+				//Float math types match the file layout, no conversion needed.
+				return Read(AsBytes(destination)) / elementSize;
+			}
+			else {
+				const auto bytes = ReadChunks(count, elementSize, [&components](std::span<const csbyte> chunk) {
+					const auto singles = chunk.size() / sizeof(float);
+					WidenSingles(chunk.data(), components, singles);
+					components += singles;
+				});
+
+				return bytes / elementSize;
+			}
+		}
+
+		template <typename T>
+		static std::span<csbyte> AsBytes(std::span<T> values) {
+			return std::span<csbyte>(reinterpret_cast<csbyte*>(values.data()), values.size_bytes());
+		}
+
+		static void WidenSingles(csbyte const* source, double* destination, size_t count) {
+			size_t i = 0;
+#ifdef XNA_CONTENT_SSE2
+			for (; i + 4 <= count; i += 4) {
+				const auto singles = _mm_loadu_ps(reinterpret_cast<float const*>(source + i * sizeof(float)));
+				_mm_storeu_pd(destination + i, _mm_cvtps_pd(singles));
+				_mm_storeu_pd(destination + i + 2, _mm_cvtps_pd(_mm_movehl_ps(singles, singles)));
+			}
+#endif
+			for (; i < count; ++i) {
+				float value;
+				std::memcpy(&value, source + i * sizeof(float), sizeof(float));
+				destination[i] = value;
+			}
+		}
 	};	
 }
 
+//ContentManager
+namespace xna {
+	template <typename T>
+	T ContentManager::ReadAsset(std::string const& assetName) {
+		ContentLoadScope profile(assetName);
+
+		//Transient decode state is drawn from this arena and released in one go
+		//once the asset is read; it is declared first so it goes last.
+		std::pmr::monotonic_buffer_resource arena(DecodeArenaInitialSize, decodeMemory);
+		std::shared_ptr<cs::Stream> stream;
+		std::shared_ptr<ContentReader> reader;
+
+		{
+			ContentPhaseScope open(ContentLoadPhase::Open);
+			stream = OpenStream(assetName);
+
+			if (!stream)
+				return T();
+
+			//The header is at most 14 bytes; a minimal buffer avoids reading ahead.
+			auto xnbReader = std::allocate_shared<cs::BinaryReader>(std::pmr::polymorphic_allocator<>(&arena),
+				stream, cs::BinaryReader::MinBufferSize, &arena);
+			reader = GetContentReaderFromXnb(assetName, stream, xnbReader, &arena);
+		}
+
+		if (!reader) {
+			stream->Close();
+			return T();
+		}
+
+		ContentPhaseScope read(ContentLoadPhase::Read);
+		auto result = reader->ReadAsset<T>();
 
+		reader->Close();
+		stream->Close();
+
+		return result;
+	}
+}
 
 #endif
\ No newline at end of file
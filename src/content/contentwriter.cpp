@@ -0,0 +1,239 @@
+#include "contentwriter.hpp"
+#include "writers.hpp"
+#include "lz4codec.hpp"
+#include "lzxdecoder.hpp"
+#include "../csharp/io/file.hpp"
+#include <mutex>
+
+namespace xna {
+	std::shared_mutex ContentWriter::_writersMutex;
+	std::unordered_map<std::type_index, std::shared_ptr<ContentTypeWriter>> ContentWriter::_typeWriters;
+
+	static std::once_flag builtinWritersFlag;
+
+	void ContentWriter::AddTypeWriter(std::shared_ptr<ContentTypeWriter> const& typeWriter) {
+		std::unique_lock lock(_writersMutex);
+		_typeWriters.insert_or_assign(typeWriter->TargetType().TypeIndex(), typeWriter);
+	}
+
+	void ContentWriter::TryAddTypeWriter(std::shared_ptr<ContentTypeWriter> const& typeWriter) {
+		std::unique_lock lock(_writersMutex);
+		_typeWriters.try_emplace(typeWriter->TargetType().TypeIndex(), typeWriter);
+	}
+
+	void ContentWriter::ClearTypeWriters() {
+		{
+			std::unique_lock lock(_writersMutex);
+			_typeWriters.clear();
+		}
+
+		//The once flag in GetTypeWriter has already fired, so the builtins
+		//would not come back on their own.
+		RegisterBuiltinWriters();
+	}
+
+	std::shared_ptr<ContentTypeWriter> ContentWriter::GetTypeWriter(std::type_index const& targetType) {
+		//Builtins only fill types nobody registered, so writers added before
+		//the first write keep overriding them.
+		std::call_once(builtinWritersFlag, RegisterBuiltinWriters);
+
+		std::shared_lock lock(_writersMutex);
+		const auto found = _typeWriters.find(targetType);
+
+		return found != _typeWriters.end() ? found->second : nullptr;
+	}
+
+	csint ContentWriter::GetTypeWriterIndex(std::type_index const& targetType) {
+		const auto found = typeWriterIndices.find(targetType);
+
+		if (found != typeWriterIndices.end())
+			return found->second;
+
+		auto typeWriter = GetTypeWriter(targetType);
+
+		if (!typeWriter)
+			return -1;
+
+		const auto index = toint(typeWriters.size());
+		typeWriters.push_back(typeWriter);
+		typeWriterIndices.emplace(targetType, index);
+
+		return index;
+	}
+
+	void ContentWriter::WriteSharedResources() {
+		//Writing a resource may queue further resources at the end of the list.
+		for (size_t i = 0; i < sharedResources.size(); ++i) {
+			const auto entry = sharedResources[i];
+
+			Write7BitEncodedInt(entry.TypeWriterIndex + 1);
+			typeWriters[entry.TypeWriterIndex]->Write(*this, entry.Resource.get());
+		}
+	}
+
+	std::vector<csbyte> XnbWriter::Assemble(ContentWriter& writer, cs::MemoryStream& content) const {
+		auto body = std::make_shared<cs::MemoryStream>();
+
+		{
+			cs::BinaryWriter output(body);
+
+			output.Write7BitEncodedInt(toint(writer.TypeWriters().size()));
+
+			for (auto const& typeWriter : writer.TypeWriters()) {
+				output.Write(typeWriter->GetRuntimeReader());
+				output.Write(typeWriter->TypeVersion());
+			}
+
+			output.Write7BitEncodedInt(writer.SharedResourceCount());
+			output.Write(content.GetView());
+		}
+
+		const auto decompressed = body->GetView();
+		std::vector<csbyte> compressed;
+
+		switch (compression) {
+		case XnbCompression::Lz4: {
+			compressed.resize(static_cast<size_t>(Lz4Codec::MaxCompressedSize(toint(decompressed.size()))));
+			const auto size = Lz4Codec::Compress(decompressed, compressed);
+
+			if (size < 0)
+				return std::vector<csbyte>();
+
+			compressed.resize(static_cast<size_t>(size));
+			break;
+		}
+		case XnbCompression::Lzx:
+			compressed = LzxStore(decompressed);
+			break;
+		default:
+			break;
+		}
+
+		const auto isCompressed = compression != XnbCompression::None;
+		const auto payload = isCompressed ? std::span<const csbyte>(compressed) : decompressed;
+		const auto headerSize = isCompressed ? 14 : 10;
+
+		csbyte flags = hiDef ? HiDefProfile : 0;
+
+		if (compression == XnbCompression::Lz4)
+			flags |= 0x40;
+		else if (compression == XnbCompression::Lzx)
+			flags |= 0x80;
+
+		auto xnb = std::make_shared<cs::MemoryStream>(headerSize + toint(payload.size()));
+
+		{
+			cs::BinaryWriter output(xnb);
+
+			output.Write(static_cast<csbyte>('X'));
+			output.Write(static_cast<csbyte>('N'));
+			output.Write(static_cast<csbyte>('B'));
+			output.Write(static_cast<csbyte>(targetPlatform));
+			output.Write(XnbVersion);
+			output.Write(flags);
+			output.Write(headerSize + toint(payload.size()));
+
+			if (isCompressed)
+				output.Write(toint(decompressed.size()));
+
+			output.Write(payload);
+		}
+
+		return xnb->ToArray();
+	}
+
+	bool XnbWriter::SaveFile(std::string const& path, std::vector<csbyte> const& xnb) {
+		auto file = cs::File::Create(path);
+
+		if (!file)
+			return false;
+
+		file->Write(std::span<const csbyte>(xnb));
+		file->Close();
+
+		return true;
+	}
+
+	//Writes bits most significant first into 16-bit little-endian words,
+	//the order LzxDecoder's BitBuffer reads them in.
+	struct LzxBitWriter {
+		std::vector<csbyte>& output;
+		csuint buffer{ 0 };
+		csint bits{ 0 };
+
+		void WriteBits(csuint value, csint count) {
+			buffer = (buffer << count) | (value & ((1u << count) - 1));
+			bits += count;
+
+			while (bits >= 16) {
+				bits -= 16;
+				WriteWord(static_cast<csushort>(buffer >> bits));
+			}
+		}
+
+		//Pads to the next word. Like LZX, an already aligned stream gets a whole
+		//padding word, which the decoder skips before the uncompressed block data.
+		void Align() {
+			WriteBits(0, 16 - bits);
+		}
+
+		void WriteWord(csushort word) {
+			output.push_back(static_cast<csbyte>(word));
+			output.push_back(static_cast<csbyte>(word >> 8));
+		}
+	};
+
+	std::vector<csbyte> LzxStore(std::span<const csbyte> data) {
+		//XNA frames hold 32KB of output each.
+		constexpr size_t FrameSize = 0x8000;
+
+		std::vector<csbyte> output;
+		output.reserve(data.size() + (data.size() / FrameSize + 1) * 24);
+
+		std::vector<csbyte> block;
+		block.reserve(FrameSize + 20);
+
+		for (size_t offset = 0; offset < data.size(); offset += FrameSize) {
+			const auto frame = data.subspan(offset, std::min(FrameSize, data.size() - offset));
+
+			block.clear();
+			LzxBitWriter bits{ block };
+
+			//The first frame starts with the E8 translation flag, which stays off.
+			if (offset == 0)
+				bits.WriteBits(0, 1);
+
+			bits.WriteBits(static_cast<csuint>(LzxConstants::BLOCKTYPE::UNCOMPRESSED), 3);
+			bits.WriteBits(static_cast<csuint>(frame.size() >> 8), 16);
+			bits.WriteBits(static_cast<csuint>(frame.size() & 0xFF), 8);
+			bits.Align();
+
+			//Repeated match offsets R0, R1 and R2.
+			for (csint i = 0; i < 3; ++i) {
+				bits.WriteWord(1);
+				bits.WriteWord(0);
+			}
+
+			block.insert(block.end(), frame.begin(), frame.end());
+
+			if ((frame.size() & 1) != 0)
+				block.push_back(0);
+
+			if (frame.size() == FrameSize) {
+				output.push_back(static_cast<csbyte>(block.size() >> 8));
+				output.push_back(static_cast<csbyte>(block.size()));
+			}
+			else {
+				output.push_back(0xFF);
+				output.push_back(static_cast<csbyte>(frame.size() >> 8));
+				output.push_back(static_cast<csbyte>(frame.size()));
+				output.push_back(static_cast<csbyte>(block.size() >> 8));
+				output.push_back(static_cast<csbyte>(block.size()));
+			}
+
+			output.insert(output.end(), block.begin(), block.end());
+		}
+
+		return output;
+	}
+}
\ No newline at end of file
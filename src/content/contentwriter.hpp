@@ -0,0 +1,316 @@
+#ifndef XNA_CONTENT_CONTENTWRITER_HPP
+#define XNA_CONTENT_CONTENTWRITER_HPP
+
+#include <memory>
+#include <string>
+#include <vector>
+#include <functional>
+#include <shared_mutex>
+#include <typeindex>
+#include <unordered_map>
+#include "../csharp/integralnumeric.hpp"
+#include "../csharp/stream/stream.hpp"
+#include "../csharp/stream/writer.hpp"
+#include "../csharp/type.hpp"
+#include "../collision.hpp"
+#include "../color.hpp"
+#include "../basic-structs.hpp"
+
+//ContentTypeWriter
+namespace xna {
+	class ContentWriter;
+
+	//Compile-time counterpart of ContentTypeReader: serializes one type and names
+	//the reader that decodes it at runtime.
+	class ContentTypeWriter {
+	public:
+		ContentTypeWriter(cs::Type const& targetType) :
+			_targetType(targetType) {
+		}
+
+		virtual ~ContentTypeWriter() = default;
+
+		//Reader type name written to the XNB reader table, e.g.
+		//"Microsoft.Xna.Framework.Content.Int32Reader".
+		virtual std::string GetRuntimeReader() const = 0;
+
+		virtual void Write(ContentWriter& output, void const* value) = 0;
+
+		cs::Type TargetType() const {
+			return _targetType;
+		}
+
+		virtual csint TypeVersion() const {
+			return 0;
+		}
+
+	private:
+		cs::Type _targetType;
+	};
+
+	template<typename T>
+	class ContentTypeWriterT : public ContentTypeWriter {
+	public:
+		ContentTypeWriterT() :
+			ContentTypeWriter(cs::typeof<T>()) {
+		}
+
+		virtual void Write(ContentWriter& output, void const* value) override {
+			Write(output, *static_cast<T const*>(value));
+		}
+
+		virtual void Write(ContentWriter& output, T const& value) = 0;
+	};
+}
+
+//ContentWriter
+namespace xna {
+	//Writes the content section of an XNB: the main object followed by its
+	//shared resources. The reader table it collects on the way is emitted
+	//by XnbWriter in front of that section.
+	class ContentWriter : public cs::BinaryWriter {
+	public:
+		ContentWriter(std::shared_ptr<cs::Stream> stream) :
+			BinaryWriter(stream) {
+		}
+
+		//Registers a writer for its target type, replacing any previous one.
+		static void AddTypeWriter(std::shared_ptr<ContentTypeWriter> const& typeWriter);
+
+		template <typename TWriter>
+		static void AddTypeWriter() {
+			AddTypeWriter(std::make_shared<TWriter>());
+		}
+
+		//As AddTypeWriter, but keeps a writer already registered for the target type.
+		static void TryAddTypeWriter(std::shared_ptr<ContentTypeWriter> const& typeWriter);
+
+		template <typename TWriter>
+		static void TryAddTypeWriter() {
+			TryAddTypeWriter(std::make_shared<TWriter>());
+		}
+
+		//Removes every writer, then registers the builtin writers again.
+		static void ClearTypeWriters();
+
+		static std::shared_ptr<ContentTypeWriter> GetTypeWriter(std::type_index const& targetType);
+
+		//Writes the type writer index followed by the object. Returns false when
+		//no writer is registered for T.
+		template <typename T>
+		bool WriteObject(T const& value) {
+			const auto index = GetTypeWriterIndex(typeid(T));
+
+			if (index < 0)
+				return false;
+
+			Write7BitEncodedInt(index + 1);
+			typeWriters[index]->Write(*this, &value);
+			return true;
+		}
+
+		//A null object is written as type writer index zero.
+		template <typename T>
+		bool WriteObject(std::shared_ptr<T> const& value) {
+			if (!value) {
+				Write7BitEncodedInt(0);
+				return true;
+			}
+
+			return WriteObject(*value);
+		}
+
+		//Writes the object without a type writer index; the reader has to know its type.
+		template <typename T>
+		bool WriteRawObject(T const& value) {
+			const auto index = GetTypeWriterIndex(typeid(T));
+
+			if (index < 0)
+				return false;
+
+			typeWriters[index]->Write(*this, &value);
+			return true;
+		}
+
+		//Writes the 1-based index of resource in the shared resource table, adding it
+		//the first time it is seen. The resource itself is written after the main object.
+		template <typename T>
+		bool WriteSharedResource(std::shared_ptr<T> const& resource) {
+			if (!resource) {
+				Write7BitEncodedInt(0);
+				return true;
+			}
+
+			const auto found = sharedResourceIndices.find(resource.get());
+
+			if (found != sharedResourceIndices.end()) {
+				Write7BitEncodedInt(found->second + 1);
+				return true;
+			}
+
+			const auto index = GetTypeWriterIndex(typeid(T));
+
+			if (index < 0)
+				return false;
+
+			const auto resourceIndex = toint(sharedResources.size());
+			sharedResourceIndices.emplace(resource.get(), resourceIndex);
+			sharedResources.push_back(SharedResourceEntry{ resource, index });
+
+			Write7BitEncodedInt(resourceIndex + 1);
+			return true;
+		}
+
+		//Writes the name of another asset, relative to the content root. An empty
+		//name stands for a null reference.
+		void WriteExternalReference(std::string const& assetName) {
+			Write(assetName);
+		}
+
+		//Writes the queued shared resources, including the ones they add themselves.
+		void WriteSharedResources();
+
+		csint SharedResourceCount() const {
+			return toint(sharedResources.size());
+		}
+
+		std::vector<std::shared_ptr<ContentTypeWriter>> const& TypeWriters() const {
+			return typeWriters;
+		}
+
+		void WriteVector2(Vector2 const& value) {
+			Write(static_cast<float>(value.X));
+			Write(static_cast<float>(value.Y));
+		}
+
+		void WriteVector3(Vector3 const& value) {
+			Write(static_cast<float>(value.X));
+			Write(static_cast<float>(value.Y));
+			Write(static_cast<float>(value.Z));
+		}
+
+		void WriteVector4(Vector4 const& value) {
+			Write(static_cast<float>(value.X));
+			Write(static_cast<float>(value.Y));
+			Write(static_cast<float>(value.Z));
+			Write(static_cast<float>(value.W));
+		}
+
+		void WriteQuaternion(Quaternion const& value) {
+			Write(static_cast<float>(value.X));
+			Write(static_cast<float>(value.Y));
+			Write(static_cast<float>(value.Z));
+			Write(static_cast<float>(value.W));
+		}
+
+		void WriteMatrix(Matrix const& value) {
+			const double m[] = {
+				value.M11, value.M12, value.M13, value.M14,
+				value.M21, value.M22, value.M23, value.M24,
+				value.M31, value.M32, value.M33, value.M34,
+				value.M41, value.M42, value.M43, value.M44 };
+
+			for (const auto component : m)
+				Write(static_cast<float>(component));
+		}
+
+		void WriteColor(Color const& value) {
+			Write(value.R());
+			Write(value.G());
+			Write(value.B());
+			Write(value.A());
+		}
+
+		void WriteBoundingSphere(BoundingSphere const& value) {
+			WriteVector3(value.Center);
+			Write(static_cast<float>(value.Radius));
+		}
+
+	private:
+		struct SharedResourceEntry {
+			std::shared_ptr<void> Resource;
+			csint TypeWriterIndex{ 0 };
+		};
+
+		std::vector<std::shared_ptr<ContentTypeWriter>> typeWriters;
+		std::unordered_map<std::type_index, csint> typeWriterIndices;
+		std::vector<SharedResourceEntry> sharedResources;
+		std::unordered_map<void const*, csint> sharedResourceIndices;
+
+		static std::shared_mutex _writersMutex;
+		static std::unordered_map<std::type_index, std::shared_ptr<ContentTypeWriter>> _typeWriters;
+
+		//Index of the writer for targetType in this asset's reader table, or -1.
+		csint GetTypeWriterIndex(std::type_index const& targetType);
+	};
+}
+
+//XnbWriter
+namespace xna {
+	enum class XnbCompression {
+		None,
+		//Raw LZ4 block, read by MonoGame and by ContentManager.
+		Lz4,
+		//LZX frames as written by the XNA content pipeline. The payload is stored in
+		//LZX uncompressed blocks, so it loads in any LZX reader but is not smaller.
+		Lzx,
+	};
+
+	//Serializes an asset into a complete XNB file: header, reader table, shared
+	//resource count, main object and shared resources, optionally compressed.
+	class XnbWriter {
+	public:
+		static constexpr csbyte XnbVersion = 5;
+		static constexpr csbyte HiDefProfile = 0x01;
+
+		XnbWriter(char targetPlatform = 'w', XnbCompression compression = XnbCompression::None, bool hiDef = false) :
+			targetPlatform(targetPlatform), compression(compression), hiDef(hiDef) {
+		}
+
+		//Returns the XNB bytes, or an empty vector when a type in the asset has no writer.
+		template <typename T>
+		std::vector<csbyte> Build(T const& asset) {
+			auto content = std::make_shared<cs::MemoryStream>();
+			ContentWriter writer(content);
+
+			if (!writer.WriteObject(asset))
+				return std::vector<csbyte>();
+
+			writer.WriteSharedResources();
+			writer.Flush();
+
+			return Assemble(writer, *content);
+		}
+
+		//Writes the XNB to stream. Returns false when nothing could be built.
+		template <typename T>
+		bool Write(cs::Stream& stream, T const& asset) {
+			const auto xnb = Build(asset);
+
+			if (xnb.empty())
+				return false;
+
+			stream.Write(std::span<const csbyte>(xnb));
+			return true;
+		}
+
+		template <typename T>
+		bool Save(std::string const& path, T const& asset) {
+			const auto xnb = Build(asset);
+			return !xnb.empty() && SaveFile(path, xnb);
+		}
+
+	private:
+		char targetPlatform{ 'w' };
+		XnbCompression compression{ XnbCompression::None };
+		bool hiDef{ false };
+
+		std::vector<csbyte> Assemble(ContentWriter& writer, cs::MemoryStream& content) const;
+		static bool SaveFile(std::string const& path, std::vector<csbyte> const& xnb);
+	};
+
+	//Stores data as a sequence of LZX frames made of uncompressed blocks.
+	std::vector<csbyte> LzxStore(std::span<const csbyte> data);
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,177 @@
+#include "lz4codec.hpp"
+#include <cstring>
+#include <vector>
+
+namespace xna {
+	static csuint Lz4Read32(csbyte const* source) {
+		csuint value;
+		std::memcpy(&value, source, sizeof(value));
+		return value;
+	}
+
+	//Writes a length continuation: runs of 255 followed by the remainder.
+	static bool Lz4WriteLength(csint length, csbyte*& output, csbyte const* outputEnd) {
+		while (length >= 255) {
+			if (output >= outputEnd)
+				return false;
+
+			*output++ = 255;
+			length -= 255;
+		}
+
+		if (output >= outputEnd)
+			return false;
+
+		*output++ = static_cast<csbyte>(length);
+		return true;
+	}
+
+	static bool Lz4WriteSequence(csbyte const* literals, csint literalLength, csint offset, csint matchLength,
+		csbyte*& output, csbyte const* outputEnd) {
+
+		if (output >= outputEnd)
+			return false;
+
+		auto token = output++;
+		*token = static_cast<csbyte>((literalLength >= 15 ? 15 : literalLength) << 4);
+
+		if (literalLength >= 15 && !Lz4WriteLength(literalLength - 15, output, outputEnd))
+			return false;
+
+		if (outputEnd - output < literalLength)
+			return false;
+
+		std::memcpy(output, literals, static_cast<size_t>(literalLength));
+		output += literalLength;
+
+		//The last sequence of a block only carries literals.
+		if (matchLength == 0)
+			return true;
+
+		if (outputEnd - output < 2)
+			return false;
+
+		*output++ = static_cast<csbyte>(offset);
+		*output++ = static_cast<csbyte>(offset >> 8);
+
+		const auto length = matchLength - 4;
+		*token |= static_cast<csbyte>(length >= 15 ? 15 : length);
+
+		return length < 15 || Lz4WriteLength(length - 15, output, outputEnd);
+	}
+
+	csint Lz4Codec::Compress(std::span<const csbyte> source, std::span<csbyte> destination) {
+		const auto input = source.data();
+		const auto inputSize = toint(source.size());
+		auto output = destination.data();
+		const auto outputEnd = destination.data() + destination.size();
+
+		csint anchor = 0;
+
+		if (inputSize >= MatchFindLimit + 1) {
+			std::vector<csint> table(1 << HashBits, -1);
+			const auto matchLimit = inputSize - LastLiterals;
+			csint position = 0;
+
+			while (position < inputSize - MatchFindLimit) {
+				const auto sequence = Lz4Read32(input + position);
+				const auto hash = (sequence * 2654435761U) >> (32 - HashBits);
+				const auto reference = table[hash];
+
+				table[hash] = position;
+
+				if (reference < 0 || position - reference > MaxOffset || Lz4Read32(input + reference) != sequence) {
+					++position;
+					continue;
+				}
+
+				auto matchLength = MinMatch;
+
+				while (position + matchLength < matchLimit && input[reference + matchLength] == input[position + matchLength])
+					++matchLength;
+
+				if (!Lz4WriteSequence(input + anchor, position - anchor, position - reference, matchLength, output, outputEnd))
+					return -1;
+
+				position += matchLength;
+				anchor = position;
+			}
+		}
+
+		if (!Lz4WriteSequence(input + anchor, inputSize - anchor, 0, 0, output, outputEnd))
+			return -1;
+
+		return toint(output - destination.data());
+	}
+
+	csint Lz4Codec::Decompress(std::span<const csbyte> source, std::span<csbyte> destination) {
+		auto input = source.data();
+		const auto inputEnd = source.data() + source.size();
+		auto output = destination.data();
+		const auto outputEnd = destination.data() + destination.size();
+
+		//Gives -1 as soon as the length passes the space left in the output, so
+		//a run of 255 bytes cannot overflow it.
+		const auto readLength = [&input, inputEnd, &output, outputEnd](csint length) {
+			if (length != 15)
+				return length;
+
+			csbyte value = 255;
+
+			while (value == 255 && input < inputEnd) {
+				value = *input++;
+				length += value;
+
+				if (length > outputEnd - output)
+					return -1;
+			}
+
+			return length;
+		};
+
+		while (input < inputEnd) {
+			const auto token = *input++;
+			const auto literalLength = readLength(token >> 4);
+
+			if (literalLength < 0 || inputEnd - input < literalLength || outputEnd - output < literalLength)
+				return -1;
+
+			std::memcpy(output, input, static_cast<size_t>(literalLength));
+			input += literalLength;
+			output += literalLength;
+
+			if (input == inputEnd)
+				break;
+
+			if (inputEnd - input < 2)
+				return -1;
+
+			const csint offset = input[0] | input[1] << 8;
+			input += 2;
+
+			const auto extraLength = readLength(token & 15);
+
+			if (extraLength < 0)
+				return -1;
+
+			const auto matchLength = extraLength + MinMatch;
+
+			if (offset == 0 || offset > output - destination.data() || outputEnd - output < matchLength)
+				return -1;
+
+			auto match = output - offset;
+
+			if (offset >= matchLength) {
+				std::memcpy(output, match, static_cast<size_t>(matchLength));
+				output += matchLength;
+			}
+			else {
+				//Overlapping copy repeats the last offset bytes.
+				for (csint i = 0; i < matchLength; ++i)
+					*output++ = *match++;
+			}
+		}
+
+		return toint(output - destination.data());
+	}
+}
\ No newline at end of file
@@ -0,0 +1,31 @@
+#ifndef XNA_CONTENT_LZ4CODEC_HPP
+#define XNA_CONTENT_LZ4CODEC_HPP
+
+#include <span>
+#include "../csharp/integralnumeric.hpp"
+
+namespace xna {
+	//LZ4 raw block format, as used by MonoGame for LZ4 compressed XNB payloads.
+	//https://github.com/lz4/lz4/blob/dev/doc/lz4_Block_format.md
+	struct Lz4Codec {
+		static constexpr csint MaxCompressedSize(csint inputSize) {
+			return inputSize + inputSize / 255 + 16;
+		}
+
+		//Returns the compressed size, or -1 when destination is too small.
+		static csint Compress(std::span<const csbyte> source, std::span<csbyte> destination);
+
+		//Returns the decompressed size, or -1 when the block is malformed
+		//or does not fit in destination.
+		static csint Decompress(std::span<const csbyte> source, std::span<csbyte> destination);
+
+	private:
+		static constexpr csint MinMatch = 4;
+		static constexpr csint LastLiterals = 5;
+		static constexpr csint MatchFindLimit = 12;
+		static constexpr csint MaxOffset = 65535;
+		static constexpr csint HashBits = 12;
+	};
+}
+
+#endif
\ No newline at end of file
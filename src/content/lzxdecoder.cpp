@@ -1 +1,6 @@
-#include "lzxdecoder.hpp"
\ No newline at end of file
+#include "lzxdecoder.hpp"
+
+namespace xna {
+	std::vector<csuint> LzxDecoder::position_base;
+	std::vector<csbyte> LzxDecoder::extra_bits;
+}
\ No newline at end of file
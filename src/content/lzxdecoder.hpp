@@ -178,7 +178,7 @@ namespace xna {
 		static std::vector<csuint> position_base;
 		static std::vector<csbyte> extra_bits;
 
-		csint Decompress(std::shared_ptr<cs::Stream>& inData, csint inLen, cs::Stream outData, csint outLen) {
+		csint Decompress(std::shared_ptr<cs::Stream>& inData, csint inLen, cs::Stream& outData, csint outLen) {
 			BitBuffer bitbuf(inData);
 
 			cslong startpos = inData->Position();
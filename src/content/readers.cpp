@@ -0,0 +1,32 @@
+#include "readers.hpp"
+
+namespace xna {
+	void RegisterBuiltinReaders() {
+		using Manager = ContentTypeReaderManager;
+
+		Manager::TryAddTypeCreator<BooleanReader>("Microsoft.Xna.Framework.Content.BooleanReader");
+		Manager::TryAddTypeCreator<ByteReader>("Microsoft.Xna.Framework.Content.ByteReader");
+		Manager::TryAddTypeCreator<SByteReader>("Microsoft.Xna.Framework.Content.SByteReader");
+		Manager::TryAddTypeCreator<CharReader>("Microsoft.Xna.Framework.Content.CharReader");
+		Manager::TryAddTypeCreator<Int16Reader>("Microsoft.Xna.Framework.Content.Int16Reader");
+		Manager::TryAddTypeCreator<UInt16Reader>("Microsoft.Xna.Framework.Content.UInt16Reader");
+		Manager::TryAddTypeCreator<Int32Reader>("Microsoft.Xna.Framework.Content.Int32Reader");
+		Manager::TryAddTypeCreator<UInt32Reader>("Microsoft.Xna.Framework.Content.UInt32Reader");
+		Manager::TryAddTypeCreator<Int64Reader>("Microsoft.Xna.Framework.Content.Int64Reader");
+		Manager::TryAddTypeCreator<UInt64Reader>("Microsoft.Xna.Framework.Content.UInt64Reader");
+		Manager::TryAddTypeCreator<SingleReader>("Microsoft.Xna.Framework.Content.SingleReader");
+		Manager::TryAddTypeCreator<DoubleReader>("Microsoft.Xna.Framework.Content.DoubleReader");
+		Manager::TryAddTypeCreator<StringReader>("Microsoft.Xna.Framework.Content.StringReader");
+		Manager::TryAddTypeCreator<Vector2Reader>("Microsoft.Xna.Framework.Content.Vector2Reader");
+		Manager::TryAddTypeCreator<Vector3Reader>("Microsoft.Xna.Framework.Content.Vector3Reader");
+		Manager::TryAddTypeCreator<Vector4Reader>("Microsoft.Xna.Framework.Content.Vector4Reader");
+		Manager::TryAddTypeCreator<QuaternionReader>("Microsoft.Xna.Framework.Content.QuaternionReader");
+		Manager::TryAddTypeCreator<MatrixReader>("Microsoft.Xna.Framework.Content.MatrixReader");
+		Manager::TryAddTypeCreator<ColorReader>("Microsoft.Xna.Framework.Content.ColorReader");
+		Manager::TryAddTypeCreator<PointReader>("Microsoft.Xna.Framework.Content.PointReader");
+		Manager::TryAddTypeCreator<RectangleReader>("Microsoft.Xna.Framework.Content.RectangleReader");
+		Manager::TryAddTypeCreator<BoundingBoxReader>("Microsoft.Xna.Framework.Content.BoundingBoxReader");
+		Manager::TryAddTypeCreator<BoundingSphereReader>("Microsoft.Xna.Framework.Content.BoundingSphereReader");
+		Manager::TryAddTypeCreator<Texture2DReader>("Microsoft.Xna.Framework.Content.Texture2DReader");
+	}
+}
\ No newline at end of file
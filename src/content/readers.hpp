@@ -0,0 +1,290 @@
+#ifndef XNA_CONTENT_READERS_HPP
+#define XNA_CONTENT_READERS_HPP
+
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+#include "contentreader.hpp"
+#include "../graphics/texture.hpp"
+
+//Primitive readers
+namespace xna {
+	class BooleanReader : public ContentTypeReaderT<bool> {
+	public:
+		virtual bool Read(ContentReader& input, bool& existingInstance) override {
+			return input.ReadBoolean();
+		}
+	};
+
+	class ByteReader : public ContentTypeReaderT<csbyte> {
+	public:
+		virtual csbyte Read(ContentReader& input, csbyte& existingInstance) override {
+			return input.ReadByte();
+		}
+	};
+
+	class SByteReader : public ContentTypeReaderT<cssbyte> {
+	public:
+		virtual cssbyte Read(ContentReader& input, cssbyte& existingInstance) override {
+			return input.ReadSByte();
+		}
+	};
+
+	class CharReader : public ContentTypeReaderT<char> {
+	public:
+		virtual char Read(ContentReader& input, char& existingInstance) override {
+			return input.ReadChar();
+		}
+	};
+
+	class Int16Reader : public ContentTypeReaderT<csshort> {
+	public:
+		virtual csshort Read(ContentReader& input, csshort& existingInstance) override {
+			return input.ReadInt16();
+		}
+	};
+
+	class UInt16Reader : public ContentTypeReaderT<csushort> {
+	public:
+		virtual csushort Read(ContentReader& input, csushort& existingInstance) override {
+			return input.ReadUInt16();
+		}
+	};
+
+	class Int32Reader : public ContentTypeReaderT<csint> {
+	public:
+		virtual csint Read(ContentReader& input, csint& existingInstance) override {
+			return input.ReadInt32();
+		}
+	};
+
+	class UInt32Reader : public ContentTypeReaderT<csuint> {
+	public:
+		virtual csuint Read(ContentReader& input, csuint& existingInstance) override {
+			return input.ReadUInt32();
+		}
+	};
+
+	class Int64Reader : public ContentTypeReaderT<cslong> {
+	public:
+		virtual cslong Read(ContentReader& input, cslong& existingInstance) override {
+			return input.ReadInt64();
+		}
+	};
+
+	class UInt64Reader : public ContentTypeReaderT<csulong> {
+	public:
+		virtual csulong Read(ContentReader& input, csulong& existingInstance) override {
+			return input.ReadUInt64();
+		}
+	};
+
+	class SingleReader : public ContentTypeReaderT<float> {
+	public:
+		virtual float Read(ContentReader& input, float& existingInstance) override {
+			return input.ReadSingle();
+		}
+	};
+
+	class DoubleReader : public ContentTypeReaderT<double> {
+	public:
+		virtual double Read(ContentReader& input, double& existingInstance) override {
+			return input.ReadDouble();
+		}
+	};
+
+	class StringReader : public ContentTypeReaderT<std::string> {
+	public:
+		virtual std::string Read(ContentReader& input, std::string& existingInstance) override {
+			return input.ReadString();
+		}
+
+		virtual void ReadInPlace(ContentReader& input, std::string& instance) override {
+			input.ReadString(instance);
+		}
+	};
+}
+
+//Math readers
+namespace xna {
+	class Vector2Reader : public ContentTypeReaderT<Vector2> {
+	public:
+		virtual Vector2 Read(ContentReader& input, Vector2& existingInstance) override {
+			return input.ReadVector2();
+		}
+	};
+
+	class Vector3Reader : public ContentTypeReaderT<Vector3> {
+	public:
+		virtual Vector3 Read(ContentReader& input, Vector3& existingInstance) override {
+			return input.ReadVector3();
+		}
+	};
+
+	class Vector4Reader : public ContentTypeReaderT<Vector4> {
+	public:
+		virtual Vector4 Read(ContentReader& input, Vector4& existingInstance) override {
+			return input.ReadVector4();
+		}
+	};
+
+	class QuaternionReader : public ContentTypeReaderT<Quaternion> {
+	public:
+		virtual Quaternion Read(ContentReader& input, Quaternion& existingInstance) override {
+			return input.ReadQuaternion();
+		}
+	};
+
+	class MatrixReader : public ContentTypeReaderT<Matrix> {
+	public:
+		virtual Matrix Read(ContentReader& input, Matrix& existingInstance) override {
+			return input.ReadMatrix();
+		}
+	};
+
+	class ColorReader : public ContentTypeReaderT<Color> {
+	public:
+		virtual Color Read(ContentReader& input, Color& existingInstance) override {
+			return input.ReadColor();
+		}
+	};
+
+	class PointReader : public ContentTypeReaderT<Point> {
+	public:
+		virtual Point Read(ContentReader& input, Point& existingInstance) override {
+			const auto x = input.ReadInt32();
+			const auto y = input.ReadInt32();
+			return Point(x, y);
+		}
+	};
+
+	class RectangleReader : public ContentTypeReaderT<Rectangle> {
+	public:
+		virtual Rectangle Read(ContentReader& input, Rectangle& existingInstance) override {
+			const auto x = input.ReadInt32();
+			const auto y = input.ReadInt32();
+			const auto width = input.ReadInt32();
+			const auto height = input.ReadInt32();
+			return Rectangle(x, y, width, height);
+		}
+	};
+
+	class BoundingBoxReader : public ContentTypeReaderT<BoundingBox> {
+	public:
+		virtual BoundingBox Read(ContentReader& input, BoundingBox& existingInstance) override {
+			const auto min = input.ReadVector3();
+			const auto max = input.ReadVector3();
+			return BoundingBox(min, max);
+		}
+	};
+
+	class BoundingSphereReader : public ContentTypeReaderT<BoundingSphere> {
+	public:
+		virtual BoundingSphere Read(ContentReader& input, BoundingSphere& existingInstance) override {
+			return input.ReadBoundingSphere();
+		}
+	};
+}
+
+//Graphics readers
+namespace xna {
+	//Reads the SurfaceFormat, size and level count, then each level as a
+	//byte count and the level's bytes, straight into the texture's storage.
+	//Reading stops at the first size that does not match the header, or at
+	//the end of the data, and gives nullptr.
+	//
+	//Textures are loaded as Load<std::shared_ptr<Texture2D>>, so the
+	//ContentManager cache and every repeat load share one copy of the texels.
+	class Texture2DReader : public ContentTypeReaderT<std::shared_ptr<Texture2D>> {
+	public:
+		virtual std::shared_ptr<Texture2D> Read(ContentReader& input, std::shared_ptr<Texture2D>& existingInstance) override {
+			std::shared_ptr<Texture2D> texture;
+			ReadInPlace(input, texture);
+			return texture;
+		}
+
+		virtual void ReadInPlace(ContentReader& input, std::shared_ptr<Texture2D>& instance) override {
+			const auto format = static_cast<SurfaceFormat>(input.ReadInt32());
+			const auto width = input.ReadUInt32();
+			const auto height = input.ReadUInt32();
+			const auto levelCount = input.ReadUInt32();
+			const auto fits = width <= static_cast<csuint>(int_max) && height <= static_cast<csuint>(int_max) && levelCount <= 32;
+
+			instance = nullptr;
+
+			if (!fits || levelCount == 0)
+				return;
+
+			//The first level's size is checked against the header and the data
+			//actually left before the texture is allocated, so a corrupt header
+			//cannot ask for more memory than the file holds.
+			auto size = input.ReadUInt32();
+
+			if (size > static_cast<csuint>(int_max) || size != Texture2D::LevelByteCount(static_cast<csint>(width), static_cast<csint>(height), format))
+				return;
+
+			const auto remaining = input.Remaining();
+
+			if (remaining >= 0 && size > remaining)
+				return;
+
+			//A stream that cannot tell has level 0 read first, in chunks, so
+			//memory only grows with the bytes that really arrive.
+			std::vector<csbyte> firstLevel;
+
+			if (remaining < 0 && !ReadLevel(input, size, firstLevel))
+				return;
+
+			auto texture = std::make_shared<Texture2D>(static_cast<csint>(width), static_cast<csint>(height), static_cast<csint>(levelCount), format);
+
+			for (csint level = 0; level < texture->LevelCount(); ++level) {
+				if (level > 0)
+					size = input.ReadUInt32();
+
+				auto data = texture->LevelData(level);
+
+				if (data.size() != size)
+					return;
+
+				if (level == 0 && !firstLevel.empty()) {
+					std::memcpy(data.data(), firstLevel.data(), data.size());
+					continue;
+				}
+
+				if (input.ReadRaw(data) != static_cast<csint>(size))
+					return;
+			}
+
+			if (!texture->IsEmpty())
+				instance = std::move(texture);
+		}
+
+	private:
+		static bool ReadLevel(ContentReader& input, csuint size, std::vector<csbyte>& data) {
+			constexpr size_t chunk = 1 << 16;
+
+			while (data.size() < size) {
+				const auto offset = data.size();
+				const auto count = std::min(chunk, size - offset);
+
+				data.resize(offset + count);
+
+				if (input.ReadRaw(std::span<csbyte>(data.data() + offset, count)) != static_cast<csint>(count))
+					return false;
+			}
+
+			return true;
+		}
+	};
+}
+
+//Registration
+namespace xna {
+	//Adds the readers above to ContentTypeReaderManager under their XNA names,
+	//keeping any creator already registered under one of those names.
+	void RegisterBuiltinReaders();
+}
+
+#endif
\ No newline at end of file
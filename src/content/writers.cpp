@@ -0,0 +1,29 @@
+#include "writers.hpp"
+
+namespace xna {
+	void RegisterBuiltinWriters() {
+		ContentWriter::TryAddTypeWriter<BooleanWriter>();
+		ContentWriter::TryAddTypeWriter<ByteWriter>();
+		ContentWriter::TryAddTypeWriter<SByteWriter>();
+		ContentWriter::TryAddTypeWriter<CharWriter>();
+		ContentWriter::TryAddTypeWriter<Int16Writer>();
+		ContentWriter::TryAddTypeWriter<UInt16Writer>();
+		ContentWriter::TryAddTypeWriter<Int32Writer>();
+		ContentWriter::TryAddTypeWriter<UInt32Writer>();
+		ContentWriter::TryAddTypeWriter<Int64Writer>();
+		ContentWriter::TryAddTypeWriter<UInt64Writer>();
+		ContentWriter::TryAddTypeWriter<SingleWriter>();
+		ContentWriter::TryAddTypeWriter<DoubleWriter>();
+		ContentWriter::TryAddTypeWriter<StringWriter>();
+		ContentWriter::TryAddTypeWriter<Vector2Writer>();
+		ContentWriter::TryAddTypeWriter<Vector3Writer>();
+		ContentWriter::TryAddTypeWriter<Vector4Writer>();
+		ContentWriter::TryAddTypeWriter<QuaternionWriter>();
+		ContentWriter::TryAddTypeWriter<MatrixWriter>();
+		ContentWriter::TryAddTypeWriter<ColorWriter>();
+		ContentWriter::TryAddTypeWriter<PointWriter>();
+		ContentWriter::TryAddTypeWriter<RectangleWriter>();
+		ContentWriter::TryAddTypeWriter<BoundingBoxWriter>();
+		ContentWriter::TryAddTypeWriter<BoundingSphereWriter>();
+	}
+}
\ No newline at end of file
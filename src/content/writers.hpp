@@ -0,0 +1,278 @@
+#ifndef XNA_CONTENT_WRITERS_HPP
+#define XNA_CONTENT_WRITERS_HPP
+
+#include <string>
+#include "contentwriter.hpp"
+
+//Primitive writers
+namespace xna {
+	class BooleanWriter : public ContentTypeWriterT<bool> {
+	public:
+		virtual std::string GetRuntimeReader() const override {
+			return "Microsoft.Xna.Framework.Content.BooleanReader";
+		}
+
+		virtual void Write(ContentWriter& output, bool const& value) override {
+			output.Write(value);
+		}
+	};
+
+	class ByteWriter : public ContentTypeWriterT<csbyte> {
+	public:
+		virtual std::string GetRuntimeReader() const override {
+			return "Microsoft.Xna.Framework.Content.ByteReader";
+		}
+
+		virtual void Write(ContentWriter& output, csbyte const& value) override {
+			output.Write(value);
+		}
+	};
+
+	class SByteWriter : public ContentTypeWriterT<cssbyte> {
+	public:
+		virtual std::string GetRuntimeReader() const override {
+			return "Microsoft.Xna.Framework.Content.SByteReader";
+		}
+
+		virtual void Write(ContentWriter& output, cssbyte const& value) override {
+			output.Write(value);
+		}
+	};
+
+	class CharWriter : public ContentTypeWriterT<char> {
+	public:
+		virtual std::string GetRuntimeReader() const override {
+			return "Microsoft.Xna.Framework.Content.CharReader";
+		}
+
+		virtual void Write(ContentWriter& output, char const& value) override {
+			output.Write(value);
+		}
+	};
+
+	class Int16Writer : public ContentTypeWriterT<csshort> {
+	public:
+		virtual std::string GetRuntimeReader() const override {
+			return "Microsoft.Xna.Framework.Content.Int16Reader";
+		}
+
+		virtual void Write(ContentWriter& output, csshort const& value) override {
+			output.Write(value);
+		}
+	};
+
+	class UInt16Writer : public ContentTypeWriterT<csushort> {
+	public:
+		virtual std::string GetRuntimeReader() const override {
+			return "Microsoft.Xna.Framework.Content.UInt16Reader";
+		}
+
+		virtual void Write(ContentWriter& output, csushort const& value) override {
+			output.Write(value);
+		}
+	};
+
+	class Int32Writer : public ContentTypeWriterT<csint> {
+	public:
+		virtual std::string GetRuntimeReader() const override {
+			return "Microsoft.Xna.Framework.Content.Int32Reader";
+		}
+
+		virtual void Write(ContentWriter& output, csint const& value) override {
+			output.Write(value);
+		}
+	};
+
+	class UInt32Writer : public ContentTypeWriterT<csuint> {
+	public:
+		virtual std::string GetRuntimeReader() const override {
+			return "Microsoft.Xna.Framework.Content.UInt32Reader";
+		}
+
+		virtual void Write(ContentWriter& output, csuint const& value) override {
+			output.Write(value);
+		}
+	};
+
+	class Int64Writer : public ContentTypeWriterT<cslong> {
+	public:
+		virtual std::string GetRuntimeReader() const override {
+			return "Microsoft.Xna.Framework.Content.Int64Reader";
+		}
+
+		virtual void Write(ContentWriter& output, cslong const& value) override {
+			output.Write(value);
+		}
+	};
+
+	class UInt64Writer : public ContentTypeWriterT<csulong> {
+	public:
+		virtual std::string GetRuntimeReader() const override {
+			return "Microsoft.Xna.Framework.Content.UInt64Reader";
+		}
+
+		virtual void Write(ContentWriter& output, csulong const& value) override {
+			output.Write(value);
+		}
+	};
+
+	class SingleWriter : public ContentTypeWriterT<float> {
+	public:
+		virtual std::string GetRuntimeReader() const override {
+			return "Microsoft.Xna.Framework.Content.SingleReader";
+		}
+
+		virtual void Write(ContentWriter& output, float const& value) override {
+			output.Write(value);
+		}
+	};
+
+	class DoubleWriter : public ContentTypeWriterT<double> {
+	public:
+		virtual std::string GetRuntimeReader() const override {
+			return "Microsoft.Xna.Framework.Content.DoubleReader";
+		}
+
+		virtual void Write(ContentWriter& output, double const& value) override {
+			output.Write(value);
+		}
+	};
+
+	class StringWriter : public ContentTypeWriterT<std::string> {
+	public:
+		virtual std::string GetRuntimeReader() const override {
+			return "Microsoft.Xna.Framework.Content.StringReader";
+		}
+
+		virtual void Write(ContentWriter& output, std::string const& value) override {
+			output.Write(value);
+		}
+	};
+}
+
+//Math writers
+namespace xna {
+	class Vector2Writer : public ContentTypeWriterT<Vector2> {
+	public:
+		virtual std::string GetRuntimeReader() const override {
+			return "Microsoft.Xna.Framework.Content.Vector2Reader";
+		}
+
+		virtual void Write(ContentWriter& output, Vector2 const& value) override {
+			output.WriteVector2(value);
+		}
+	};
+
+	class Vector3Writer : public ContentTypeWriterT<Vector3> {
+	public:
+		virtual std::string GetRuntimeReader() const override {
+			return "Microsoft.Xna.Framework.Content.Vector3Reader";
+		}
+
+		virtual void Write(ContentWriter& output, Vector3 const& value) override {
+			output.WriteVector3(value);
+		}
+	};
+
+	class Vector4Writer : public ContentTypeWriterT<Vector4> {
+	public:
+		virtual std::string GetRuntimeReader() const override {
+			return "Microsoft.Xna.Framework.Content.Vector4Reader";
+		}
+
+		virtual void Write(ContentWriter& output, Vector4 const& value) override {
+			output.WriteVector4(value);
+		}
+	};
+
+	class QuaternionWriter : public ContentTypeWriterT<Quaternion> {
+	public:
+		virtual std::string GetRuntimeReader() const override {
+			return "Microsoft.Xna.Framework.Content.QuaternionReader";
+		}
+
+		virtual void Write(ContentWriter& output, Quaternion const& value) override {
+			output.WriteQuaternion(value);
+		}
+	};
+
+	class MatrixWriter : public ContentTypeWriterT<Matrix> {
+	public:
+		virtual std::string GetRuntimeReader() const override {
+			return "Microsoft.Xna.Framework.Content.MatrixReader";
+		}
+
+		virtual void Write(ContentWriter& output, Matrix const& value) override {
+			output.WriteMatrix(value);
+		}
+	};
+
+	class ColorWriter : public ContentTypeWriterT<Color> {
+	public:
+		virtual std::string GetRuntimeReader() const override {
+			return "Microsoft.Xna.Framework.Content.ColorReader";
+		}
+
+		virtual void Write(ContentWriter& output, Color const& value) override {
+			output.WriteColor(value);
+		}
+	};
+
+	class PointWriter : public ContentTypeWriterT<Point> {
+	public:
+		virtual std::string GetRuntimeReader() const override {
+			return "Microsoft.Xna.Framework.Content.PointReader";
+		}
+
+		virtual void Write(ContentWriter& output, Point const& value) override {
+			output.Write(value.X);
+			output.Write(value.Y);
+		}
+	};
+
+	class RectangleWriter : public ContentTypeWriterT<Rectangle> {
+	public:
+		virtual std::string GetRuntimeReader() const override {
+			return "Microsoft.Xna.Framework.Content.RectangleReader";
+		}
+
+		virtual void Write(ContentWriter& output, Rectangle const& value) override {
+			output.Write(value.X);
+			output.Write(value.Y);
+			output.Write(value.Width);
+			output.Write(value.Height);
+		}
+	};
+
+	class BoundingBoxWriter : public ContentTypeWriterT<BoundingBox> {
+	public:
+		virtual std::string GetRuntimeReader() const override {
+			return "Microsoft.Xna.Framework.Content.BoundingBoxReader";
+		}
+
+		virtual void Write(ContentWriter& output, BoundingBox const& value) override {
+			output.WriteVector3(value.Min);
+			output.WriteVector3(value.Max);
+		}
+	};
+
+	class BoundingSphereWriter : public ContentTypeWriterT<BoundingSphere> {
+	public:
+		virtual std::string GetRuntimeReader() const override {
+			return "Microsoft.Xna.Framework.Content.BoundingSphereReader";
+		}
+
+		virtual void Write(ContentWriter& output, BoundingSphere const& value) override {
+			output.WriteBoundingSphere(value);
+		}
+	};
+}
+
+//Registration
+namespace xna {
+	//Adds the writers above to ContentWriter, one per target type, keeping any
+	//writer already registered for one of those types.
+	void RegisterBuiltinWriters();
+}
+
+#endif
\ No newline at end of file
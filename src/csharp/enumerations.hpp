@@ -22,6 +22,15 @@ namespace cs {
 		Truncate = 5,
 		Append = 6,
 	};
+
+	enum class FileOptions {
+		None = 0,
+		SequentialScan = 0x08000000,
+		RandomAccess = 0x10000000,
+		//FILE_FLAG_NO_BUFFERING, which .NET accepts without naming it.
+		//Maps to O_DIRECT on Linux; read-only streams only.
+		NoBuffering = 0x20000000,
+	};
 }
 
 #endif
\ No newline at end of file
@@ -15,7 +15,7 @@ using csulong = cs::Ulong;
 static constexpr cssbyte sbyte_max = cs::Limits::SbyteMax;
 static constexpr csbyte byte_max = cs::Limits::ByteMax;
 static constexpr csshort short_max = cs::Limits::ShortMax;
-static constexpr csshort ushort_max = cs::Limits::UshortMax;
+static constexpr csushort ushort_max = cs::Limits::UshortMax;
 static constexpr csint int_max = cs::Limits::IntMax;
 static constexpr csuint uint_max = cs::Limits::UintMax;
 static constexpr cslong long_max = cs::Limits::LongMax;
@@ -24,7 +24,7 @@ static constexpr csulong ulong_max = cs::Limits::UlongMax;
 static constexpr cssbyte sbyte_min = cs::Limits::SbyteMin;
 static constexpr csbyte byte_min = cs::Limits::ByteMin;
 static constexpr csshort short_min = cs::Limits::ShortMin;
-static constexpr csshort ushort_min = cs::Limits::UshortMin;
+static constexpr csushort ushort_min = cs::Limits::UshortMin;
 static constexpr csint int_min = cs::Limits::IntMin;
 static constexpr csuint uint_min = cs::Limits::UintMin;
 static constexpr cslong long_min = cs::Limits::LongMin;
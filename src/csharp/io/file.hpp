@@ -6,11 +6,27 @@
 namespace cs {
 	struct File {
 		static PtrFileStream Create(std::string const& path) {
-			return FileStream::Make(path);
+			return Open(path, FileMode::Create, FileAccess::ReadWrite);
 		}
 
 		static PtrFileStream Open(std::string const& path) {
-			return FileStream::Make(path);
+			return Open(path, FileMode::Open, FileAccess::ReadWrite);
+		}
+
+		//Returns nullptr when the file cannot be opened.
+		static PtrFileStream Open(std::string const& path, FileMode mode, FileAccess access,
+			FileOptions options = FileOptions::None) {
+			auto stream = std::make_shared<FileStream>(path, mode, access, options);
+
+			if (!stream->IsOpen())
+				return nullptr;
+
+			return stream;
+		}
+
+		//Read-only with a sequential read-ahead hint, the way content is read.
+		static PtrFileStream OpenRead(std::string const& path) {
+			return Open(path, FileMode::Open, FileAccess::Read, FileOptions::SequentialScan);
 		}
 	};
 }
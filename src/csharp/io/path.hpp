@@ -309,7 +309,7 @@ namespace cs {
 		}
 
 		static constexpr std::string Combine(std::string const& path1, std::string const& path2) {
-			return std::string();
+			return CombineInternal(path1, path2);
 		}
 
 		static constexpr std::string Combine(std::string const& path1, std::string const& path2, std::string const& path3) {
@@ -351,12 +351,13 @@ namespace cs {
 			if (second.empty())
 				return first;
 
-			return std::string();
-
-			/*if (IsPathRooted(second))
+			if (IsPathRooted(second))
 				return second;
 
-			return JoinInternal(first.AsSpan(), second.AsSpan());*/
+			if (PathInternal::IsDirectorySeparator(first.back()))
+				return first + second;
+
+			return first + DirectorySeparatorChar + second;
 		}
 	};
 }
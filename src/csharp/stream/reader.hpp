@@ -1,44 +1,113 @@
 #ifndef CS_STREAM_READER_HPP
 #define CS_STREAM_READER_HPP
 
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstring>
+#include <memory_resource>
+#include <span>
+#include <type_traits>
 #include "stream.hpp"
 
 //BinaryReader
 namespace cs {
 	// https://referencesource.microsoft.com/#mscorlib/system/io/binaryreader.cs,4f6cad84482876ff
+	//
+	// The reader keeps an internal refillable buffer, so the primitive reads below are
+	// non-virtual memcpy's out of that buffer and only touch the stream on refill.
+	// Because of that the stream position runs ahead of the reader; call BaseStream()
+	// to get the stream back positioned at the next unread byte.
+	//
+	// Over a read-only MemoryStream no buffer is allocated: the reader views the
+	// stream's own memory, and the stream is moved to its end while the reader holds
+	// the view. The reader keeps the stream alive and a read-only stream can neither
+	// change nor move its memory, so the view stays valid. Writable memory streams
+	// are buffered like any other stream, whose buffer comes from resource so
+	// short-lived readers can draw it from an arena.
 	class BinaryReader {
 	public:
-		BinaryReader(std::shared_ptr<Stream> stream) :
-			_stream(stream) {
+		static constexpr csint DefaultBufferSize = 4096;
+		static constexpr csint MinBufferSize = 16;
+
+		BinaryReader(std::shared_ptr<Stream> stream, csint bufferSize = DefaultBufferSize,
+			std::pmr::memory_resource* resource = std::pmr::get_default_resource()) :
+			_stream(stream),
+			_memory(ViewableMemory(stream.get())),
+			_buffer(resource) {
+
+			if (!_memory)
+				_buffer.resize(static_cast<size_t>(bufferSize < MinBufferSize ? MinBufferSize : bufferSize));
+
+			_view = _buffer.data();
 		}
 
-		virtual void Close() {}
+		virtual ~BinaryReader() = default;
 
-		virtual csint PeekChar() {
+		virtual void Close() {
+			BaseStream();
+		}
+
+		//Returns the underlying stream, seeking it back over the bytes
+		//that were buffered but not consumed yet.
+		std::shared_ptr<Stream> BaseStream() {
+			const auto unread = BufferedCount();
+
+			if (unread > 0 && _stream->CanSeek())
+				_stream->Seek(-static_cast<cslong>(unread), SeekOrigin::Current);
+
+			_bufferPosition = 0;
+			_bufferLength = 0;
+
+			return _stream;
+		}
+
+		//Bytes left to read, buffered ones included, or -1 when the stream
+		//cannot tell its length or position.
+		cslong Remaining() {
 			if (!_stream->CanSeek())
 				return -1;
 
-			cslong origPos = _stream->Position();
-			csint ch = Read();
+			const auto length = _stream->Length();
+			const auto position = _stream->Position();
+
+			if (length < 0 || position < 0)
+				return -1;
+
+			return length - position + BufferedCount();
+		}
+
+		constexpr csint BufferSize() const {
+			return static_cast<csint>(_buffer.size());
+		}
+
+		virtual csint PeekChar() {
+			if (BufferedCount() == 0 && !FillBuffer(1))
+				return -1;
 
-			_stream->Position(origPos);
-			return ch;
+			return _view[_bufferPosition];
 		}
 
-		virtual csbyte ReadByte() {
-			return 0;
+		csbyte ReadByte() {
+			if (_bufferPosition < _bufferLength)
+				return _view[_bufferPosition++];
+
+			return InternalReadByte();
 		}
 
 		virtual csint Read() {
-			return -1;
+			if (BufferedCount() == 0 && !FillBuffer(1))
+				return -1;
+
+			return _view[_bufferPosition++];
 		}
 
-		virtual cssbyte ReadSByte() {
-			return tosbyte(InternalReadByte());
+		cssbyte ReadSByte() {
+			return tosbyte(ReadByte());
 		}
 
-		virtual bool ReadBoolean() {
-			return InternalReadByte() != 0;
+		bool ReadBoolean() {
+			return ReadByte() != 0;
 		}
 
 		virtual char ReadChar() {
@@ -51,107 +120,402 @@ namespace cs {
 			return static_cast<char>(value);
 		}
 
-		virtual csshort ReadInt16() {
-			return 0;
+		csshort ReadInt16() {
+			return ReadPrimitive<csshort>();
 		}
 
-		virtual csushort ReadUInt16() {
-			return 0;
+		csushort ReadUInt16() {
+			return ReadPrimitive<csushort>();
 		}
 
-		virtual csint ReadInt32() {
-			return 0;
+		csint ReadInt32() {
+			return ReadPrimitive<csint>();
 		}
 
-		virtual csuint ReadUInt32() {
-			return 0;
+		csuint ReadUInt32() {
+			return ReadPrimitive<csuint>();
 		}
 
-		virtual cslong ReadInt64() {
-			return 0;
+		cslong ReadInt64() {
+			return ReadPrimitive<cslong>();
 		}
 
-		virtual csulong ReadUInt64() {
-			return 0;
+		csulong ReadUInt64() {
+			return ReadPrimitive<csulong>();
 		}
 
-		virtual float ReadSingle() {
-			return 0.0;
+		float ReadSingle() {
+			return ReadPrimitive<float>();
 		}
 
-		virtual double ReadDouble() {
-			return 0.0;
+		double ReadDouble() {
+			return ReadPrimitive<double>();
 		}
 
 		virtual std::string ReadString() {
-			return "";
+			const auto length = Read7BitEncodedInt();
+
+			if (length <= 0)
+				return std::string();
+
+			if (BufferedCount() >= length) {
+				const auto chars = reinterpret_cast<char const*>(_view + _bufferPosition);
+				_bufferPosition += length;
+				return std::string(chars, static_cast<size_t>(length));
+			}
+
+			std::string value(static_cast<size_t>(length), '\0');
+			const auto count = InternalRead(reinterpret_cast<csbyte*>(value.data()), length);
+			value.resize(static_cast<size_t>(count));
+
+			return value;
 		}
 
-		virtual csint Read(std::vector<char> buffer, csint index, csint count) {
+		//Reads a length-prefixed string into value, reusing its capacity. A string
+		//that is already buffered is copied in one go.
+		void ReadString(std::string& value) {
+			const auto length = Read7BitEncodedInt();
 
-			if (buffer.size() - index < count) {
-				return -1;
+			if (length <= 0) {
+				value.clear();
+				return;
+			}
+
+			if (BufferedCount() >= length) {
+				value.assign(reinterpret_cast<char const*>(_view + _bufferPosition), static_cast<size_t>(length));
+				_bufferPosition += length;
+				return;
 			}
 
-			//return InternalReadChars(new Span<char>(buffer, index, count));
+			value.resize(static_cast<size_t>(length));
+			const auto count = InternalRead(reinterpret_cast<csbyte*>(value.data()), length);
+			value.resize(static_cast<size_t>(count));
+		}
+
+		virtual csint Read(std::vector<char>& buffer, csint index, csint count) {
+			if (index < 0 || count < 0 || buffer.size() - index < static_cast<size_t>(count))
+				return -1;
+
+			return InternalRead(reinterpret_cast<csbyte*>(buffer.data()) + index, count);
 		}
 
-		virtual csint Read(std::vector<char> buffer) {
-			//return InternalReadChars(buffer);
-			return 0;
+		virtual csint Read(std::vector<char>& buffer) {
+			return InternalRead(reinterpret_cast<csbyte*>(buffer.data()), static_cast<csint>(buffer.size()));
 		}
 
 		virtual std::vector<char> ReadChars(csint count) {
-			return std::vector<char>();
+			if (count <= 0)
+				return std::vector<char>();
+
+			std::vector<char> chars(static_cast<size_t>(count));
+			const auto n = InternalRead(reinterpret_cast<csbyte*>(chars.data()), count);
+			chars.resize(static_cast<size_t>(n));
+
+			return chars;
 		}
 
-		virtual csint Read(std::vector<csbyte> buffer, csint index, csint count) {
-			return 0;
+		virtual csint Read(std::vector<csbyte>& buffer, csint index, csint count) {
+			if (index < 0 || count < 0 || buffer.size() - index < static_cast<size_t>(count))
+				return -1;
+
+			return Read(std::span<csbyte>(buffer.data() + index, static_cast<size_t>(count)));
 		}
 
-		virtual csint Read(std::vector<csbyte> buffer) {
-			return 0;
+		virtual csint Read(std::vector<csbyte>& buffer) {
+			return Read(std::span<csbyte>(buffer));
 		}
 
-		virtual std::vector<csbyte> ReadBytes(csint count) {
-			return std::vector<csbyte>();
+		//Reads up to buffer.size() bytes into the caller's memory. What is left
+		//after the buffered bytes goes straight from the stream when it is at
+		//least a buffer long.
+		csint Read(std::span<csbyte> buffer) {
+			const auto count = static_cast<csint>(buffer.size());
+			csint n = CopyFromBuffer(buffer.data(), count);
+
+			if (n < count && count - n >= BufferSize())
+				return n + ReadFromStream(buffer.subspan(static_cast<size_t>(n)));
+
+			return n + InternalRead(buffer.data() + n, count - n);
 		}
 
-		virtual csint Read7BitEncodedInt() {
-			return 0;
+		//Large requests skip the internal buffer and are read straight into the result.
+		virtual std::vector<csbyte> ReadBytes(csint count) {
+			if (count <= 0)
+				return std::vector<csbyte>();
+
+			std::vector<csbyte> result(static_cast<size_t>(count));
+			const auto n = Read(std::span<csbyte>(result));
+
+			result.resize(static_cast<size_t>(n));
+			return result;
 		}
 
-		virtual cslong Read7BitEncodedInt64() {
-			return 0;
+		//With 8 bytes buffered the value is decoded from one unaligned load, without
+		//a branch per byte: the first byte whose high bit is clear ends the value.
+		csint Read7BitEncodedInt() {
+			if constexpr (std::endian::native == std::endian::little) {
+				if (BufferedCount() >= 8) {
+					csulong word;
+					std::memcpy(&word, _view + _bufferPosition, sizeof(word));
+
+					const auto stops = ~word & 0x8080808080808080ull;
+					const auto length = (std::countr_zero(stops) >> 3) + 1;
+
+					if (length <= 5) {
+						_bufferPosition += length;
+						word &= ~0ull >> (64 - length * 8);
+
+						//Format_Bad7BitInt: the fifth byte may only carry the upper 4 bits.
+						if (length == 5 && (word >> 32) > 0b1111u)
+							return 0;
+
+						const auto value = (word & 0x7Full)
+							| ((word >> 1) & 0x3F80ull)
+							| ((word >> 2) & 0x1FC000ull)
+							| ((word >> 3) & 0xFE00000ull)
+							| ((word >> 4) & 0xF0000000ull);
+
+						return toint(static_cast<csuint>(value));
+					}
+				}
+			}
+
+			return Read7BitEncodedIntSlow();
 		}
 
+		//One bounds check covers the longest encoding; the loop then runs on the buffer.
+		cslong Read7BitEncodedInt64() {
+			constexpr csint MaxBytesWithoutOverflow = 9;
+
+			if (BufferedCount() < MaxBytesWithoutOverflow + 1)
+				return Read7BitEncodedInt64Slow();
+
+			auto bytes = _view + _bufferPosition;
+			csulong result = 0;
+
+			for (csint i = 0; i < MaxBytesWithoutOverflow; ++i) {
+				result |= (bytes[i] & 0x7Ful) << (i * 7);
+
+				if (bytes[i] <= 0x7Fu) {
+					_bufferPosition += i + 1;
+					return tolong(result);
+				}
+			}
+
+			_bufferPosition += MaxBytesWithoutOverflow + 1;
+
+			if (bytes[MaxBytesWithoutOverflow] > 0b1u)
+				return 0;
+
+			result |= toulong(bytes[MaxBytesWithoutOverflow]) << (MaxBytesWithoutOverflow * 7);
+			return tolong(result);
+		}
 
 	protected:
-		virtual void FillBuffer(csint numBytes) {
+		//Discards the consumed bytes and tops the buffer up from the stream.
+		//Returns false when fewer than numBytes could be made available.
+		virtual bool FillBuffer(csint numBytes) {
+			if (_memory)
+				return ViewMemory(numBytes);
+
+			auto unread = BufferedCount();
+
+			if (unread > 0 && _bufferPosition > 0)
+				std::memmove(_buffer.data(), _buffer.data() + _bufferPosition, static_cast<size_t>(unread));
+
+			_bufferPosition = 0;
+			_bufferLength = unread;
+
+			while (_bufferLength < numBytes) {
+				const auto n = _stream->Read(std::span<csbyte>(_buffer.data() + _bufferLength, static_cast<size_t>(BufferSize() - _bufferLength)));
+
+				if (n <= 0)
+					return false;
+
+				_bufferLength += n;
+			}
+
+			return true;
+		}
+
+		constexpr csint BufferedCount() const {
+			return _bufferLength - _bufferPosition;
+		}
+
+		//Hands the next count bytes to consume as contiguous spans whose sizes are
+		//multiples of granularity, so bulk decoders work in place on the buffer.
+		//Returns the number of bytes consumed.
+		template <typename Consumer>
+		csint ReadChunks(csint count, csint granularity, Consumer&& consume) {
+			csint done = 0;
+
+			while (done < count) {
+				if (BufferedCount() < granularity && !FillBuffer(granularity))
+					break;
+
+				auto n = BufferedCount() < count - done ? BufferedCount() : count - done;
+				n -= n % granularity;
+
+				consume(std::span<const csbyte>(_view + _bufferPosition, static_cast<size_t>(n)));
+
+				_bufferPosition += n;
+				done += n;
+			}
+
+			return done;
 		}
 
 	private:
 		static constexpr csint MaxCharBytesSize = 128;
 		std::shared_ptr<Stream> _stream;
+		MemoryStream* _memory{ nullptr };
+		std::pmr::vector<csbyte> _buffer;
+		csbyte const* _view{ nullptr };
+		csint _bufferPosition{ 0 };
+		csint _bufferLength{ 0 };
 		std::vector<csbyte> _charBytes;
 		bool _2BytesPerChar{ true };
 
-		csbyte InternalReadByte() {
-			csint b = _stream->ReadByte();
+		template <typename T>
+		T ReadPrimitive() {
+			static_assert(std::is_trivially_copyable_v<T>);
+
+			T value;
+
+			if (BufferedCount() < static_cast<csint>(sizeof(T)) && !FillBuffer(sizeof(T))) {
+				//End of stream: the reader yields zero instead of throwing.
+				_bufferPosition = _bufferLength;
+				return T();
+			}
+
+			std::memcpy(&value, _view + _bufferPosition, sizeof(T));
+			_bufferPosition += sizeof(T);
+
+			if constexpr (std::endian::native == std::endian::big && sizeof(T) > 1) {
+				auto bytes = std::bit_cast<std::array<csbyte, sizeof(T)>>(value);
+				std::reverse(bytes.begin(), bytes.end());
+				value = std::bit_cast<T>(bytes);
+			}
+
+			return value;
+		}
+
+		csint Read7BitEncodedIntSlow() {
+			csuint result = 0;
+			csbyte byteReadJustNow = 0;
+
+			constexpr csint MaxBytesWithoutOverflow = 4;
+
+			for (csint shift = 0; shift < MaxBytesWithoutOverflow * 7; shift += 7) {
+				byteReadJustNow = ReadByte();
+				result |= (byteReadJustNow & 0x7Fu) << shift;
+
+				if (byteReadJustNow <= 0x7Fu)
+					return toint(result);
+			}
+
+			byteReadJustNow = ReadByte();
+
+			//Format_Bad7BitInt: the fifth byte may only carry the upper 4 bits.
+			if (byteReadJustNow > 0b1111u)
+				return 0;
+
+			result |= touint(byteReadJustNow) << (MaxBytesWithoutOverflow * 7);
+			return toint(result);
+		}
+
+		cslong Read7BitEncodedInt64Slow() {
+			csulong result = 0;
+			csbyte byteReadJustNow = 0;
+
+			constexpr csint MaxBytesWithoutOverflow = 9;
 
-			if (b == -1) {
+			for (csint shift = 0; shift < MaxBytesWithoutOverflow * 7; shift += 7) {
+				byteReadJustNow = ReadByte();
+				result |= (byteReadJustNow & 0x7Ful) << shift;
+
+				if (byteReadJustNow <= 0x7Fu)
+					return tolong(result);
+			}
+
+			byteReadJustNow = ReadByte();
+
+			if (byteReadJustNow > 0b1u)
+				return 0;
+
+			result |= toulong(byteReadJustNow) << (MaxBytesWithoutOverflow * 7);
+			return tolong(result);
+		}
+
+		csbyte InternalReadByte() {
+			if (!FillBuffer(1)) {
 				return 0;
 			}
 
-			return tobyte(b);
+			return _view[_bufferPosition++];
+		}
+
+		//Bypasses the buffer, which must be empty.
+		csint ReadFromStream(std::span<csbyte> destination) {
+			size_t n = 0;
+
+			while (n < destination.size()) {
+				const auto read = _stream->Read(destination.subspan(n));
+
+				if (read <= 0)
+					break;
+
+				n += static_cast<size_t>(read);
+			}
+
+			return static_cast<csint>(n);
 		}
 
-		csint InternalReadChars(std::vector<char> buffer) {
-			return 0;
+		static MemoryStream* ViewableMemory(Stream* stream) {
+			const auto memory = dynamic_cast<MemoryStream*>(stream);
+			return memory && !memory->CanWrite() ? memory : nullptr;
 		}
 
-		std::vector<csbyte> InternalRead(csint numBytes) {
-			return std::vector<csbyte>();
+		//Points the view at everything left in the memory stream, unread bytes included.
+		bool ViewMemory(csint numBytes) {
+			const auto unread = BufferedCount();
+
+			if (unread > 0)
+				_memory->Seek(-static_cast<cslong>(unread), SeekOrigin::Current);
+
+			const auto remaining = _memory->Remaining();
+
+			_view = remaining.data();
+			_bufferPosition = 0;
+			_bufferLength = static_cast<csint>(remaining.size());
+
+			_memory->Seek(0, SeekOrigin::End);
+
+			return _bufferLength >= numBytes;
+		}
+
+		csint CopyFromBuffer(csbyte* destination, csint count) {
+			const auto n = count < BufferedCount() ? count : BufferedCount();
+
+			if (n > 0) {
+				std::memcpy(destination, _view + _bufferPosition, static_cast<size_t>(n));
+				_bufferPosition += n;
+			}
+
+			return n;
+		}
+
+		csint InternalRead(csbyte* destination, csint count) {
+			csint n = CopyFromBuffer(destination, count);
+
+			while (n < count) {
+				if (!FillBuffer(1))
+					break;
+
+				n += CopyFromBuffer(destination + n, count - n);
+			}
+
+			return n;
 		}
 	};
 }
@@ -1 +1,457 @@
-#include "stream.hpp"
\ No newline at end of file
+#include "stream.hpp"
+
+#ifndef _WIN32
+#include <cerrno>
+#include <cstdint>
+#include <cstdlib>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#endif
+
+namespace cs {
+	static FileAccess AccessOf(std::ios_base::openmode openMode) {
+		const auto in = (openMode & std::ios_base::in) != 0;
+		const auto out = (openMode & (std::ios_base::out | std::ios_base::app)) != 0;
+
+		if (in && out)
+			return FileAccess::ReadWrite;
+
+		return out ? FileAccess::Write : FileAccess::Read;
+	}
+
+	static FileMode ModeOf(std::ios_base::openmode openMode) {
+		if (openMode & std::ios_base::app)
+			return FileMode::Append;
+
+		if ((openMode & std::ios_base::trunc) || AccessOf(openMode) == FileAccess::Write)
+			return FileMode::Create;
+
+		return FileMode::Open;
+	}
+
+	FileStream::FileStream(std::string const& path) :
+		FileStream(path, FileMode::Open, FileAccess::ReadWrite) {
+	}
+
+	FileStream::FileStream(std::string const& path, std::ios_base::openmode openMode) :
+		FileStream(path, ModeOf(openMode), AccessOf(openMode)) {
+	}
+
+	FileStream::~FileStream() {
+		Close();
+	}
+}
+
+#ifdef _WIN32
+namespace cs {
+	FileStream::FileStream(std::string const& path, FileMode mode, FileAccess access, FileOptions options, csint bufferSize) :
+		_canRead(access != FileAccess::Write),
+		_canWrite(access != FileAccess::Read) {
+
+		std::ios_base::openmode openMode = std::ios_base::binary;
+
+		if (_canRead)
+			openMode |= std::ios_base::in;
+
+		if (_canWrite)
+			openMode |= std::ios_base::out;
+
+		if (mode == FileMode::Create || mode == FileMode::Truncate)
+			openMode |= std::ios_base::trunc;
+		else if (mode == FileMode::Append)
+			openMode |= std::ios_base::app;
+
+		_fstream.open(path, openMode);
+
+		//in|out does not create files; create it first and reopen.
+		if (!_fstream.is_open() && _canWrite && (mode == FileMode::CreateNew || mode == FileMode::OpenOrCreate)) {
+			std::ofstream(path, std::ios_base::binary | std::ios_base::out);
+			_fstream.open(path, openMode);
+		}
+	}
+
+	bool FileStream::IsOpen() const {
+		return _fstream.is_open();
+	}
+
+	cslong FileStream::Length() {
+		if (!_fstream.is_open())
+			return -1;
+
+		const auto position = _fstream.tellg();
+		_fstream.seekg(0, std::ios_base::end);
+		const auto length = static_cast<cslong>(_fstream.tellg());
+		_fstream.seekg(position);
+
+		return length;
+	}
+
+	cslong FileStream::Position() {
+		if (!_fstream.is_open())
+			return -1;
+
+		return _fstream.tellg();
+	}
+
+	void FileStream::Position(cslong value) {
+		if (!_fstream.is_open() || value < 0)
+			return;
+
+		_fstream.seekg(value);
+	}
+
+	void FileStream::Flush() {
+		if (_fstream.is_open())
+			_fstream.flush();
+	}
+
+	void FileStream::Close() {
+		if (!_fstream.is_open())
+			return;
+
+		_fstream.close();
+	}
+
+	//A filebuf has a single position, so seekg moves the put position too.
+	cslong FileStream::Seek(cslong offset, SeekOrigin origin) {
+		if (!_fstream.is_open())
+			return -1;
+
+		switch (origin)
+		{
+		case cs::SeekOrigin::Begin:
+			_fstream.seekg(offset, std::ios_base::beg);
+			break;
+		case cs::SeekOrigin::Current:
+			_fstream.seekg(offset, std::ios_base::cur);
+			break;
+		case cs::SeekOrigin::End:
+			_fstream.seekg(offset, std::ios_base::end);
+			break;
+		default:
+			return -1;
+		}
+
+		return Position();
+	}
+
+	csint FileStream::Read(std::span<csbyte> buffer) {
+		if (!_fstream.is_open() || !_canRead)
+			return -1;
+
+		_fstream.read(reinterpret_cast<char*>(buffer.data()), static_cast<std::streamsize>(buffer.size()));
+		const auto n = static_cast<csint>(_fstream.gcount());
+
+		//A short read sets eof; clear it so the stream can still seek.
+		if (_fstream.eof())
+			_fstream.clear();
+
+		return n;
+	}
+
+	csint FileStream::ReadByte() {
+		if (!_fstream.is_open() || !_canRead)
+			return -1;
+
+		const auto value = _fstream.get();
+
+		if (value == std::char_traits<char>::eof()) {
+			_fstream.clear();
+			return -1;
+		}
+
+		return static_cast<csbyte>(value);
+	}
+
+	void FileStream::Write(std::span<const csbyte> buffer) {
+		if (!_fstream.is_open() || !_canWrite)
+			return;
+
+		_fstream.write(reinterpret_cast<char const*>(buffer.data()), static_cast<std::streamsize>(buffer.size()));
+	}
+}
+#else
+namespace cs {
+	static bool HasOption(FileOptions options, FileOptions option) {
+		return (static_cast<int>(options) & static_cast<int>(option)) != 0;
+	}
+
+	void FileStream::AlignedDeleter::operator()(csbyte* memory) const {
+		std::free(memory);
+	}
+
+	FileStream::FileStream(std::string const& path, FileMode mode, FileAccess access, FileOptions options, csint bufferSize) :
+		_canRead(access != FileAccess::Write),
+		_canWrite(access != FileAccess::Read) {
+
+		int flags = O_CLOEXEC;
+
+		switch (access) {
+		case FileAccess::Read:
+			flags |= O_RDONLY;
+			break;
+		case FileAccess::Write:
+			flags |= O_WRONLY;
+			break;
+		default:
+			flags |= O_RDWR;
+			break;
+		}
+
+		switch (mode) {
+		case FileMode::CreateNew:
+			flags |= O_CREAT | O_EXCL;
+			break;
+		case FileMode::Create:
+			flags |= O_CREAT | O_TRUNC;
+			break;
+		case FileMode::OpenOrCreate:
+		case FileMode::Append:
+			flags |= O_CREAT;
+			break;
+		case FileMode::Truncate:
+			flags |= O_TRUNC;
+			break;
+		default:
+			break;
+		}
+
+#ifdef O_DIRECT
+		_direct = HasOption(options, FileOptions::NoBuffering) && access == FileAccess::Read;
+
+		if (_direct) {
+			_descriptor = open(path.c_str(), flags | O_DIRECT);
+
+			//Some file systems (tmpfs among them) refuse O_DIRECT.
+			if (_descriptor < 0 && errno == EINVAL)
+				_direct = false;
+		}
+#endif
+
+		if (_descriptor < 0)
+			_descriptor = open(path.c_str(), flags, 0666);
+
+		if (_descriptor < 0)
+			return;
+
+		if (mode == FileMode::Append)
+			_position = Length();
+
+#ifdef POSIX_FADV_SEQUENTIAL
+		if (HasOption(options, FileOptions::SequentialScan))
+			posix_fadvise(_descriptor, 0, 0, POSIX_FADV_SEQUENTIAL);
+		else if (HasOption(options, FileOptions::RandomAccess))
+			posix_fadvise(_descriptor, 0, 0, POSIX_FADV_RANDOM);
+#endif
+
+		if (_canRead) {
+			const auto size = bufferSize < DirectAlignment ? DirectAlignment : bufferSize;
+			_bufferSize = (size + DirectAlignment - 1) / DirectAlignment * DirectAlignment;
+
+			void* memory = nullptr;
+
+			if (posix_memalign(&memory, DirectAlignment, static_cast<size_t>(_bufferSize)) != 0) {
+				Close();
+				return;
+			}
+
+			_buffer.reset(static_cast<csbyte*>(memory));
+		}
+	}
+
+	bool FileStream::IsOpen() const {
+		return _descriptor >= 0;
+	}
+
+	cslong FileStream::Length() {
+		struct stat status;
+
+		if (_descriptor < 0 || fstat(_descriptor, &status) != 0)
+			return -1;
+
+		return static_cast<cslong>(status.st_size);
+	}
+
+	cslong FileStream::Position() {
+		return _descriptor >= 0 ? _position : -1;
+	}
+
+	void FileStream::Position(cslong value) {
+		if (_descriptor >= 0 && value >= 0)
+			_position = value;
+	}
+
+	//Writes go straight to the descriptor, there is nothing to flush.
+	void FileStream::Flush() {
+	}
+
+	void FileStream::Close() {
+		if (_descriptor < 0)
+			return;
+
+		close(_descriptor);
+
+		_descriptor = -1;
+		_buffer.reset();
+		_bufferLength = 0;
+	}
+
+	cslong FileStream::Seek(cslong offset, SeekOrigin origin) {
+		if (_descriptor < 0)
+			return -1;
+
+		cslong position = 0;
+
+		switch (origin)
+		{
+		case cs::SeekOrigin::Begin:
+			position = offset;
+			break;
+		case cs::SeekOrigin::Current:
+			position = _position + offset;
+			break;
+		case cs::SeekOrigin::End:
+			position = Length() + offset;
+			break;
+		default:
+			return -1;
+		}
+
+		if (position < 0)
+			return -1;
+
+		_position = position;
+		return _position;
+	}
+
+	csint FileStream::CopyFromBuffer(std::span<csbyte> destination) {
+		if (_position < _bufferStart || _position >= _bufferStart + _bufferLength)
+			return 0;
+
+		const auto available = static_cast<size_t>(_bufferStart + _bufferLength - _position);
+		const auto n = available < destination.size() ? available : destination.size();
+
+		std::memcpy(destination.data(), _buffer.get() + (_position - _bufferStart), n);
+		_position += static_cast<cslong>(n);
+
+		return static_cast<csint>(n);
+	}
+
+	bool FileStream::FillBuffer(cslong start) {
+		ssize_t n;
+
+		do {
+			n = pread(_descriptor, _buffer.get(), static_cast<size_t>(_bufferSize), static_cast<off_t>(start));
+		} while (n < 0 && errno == EINTR);
+
+		_bufferStart = start;
+		_bufferLength = n > 0 ? static_cast<csint>(n) : 0;
+
+		return _position < _bufferStart + _bufferLength;
+	}
+
+	csint FileStream::Read(std::span<csbyte> buffer) {
+		if (_descriptor < 0 || !_canRead)
+			return -1;
+
+		size_t n = CopyFromBuffer(buffer);
+
+		while (n < buffer.size()) {
+			const auto destination = buffer.subspan(n);
+			ssize_t read;
+
+			if (_direct) {
+				//Large aligned requests land in the caller's memory, anything else
+				//goes through the aligned buffer.
+				const auto address = reinterpret_cast<uintptr_t>(destination.data());
+				const auto blocks = destination.size() / DirectAlignment * DirectAlignment;
+
+				if (address % DirectAlignment == 0 && _position % DirectAlignment == 0 && blocks >= static_cast<size_t>(_bufferSize)) {
+					do {
+						read = pread(_descriptor, destination.data(), blocks, static_cast<off_t>(_position));
+					} while (read < 0 && errno == EINTR);
+
+					if (read <= 0)
+						break;
+
+					_position += read;
+					n += static_cast<size_t>(read);
+					continue;
+				}
+
+				if (!FillBuffer(_position / DirectAlignment * DirectAlignment))
+					break;
+
+				n += CopyFromBuffer(destination);
+				continue;
+			}
+
+			if (destination.size() >= static_cast<size_t>(_bufferSize)) {
+				do {
+					read = pread(_descriptor, destination.data(), destination.size(), static_cast<off_t>(_position));
+				} while (read < 0 && errno == EINTR);
+
+				if (read <= 0)
+					break;
+
+				_position += read;
+				n += static_cast<size_t>(read);
+				continue;
+			}
+
+			//The rest of the request and the next buffer in one call.
+			iovec vectors[2];
+			vectors[0].iov_base = destination.data();
+			vectors[0].iov_len = destination.size();
+			vectors[1].iov_base = _buffer.get();
+			vectors[1].iov_len = static_cast<size_t>(_bufferSize);
+
+			do {
+				read = preadv(_descriptor, vectors, 2, static_cast<off_t>(_position));
+			} while (read < 0 && errno == EINTR);
+
+			if (read <= 0)
+				break;
+
+			const auto taken = static_cast<size_t>(read) < destination.size() ? static_cast<size_t>(read) : destination.size();
+
+			_position += static_cast<cslong>(taken);
+			_bufferStart = _position;
+			_bufferLength = static_cast<csint>(static_cast<size_t>(read) - taken);
+			n += taken;
+		}
+
+		return static_cast<csint>(n);
+	}
+
+	csint FileStream::ReadByte() {
+		csbyte value;
+		return Read(std::span<csbyte>(&value, 1)) == 1 ? value : -1;
+	}
+
+	void FileStream::Write(std::span<const csbyte> buffer) {
+		if (_descriptor < 0 || !_canWrite)
+			return;
+
+		//The written range may be buffered; drop the buffer rather than patch it.
+		_bufferLength = 0;
+
+		size_t n = 0;
+
+		while (n < buffer.size()) {
+			const auto written = pwrite(_descriptor, buffer.data() + n, buffer.size() - n, static_cast<off_t>(_position));
+
+			if (written < 0 && errno == EINTR)
+				continue;
+
+			if (written <= 0)
+				return;
+
+			_position += written;
+			n += static_cast<size_t>(written);
+		}
+	}
+}
+#endif
\ No newline at end of file
@@ -2,6 +2,8 @@
 #define CS_STREAM_STREAM_HPP
 
 #include <cmath>
+#include <cstring>
+#include <span>
 #include <vector>
 #include <memory>
 #include <string>
@@ -15,6 +17,8 @@
 namespace cs {
 	class Stream {
 	public:
+		virtual ~Stream() = default;
+
 		virtual bool CanRead() { return false; }
 		virtual bool CanWrite() { return false; }
 		virtual bool CanSeek() { return false; }
@@ -33,6 +37,23 @@ namespace cs {
 		virtual csint ReadByte() { return 0; }
 		virtual void Write(std::vector<csbyte>& buffer, csint offset, csint count) {}
 		virtual void WriteByte(csbyte value) {}
+
+		//Reads up to buffer.size() bytes into the caller's memory. The default goes
+		//through a temporary vector; streams that can do better override it.
+		virtual csint Read(std::span<csbyte> buffer) {
+			std::vector<csbyte> temp(buffer.size());
+			const auto n = Read(temp, 0, toint(temp.size()));
+
+			if (n > 0)
+				std::memcpy(buffer.data(), temp.data(), static_cast<size_t>(n));
+
+			return n;
+		}
+
+		virtual void Write(std::span<const csbyte> buffer) {
+			std::vector<csbyte> temp(buffer.begin(), buffer.end());
+			Write(temp, 0, toint(temp.size()));
+		}
 	};
 
 	using PtrStream = std::shared_ptr<cs::Stream>;	
@@ -40,27 +61,36 @@ namespace cs {
 
 //MemoryStream
 namespace cs {
+	// https://referencesource.microsoft.com/#mscorlib/system/io/memorystream.cs
+	//
+	// The stream works on a raw block of memory that is either its own vector or
+	// memory handed to it: a span the caller keeps alive, or a span kept alive by
+	// an owner pointer. Wrapped memory is never copied and cannot grow.
 	class MemoryStream : public Stream {
 	public:
-		constexpr MemoryStream(csint capacity = 0) :
-			_buffer(capacity != 0 ? std::vector<csbyte>(capacity) : std::vector<csbyte>()),
-			_capacity(capacity),
+		MemoryStream(csint capacity = 0) :
+			_buffer(static_cast<size_t>(capacity > 0 ? capacity : 0)),
+			_data(_buffer.data()),
+			_capacity(capacity > 0 ? capacity : 0),
+			_expandable(true),
 			_writable(true),
 			_exposable(true),
 			_isOpen(true) {
 		}
 
-		constexpr MemoryStream(std::vector<csbyte> const& buffer, bool writable = true) :
+		MemoryStream(std::vector<csbyte> const& buffer, bool writable = true) :
 			_buffer(buffer),
-			_length(buffer.size()),
-			_capacity(buffer.size()),
+			_data(_buffer.data()),
+			_length(toint(buffer.size())),
+			_capacity(toint(buffer.size())),
 			_writable(writable),
 			_isOpen(true) {
 		}
 
-		constexpr MemoryStream(std::vector<csbyte> const& buffer, csint index, csint count,
+		MemoryStream(std::vector<csbyte> const& buffer, csint index, csint count,
 			bool writable = true, bool publiclyVisible = false) :
 			_buffer(buffer),
+			_data(_buffer.data()),
 			_origin(index),
 			_position(index),
 			_length(index + count),
@@ -70,6 +100,39 @@ namespace cs {
 			_isOpen(true) {
 		}
 
+		//Takes over the vector without copying it.
+		MemoryStream(std::vector<csbyte>&& buffer, bool writable = true) :
+			_buffer(std::move(buffer)),
+			_data(_buffer.data()),
+			_length(toint(_buffer.size())),
+			_capacity(toint(_buffer.size())),
+			_writable(writable),
+			_isOpen(true) {
+		}
+
+		//Wraps caller memory, which must outlive the stream.
+		MemoryStream(std::span<csbyte> buffer, bool writable = true, bool publiclyVisible = false) :
+			_data(buffer.data()),
+			_length(toint(buffer.size())),
+			_capacity(toint(buffer.size())),
+			_writable(writable),
+			_exposable(publiclyVisible),
+			_isOpen(true) {
+		}
+
+		//Read-only view; owner, when given, keeps the memory alive as long as the stream.
+		MemoryStream(std::span<const csbyte> buffer, std::shared_ptr<const void> owner = nullptr) :
+			_owner(owner),
+			_data(const_cast<csbyte*>(buffer.data())),
+			_length(toint(buffer.size())),
+			_capacity(toint(buffer.size())),
+			_isOpen(true) {
+		}
+
+		//_data may point into _buffer, so copies would alias the source.
+		MemoryStream(MemoryStream const&) = delete;
+		MemoryStream& operator=(MemoryStream const&) = delete;
+
 		virtual constexpr bool CanRead() override {
 			return _isOpen;
 		}
@@ -97,13 +160,15 @@ namespace cs {
 		}
 
 		virtual constexpr void Position(cslong value) override {
-			if (value > MemStreamMaxLength)
+			if (value < 0 || value > MemStreamMaxLength - _origin)
 				return;
 
 			_position = _origin + toint(value);
 		}
 
-		virtual constexpr void Close() override {
+		//The memory, and its owner, are kept until the stream is destroyed
+		//so a BinaryReader viewing it stays valid.
+		virtual void Close() override {
 			_isOpen = false;
 			_writable = false;
 			_expandable = false;
@@ -112,11 +177,31 @@ namespace cs {
 		virtual constexpr void Flush() override {
 		}
 
-		virtual std::vector<csbyte> GetBuffer() {
+		//The whole underlying memory, without copying; empty unless the
+		//stream was created as publicly visible.
+		virtual std::span<csbyte> GetBuffer() {
 			if (!_exposable)
-				return std::vector<csbyte>();
+				return std::span<csbyte>();
+
+			return std::span<csbyte>(_data, static_cast<size_t>(_capacity));
+		}
+
+		//The stream contents, from the origin to Length().
+		std::span<const csbyte> GetView() const {
+			return std::span<const csbyte>(_data + _origin, static_cast<size_t>(_length - _origin));
+		}
+
+		//The bytes from Position() to the end of the stream.
+		std::span<const csbyte> Remaining() const {
+			if (_position >= _length)
+				return std::span<const csbyte>();
 
-			return _buffer;
+			return std::span<const csbyte>(_data + _position, static_cast<size_t>(_length - _position));
+		}
+
+		std::vector<csbyte> ToArray() const {
+			const auto view = GetView();
+			return std::vector<csbyte>(view.begin(), view.end());
 		}
 
 		virtual csint Capacity() {
@@ -136,27 +221,21 @@ namespace cs {
 			if (!_expandable && (value != Capacity()))
 				return;
 
-
 			if (_expandable && value != _capacity) {
-				if (value > 0) {
-					_buffer.resize(value);
-				}
-				else {
-					_buffer.clear();
-				}
-
+				_buffer.resize(static_cast<size_t>(value > 0 ? value : 0));
+				_data = _buffer.data();
 				_capacity = value;
 			}
 		}
 
 		virtual csint ReadByte() override {
-			if (_isOpen)
+			if (!_isOpen)
 				return -1;
 
 			if (_position >= _length)
 				return -1;
 
-			return _buffer[_position++];
+			return _data[_position++];
 		}
 
 		virtual cslong Seek(cslong offset, SeekOrigin loc) override {
@@ -199,116 +278,90 @@ namespace cs {
 				return -1;
 			}
 
-			return _position;
+			return _position - _origin;
 		}
 
 		virtual csint Read(std::vector<csbyte>& buffer, csint offset, csint count) override {
-			if (!_isOpen)
-				return 0;
+			if (offset < 0 || count < 0 || buffer.size() - offset < static_cast<size_t>(count))
+				return -1;
 
-			csint n = _length - _position;
-			if (n > count)
-				n = count;
+			return Read(std::span<csbyte>(buffer.data() + offset, static_cast<size_t>(count)));
+		}
 
-			if (n <= 0)
+		virtual csint Read(std::span<csbyte> buffer) override {
+			if (!_isOpen)
 				return 0;
 
-			if (n <= 8) {
-				csint byteCount = n;
+			const auto remaining = Remaining();
+			const auto n = remaining.size() < buffer.size() ? remaining.size() : buffer.size();
 
-				while (--byteCount >= 0)
-					buffer[offset + byteCount] = _buffer[_position + byteCount];
-			}
-			else {
-				for (size_t i = 0; i < n; ++i) {
-					buffer[offset + i] = _buffer[_position + i];
-				}
-			}
+			if (n == 0)
+				return 0;
 
-			_position += n;
+			std::memcpy(buffer.data(), remaining.data(), n);
+			_position += toint(n);
 
-			return n;
+			return toint(n);
 		}
 
 		virtual void Write(std::vector<csbyte>& buffer, csint offset, csint count) override {
-			if (!_isOpen)
+			if (offset < 0 || count < 0 || buffer.size() - offset < static_cast<size_t>(count))
 				return;
 
-			if (!_writable)
+			Write(std::span<const csbyte>(buffer.data() + offset, static_cast<size_t>(count)));
+		}
+
+		virtual void Write(std::span<const csbyte> buffer) override {
+			if (!_isOpen || !_writable)
 				return;
 
-			csint i = _position + count;
+			const auto count = toint(buffer.size());
 
-			if (i < 0)
+			if (count > MemStreamMaxLength - _position)
 				return;
 
-			if (i > _length) {
-				bool mustZero = _position > _length;
+			const auto i = _position + count;
 
-				if (i > _capacity) {
-					bool allocatedNewArray = EnsureCapacity(i);
+			if (i > _length) {
+				if (i > _capacity && !EnsureCapacity(i))
+					return;
 
-					if (allocatedNewArray) {
-						mustZero = false;
-					}
-				}
-				if (mustZero) {
-					for (size_t j = _length; j < (i - _length); ++j) {
-						_buffer[j] = 0;
-					}
-				}
+				if (_position > _length)
+					std::memset(_data + _length, 0, static_cast<size_t>(_position - _length));
 
 				_length = i;
 			}
-			if ((count <= 8) && (buffer != _buffer)) {
-				csint byteCount = count;
 
-				while (--byteCount >= 0) {
-					_buffer[_position + byteCount] = buffer[offset + byteCount];
-				}
-			}
-			else {
-				for (size_t j = 0; j < count; ++j) {
-					buffer[offset + j] = _buffer[_position + j];
-				}
-			}
+			//memmove, the source may be a view of this same stream.
+			if (count > 0)
+				std::memmove(_data + _position, buffer.data(), static_cast<size_t>(count));
 
 			_position = i;
 		}
 
 		virtual void WriteByte(csbyte value) override {
-			if (!_isOpen)
-				return;
-
-			if (_writable)
+			if (!_isOpen || !_writable)
 				return;
 
 			if (_position >= _length) {
-				csint newLength = _position + 1;
-				bool mustZero = _position > _length;
-
-				if (newLength >= _capacity) {
-					bool allocatedNewArray = EnsureCapacity(newLength);
+				const auto newLength = _position + 1;
 
-					if (allocatedNewArray) {
-						mustZero = false;
-					}
-				}
+				if (newLength > _capacity && !EnsureCapacity(newLength))
+					return;
 
-				if (mustZero) {
-					for (size_t j = _length; j < (_position - _length); ++j) {
-						_buffer[j] = 0;
-					}
-				}
+				if (_position > _length)
+					std::memset(_data + _length, 0, static_cast<size_t>(_position - _length));
 
 				_length = newLength;
 			}
 
-			_buffer[_position++] = value;
+			_data[_position++] = value;
 		}
 
 	private:
 		std::vector<csbyte> _buffer;
+		std::shared_ptr<const void> _owner;
+		csbyte* _data{ nullptr };
 		csint _origin{ 0 };
 		csint _position{ 0 };
 		csint _length{ 0 };
@@ -320,26 +373,30 @@ namespace cs {
 
 		static constexpr csint MemStreamMaxLength = int_max;
 
+		//Returns false when the stream cannot grow to value bytes.
 		bool EnsureCapacity(csint value) {
 			if (value < 0)
 				return false;
 
-			if (value > _capacity) {
-				csint newCapacity = xna::Math::Max<csint>(value, 256);
+			if (value <= _capacity)
+				return true;
 
-				if (newCapacity < _capacity * 2) {
-					newCapacity = _capacity * 2;
-				}
+			if (!_expandable)
+				return false;
 
-				if (touint(_capacity * 2) > Array::MaxLength) {
-					newCapacity = xna::Math::Max(value, Array::MaxLength);
-				}
+			csint newCapacity = xna::Math::Max<csint>(value, 256);
 
-				Capacity(newCapacity);
+			if (newCapacity < _capacity * 2) {
+				newCapacity = _capacity * 2;
+			}
 
-				return true;
+			if (touint(_capacity * 2) > Array::MaxLength) {
+				newCapacity = xna::Math::Max(value, Array::MaxLength);
 			}
-			return false;
+
+			Capacity(newCapacity);
+
+			return _capacity >= value;
 		}
 	};
 
@@ -347,62 +404,53 @@ namespace cs {
 }
 
 //FileStream
-namespace cs {	
-
-	class FileStream : Stream {
+namespace cs {
+	// On POSIX the stream owns a file descriptor and reads with pread/preadv, so the
+	// position lives here and Seek never calls into the kernel. Reads smaller than
+	// the buffer are served from an aligned buffer of its own; a miss asks for the
+	// caller's bytes and the next buffer in a single preadv, and requests of at
+	// least a buffer go straight into the caller's memory. Writes are unbuffered.
+	//
+	// FileOptions::SequentialScan and RandomAccess become posix_fadvise hints, and
+	// NoBuffering opens read-only files with O_DIRECT, reading whole aligned blocks.
+	//
+	// On Windows the stream wraps a std::fstream.
+	class FileStream : public Stream {
 	public:
-		FileStream(std::string const& file) {
-			_fstream.open(file, std::ios_base::in | std::ios_base::out | std::ios_base::binary);
-		}
+		static constexpr csint DefaultBufferSize = 64 * 1024;
+		//O_DIRECT transfers are aligned to the logical block size; 4096 covers current disks.
+		static constexpr csint DirectAlignment = 4096;
 
-		FileStream(std::string const& file, std::ios_base::openmode mode) {
-			_fstream.open(file, mode);
-		}
+		//Opens an existing file for reading and writing.
+		FileStream(std::string const& path);
+		FileStream(std::string const& path, std::ios_base::openmode mode);
+		FileStream(std::string const& path, FileMode mode, FileAccess access,
+			FileOptions options = FileOptions::None, csint bufferSize = DefaultBufferSize);
 
-		FileStream(std::string const& file, FileMode mode, FileAccess access) {
+		virtual ~FileStream() override;
 
-		}
+		FileStream(FileStream const&) = delete;
+		FileStream& operator=(FileStream const&) = delete;
 
-		virtual bool CanRead() override {
-			if (!_fstream.is_open())
-				return false;
+		bool IsOpen() const;
 
-			return true; 
+		virtual bool CanRead() override {
+			return IsOpen() && _canRead;
 		}
 
 		virtual bool CanWrite() override { 
-			if (!_fstream.is_open())
-				return false;
-
-			return true; 
+			return IsOpen() && _canWrite;
 		}
 
 		virtual bool CanSeek() override {
-			if (!_fstream.is_open())
-				return false;
-
-			return true; 
-		}
-
-		virtual cslong Length() override { 
-			return -1; 
-		}
-
-		virtual cslong Position() override {
-			if (!_fstream.is_open())
-				return -1;
-
-			return _fstream.tellg();
+			return IsOpen();
 		}
 
-		virtual void Position(cslong value) override {
-			if (!_fstream.is_open())
-				return;
+		virtual cslong Length() override;
+		virtual cslong Position() override;
+		virtual void Position(cslong value) override;
 
-			_fstream.seekg(value);
-		}
-
-		virtual constexpr void Flush() override {}
+		virtual void Flush() override;
 
 		virtual constexpr bool CanTimeout() override { 
 			return false; 
@@ -422,79 +470,30 @@ namespace cs {
 		virtual constexpr void WriteTimeout(csint value) override {
 		}
 
-		virtual void Close() override {
-			if (!_fstream.is_open())
-				return;
-
-			_fstream.close();
-		}
-
-		virtual cslong Seek(cslong offset, SeekOrigin origin) override { 
-			if (!_fstream.is_open())
-				return -1;
-
-			switch (origin)
-			{
-			case cs::SeekOrigin::Begin:
-				_fstream.seekp(offset, std::ios_base::_Seekdir::_Seekbeg);
-				break;
-			case cs::SeekOrigin::Current:
-				_fstream.seekp(offset, std::ios_base::_Seekdir::_Seekcur);
-				break;
-			case cs::SeekOrigin::End:
-				_fstream.seekp(offset, std::ios_base::_Seekdir::_Seekend);
-				break;
-			default:
-				return -1;
-				break;
-			}
-
-			return Position();
-		}
+		virtual void Close() override;
+		virtual cslong Seek(cslong offset, SeekOrigin origin) override;
 
 		virtual csint Read(std::vector<csbyte>& buffer, csint offset, csint count) override { 
-			if (!_fstream.is_open())
+			if (offset < 0 || count < 0 || buffer.size() - offset < static_cast<size_t>(count))
 				return -1;
 
-			csint n = Length() - Position();
-			
-			if (n > count)
-				n = count;
-
-			if (n <= 0)
-				return 0;			
-			
-			_fstream.seekp(offset, std::ios_base::_Seekdir::_Seekcur);
-			_fstream.read(reinterpret_cast<char*>(buffer.data()), n * sizeof(csbyte));
-
-			return n;
+			return Read(std::span<csbyte>(buffer.data() + offset, static_cast<size_t>(count)));
 		}
 
-		virtual csint ReadByte() override { 
-			if (!_fstream.is_open())
-				return -1;
-
-			char value;
-			_fstream.read(&value, sizeof(csbyte));
-
-			return value;
-		}
+		virtual csint Read(std::span<csbyte> buffer) override;
+		virtual csint ReadByte() override;
 
 		virtual void Write(std::vector<csbyte>& buffer, csint offset, csint count) override {
-			if (!_fstream.is_open())
-				return;
-
-			csint i = Position() + count;
-
-			if (i < 0)
+			if (offset < 0 || count < 0 || buffer.size() - offset < static_cast<size_t>(count))
 				return;
 
-			_fstream.seekp(offset, std::ios_base::_Seekdir::_Seekcur);
-			_fstream.write(reinterpret_cast<char*>(buffer.data()), count * sizeof(csbyte));
+			Write(std::span<const csbyte>(buffer.data() + offset, static_cast<size_t>(count)));
 		}
 
+		virtual void Write(std::span<const csbyte> buffer) override;
+
 		virtual void WriteByte(csbyte value) override {
-			_fstream.put(static_cast<char>(value));
+			Write(std::span<const csbyte>(&value, 1));
 		}
 
 		static std::shared_ptr<FileStream> Make(std::string const& path) {
@@ -502,7 +501,28 @@ namespace cs {
 		}
 
 	private:
+		bool _canRead{ false };
+		bool _canWrite{ false };
+
+#ifdef _WIN32
 		std::fstream _fstream;
+#else
+		struct AlignedDeleter {
+			void operator()(csbyte* memory) const;
+		};
+
+		int _descriptor{ -1 };
+		bool _direct{ false };
+		cslong _position{ 0 };
+		std::unique_ptr<csbyte[], AlignedDeleter> _buffer;
+		csint _bufferSize{ 0 };
+		//File range held in _buffer.
+		cslong _bufferStart{ 0 };
+		csint _bufferLength{ 0 };
+
+		csint CopyFromBuffer(std::span<csbyte> destination);
+		bool FillBuffer(cslong start);
+#endif
 	};
 
 	using PtrFileStream = std::shared_ptr<cs::FileStream>;
@@ -0,0 +1 @@
+#include "writer.hpp"
\ No newline at end of file
@@ -0,0 +1,213 @@
+#ifndef CS_STREAM_WRITER_HPP
+#define CS_STREAM_WRITER_HPP
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstring>
+#include <span>
+#include <string>
+#include <type_traits>
+#include "stream.hpp"
+
+//BinaryWriter
+namespace cs {
+	// https://referencesource.microsoft.com/#mscorlib/system/io/binarywriter.cs
+	//
+	// Writes go to an internal buffer and reach the stream on Flush(), when the
+	// buffer is full, or when the writer is destroyed. Spans at least a buffer
+	// long skip the buffer and go straight to the stream.
+	class BinaryWriter {
+	public:
+		static constexpr csint DefaultBufferSize = 4096;
+		static constexpr csint MinBufferSize = 16;
+
+		BinaryWriter(std::shared_ptr<Stream> stream, csint bufferSize = DefaultBufferSize) :
+			_stream(stream),
+			_buffer(static_cast<size_t>(bufferSize < MinBufferSize ? MinBufferSize : bufferSize)) {
+		}
+
+		virtual ~BinaryWriter() {
+			Flush();
+		}
+
+		virtual void Close() {
+			Flush();
+			_stream->Close();
+		}
+
+		//Returns the underlying stream with everything written so far flushed to it.
+		std::shared_ptr<Stream> BaseStream() {
+			Flush();
+			return _stream;
+		}
+
+		virtual void Flush() {
+			FlushBuffer();
+			_stream->Flush();
+		}
+
+		virtual cslong Seek(csint offset, SeekOrigin origin) {
+			Flush();
+			return _stream->Seek(offset, origin);
+		}
+
+		constexpr csint BufferSize() const {
+			return static_cast<csint>(_buffer.size());
+		}
+
+		void Write(bool value) {
+			Write(static_cast<csbyte>(value ? 1 : 0));
+		}
+
+		void Write(csbyte value) {
+			if (_bufferLength == BufferSize())
+				FlushBuffer();
+
+			_buffer[_bufferLength++] = value;
+		}
+
+		void Write(cssbyte value) {
+			Write(static_cast<csbyte>(value));
+		}
+
+		virtual void Write(char value) {
+			Write(static_cast<csbyte>(value));
+		}
+
+		void Write(csshort value) {
+			WritePrimitive(value);
+		}
+
+		void Write(csushort value) {
+			WritePrimitive(value);
+		}
+
+		void Write(csint value) {
+			WritePrimitive(value);
+		}
+
+		void Write(csuint value) {
+			WritePrimitive(value);
+		}
+
+		void Write(cslong value) {
+			WritePrimitive(value);
+		}
+
+		void Write(csulong value) {
+			WritePrimitive(value);
+		}
+
+		void Write(float value) {
+			WritePrimitive(value);
+		}
+
+		void Write(double value) {
+			WritePrimitive(value);
+		}
+
+		//Length-prefixed with a 7-bit encoded int, as BinaryReader::ReadString expects.
+		virtual void Write(std::string const& value) {
+			Write7BitEncodedInt(static_cast<csint>(value.size()));
+			Write(std::span<const csbyte>(reinterpret_cast<csbyte const*>(value.data()), value.size()));
+		}
+
+		//Without this overload string literals would pick Write(bool).
+		void Write(const char* value) {
+			Write(std::string(value));
+		}
+
+		virtual void Write(std::vector<char> const& chars) {
+			Write(std::span<const csbyte>(reinterpret_cast<csbyte const*>(chars.data()), chars.size()));
+		}
+
+		virtual void Write(std::vector<csbyte> const& buffer, csint index, csint count) {
+			if (index < 0 || count < 0 || buffer.size() - index < static_cast<size_t>(count))
+				return;
+
+			Write(std::span<const csbyte>(buffer.data() + index, static_cast<size_t>(count)));
+		}
+
+		virtual void Write(std::vector<csbyte> const& buffer) {
+			Write(std::span<const csbyte>(buffer));
+		}
+
+		void Write(std::span<const csbyte> buffer) {
+			const auto count = static_cast<csint>(buffer.size());
+
+			if (count <= BufferSize() - _bufferLength) {
+				if (count > 0)
+					std::memcpy(_buffer.data() + _bufferLength, buffer.data(), buffer.size());
+
+				_bufferLength += count;
+				return;
+			}
+
+			FlushBuffer();
+
+			if (count >= BufferSize()) {
+				_stream->Write(buffer);
+				return;
+			}
+
+			std::memcpy(_buffer.data(), buffer.data(), buffer.size());
+			_bufferLength = count;
+		}
+
+		virtual void Write7BitEncodedInt(csint value) {
+			auto uValue = static_cast<csuint>(value);
+
+			while (uValue > 0x7Fu) {
+				Write(static_cast<csbyte>(uValue | ~0x7Fu));
+				uValue >>= 7;
+			}
+
+			Write(static_cast<csbyte>(uValue));
+		}
+
+		virtual void Write7BitEncodedInt64(cslong value) {
+			auto uValue = static_cast<csulong>(value);
+
+			while (uValue > 0x7Fu) {
+				Write(static_cast<csbyte>(uValue | ~0x7Ful));
+				uValue >>= 7;
+			}
+
+			Write(static_cast<csbyte>(uValue));
+		}
+
+	private:
+		std::shared_ptr<Stream> _stream;
+		std::vector<csbyte> _buffer;
+		csint _bufferLength{ 0 };
+
+		template <typename T>
+		void WritePrimitive(T value) {
+			static_assert(std::is_trivially_copyable_v<T>);
+
+			if constexpr (std::endian::native == std::endian::big && sizeof(T) > 1) {
+				auto bytes = std::bit_cast<std::array<csbyte, sizeof(T)>>(value);
+				std::reverse(bytes.begin(), bytes.end());
+				value = std::bit_cast<T>(bytes);
+			}
+
+			if (BufferSize() - _bufferLength < static_cast<csint>(sizeof(T)))
+				FlushBuffer();
+
+			std::memcpy(_buffer.data() + _bufferLength, &value, sizeof(T));
+			_bufferLength += sizeof(T);
+		}
+
+		//Hands the buffered bytes to the stream without flushing the stream itself.
+		void FlushBuffer() {
+			if (_bufferLength == 0)
+				return;
+
+			_stream->Write(std::span<const csbyte>(_buffer.data(), static_cast<size_t>(_bufferLength)));
+			_bufferLength = 0;
+		}
+	};
+}
+
+#endif
\ No newline at end of file
@@ -41,6 +41,7 @@ namespace cs {
 		template <typename T>
 		static Type TypeOf() {
 			Type type;
+			type.obj = typeid(T);
 			type.isArray = std::is_array<T>::value;
 			type.isIntegral = std::is_integral<T>::value;
 			type.isFloatingPoint = std::is_floating_point<T>::value;
@@ -107,4 +108,11 @@ namespace cs {
 	}
 }
 
+template <>
+struct std::hash<cs::Type> {
+	size_t operator()(cs::Type const& type) const noexcept {
+		return std::hash<std::type_index>()(type.TypeIndex());
+	}
+};
+
 #endif
\ No newline at end of file
@@ -1 +1,254 @@
-#include "curve.hpp"
\ No newline at end of file
+#include "curve.hpp"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define XNA_CURVE_SSE2
+#endif
+
+namespace xna {
+	//Hermite inputs for a block of samples, one array per term. A sample whose
+	//value is already known (a Constant or Linear loop, or a Step key) keeps
+	//it in Value0 with every other term zero, so the kernel passes it through.
+	struct CurveHermiteBlock {
+		static constexpr size_t Size = 128;
+
+		//Positions mapped into the key range by the loop types.
+		double Position[Size];
+		double Amount[Size];
+		double Value0[Size];
+		double Value1[Size];
+		double TangentOut[Size];
+		double TangentIn[Size];
+		double Offset[Size];
+
+		constexpr void SetValue(size_t index, double value) {
+			Amount[index] = 0.0;
+			Value0[index] = value;
+			Value1[index] = 0.0;
+			TangentOut[index] = 0.0;
+			TangentIn[index] = 0.0;
+			Offset[index] = 0.0;
+		}
+	};
+
+	//The loop types of a curve, resolved once per batch into the constants
+	//Curve::MapPosition branches on for every call. A side that cycles maps a
+	//position p to first + r, where r = p - (first + cycle * timeRange), or to
+	//last - r on odd cycles when it oscillates, shifted by OffsetScale * cycle.
+	struct CurveLoopMap {
+		double First;
+		double Last;
+		double TimeRange;
+		double InvTimeRange;
+		//(last value - first value) for CycleOffset, 0 otherwise.
+		double PreOffsetScale;
+		double PostOffsetScale;
+		bool PreOscillate;
+		bool PostOscillate;
+	};
+
+	//Scalar form of the mapping, with MapPosition's arithmetic.
+	static void MapLoopPosition(CurveLoopMap const& map, double position, double& t, double& offset) {
+		const auto below = position < map.First;
+
+		if (!below && !(map.Last < position)) {
+			t = position;
+			offset = 0.0;
+			return;
+		}
+
+		auto num = (position - map.First) * map.InvTimeRange;
+
+		if (num < 0.0)
+			--num;
+
+		const auto cycle = static_cast<double>(static_cast<cslong>(num));
+		const auto r = position - (map.First + cycle * map.TimeRange);
+		const auto oscillate = below ? map.PreOscillate : map.PostOscillate;
+
+		t = oscillate && (static_cast<csint>(cycle) & 1) != 0 ? map.Last - r : map.First + r;
+		offset = (below ? map.PreOffsetScale : map.PostOffsetScale) * cycle;
+	}
+
+	//Maps a block of positions without branching on the loop types, two at a
+	//time. Pairs whose cycle count does not fit the int32 conversion take the
+	//scalar path, so results match MapLoopPosition exactly.
+	static void MapLoopBlock(CurveLoopMap const& map, double const* positions, size_t count, CurveHermiteBlock& block) {
+		size_t i = 0;
+#ifdef XNA_CURVE_SSE2
+		const auto first = _mm_set1_pd(map.First);
+		const auto last = _mm_set1_pd(map.Last);
+		const auto timeRange = _mm_set1_pd(map.TimeRange);
+		const auto invTimeRange = _mm_set1_pd(map.InvTimeRange);
+		const auto preOffsetScale = _mm_set1_pd(map.PreOffsetScale);
+		const auto postOffsetScale = _mm_set1_pd(map.PostOffsetScale);
+		const auto preOscillate = _mm_castsi128_pd(_mm_set1_epi32(map.PreOscillate ? -1 : 0));
+		const auto postOscillate = _mm_castsi128_pd(_mm_set1_epi32(map.PostOscillate ? -1 : 0));
+		const auto zero = _mm_setzero_pd();
+		const auto one = _mm_set1_pd(1.0);
+		const auto intMin = _mm_set1_pd(-2147483648.0);
+		const auto intLimit = _mm_set1_pd(2147483648.0);
+
+		for (; i + 2 <= count; i += 2) {
+			const auto position = _mm_loadu_pd(positions + i);
+			const auto below = _mm_cmplt_pd(position, first);
+			const auto outside = _mm_or_pd(below, _mm_cmplt_pd(last, position));
+
+			auto num = _mm_mul_pd(_mm_sub_pd(position, first), invTimeRange);
+			num = _mm_sub_pd(num, _mm_and_pd(_mm_cmplt_pd(num, zero), one));
+
+			//Truncation is exact for -2^31 < num < 2^31; NaN fails both tests.
+			const auto fits = _mm_and_pd(_mm_cmpgt_pd(num, intMin), _mm_cmplt_pd(num, intLimit));
+
+			if (_mm_movemask_pd(_mm_andnot_pd(fits, outside)) != 0) {
+				MapLoopPosition(map, positions[i], block.Position[i], block.Offset[i]);
+				MapLoopPosition(map, positions[i + 1], block.Position[i + 1], block.Offset[i + 1]);
+				continue;
+			}
+
+			const auto cycles = _mm_cvttpd_epi32(num);
+			const auto cycle = _mm_cvtepi32_pd(cycles);
+			const auto r = _mm_sub_pd(position, _mm_add_pd(first, _mm_mul_pd(cycle, timeRange)));
+
+			const auto odd = _mm_cmpeq_epi32(_mm_and_si128(cycles, _mm_set1_epi32(1)), _mm_set1_epi32(1));
+			const auto oddLanes = _mm_castsi128_pd(_mm_shuffle_epi32(odd, _MM_SHUFFLE(1, 1, 0, 0)));
+			const auto oscillate = _mm_or_pd(_mm_and_pd(below, preOscillate), _mm_andnot_pd(below, postOscillate));
+			const auto mirror = _mm_and_pd(oddLanes, oscillate);
+
+			const auto cycled = _mm_or_pd(_mm_and_pd(mirror, _mm_sub_pd(last, r)), _mm_andnot_pd(mirror, _mm_add_pd(first, r)));
+			const auto offsetScale = _mm_or_pd(_mm_and_pd(below, preOffsetScale), _mm_andnot_pd(below, postOffsetScale));
+
+			_mm_storeu_pd(block.Position + i, _mm_or_pd(_mm_and_pd(outside, cycled), _mm_andnot_pd(outside, position)));
+			_mm_storeu_pd(block.Offset + i, _mm_and_pd(outside, _mm_mul_pd(offsetScale, cycle)));
+		}
+#endif
+		for (; i < count; ++i)
+			MapLoopPosition(map, positions[i], block.Position[i], block.Offset[i]);
+	}
+
+	//Same terms, in the same order, as Curve::Hermite so both paths agree bit for bit.
+	static void EvaluateHermiteBlock(CurveHermiteBlock const& block, size_t count, double* results) {
+		size_t i = 0;
+#ifdef XNA_CURVE_SSE2
+		const auto one = _mm_set1_pd(1.0);
+		const auto two = _mm_set1_pd(2.0);
+		const auto three = _mm_set1_pd(3.0);
+		const auto minusTwo = _mm_set1_pd(-2.0);
+
+		for (; i + 2 <= count; i += 2) {
+			const auto t = _mm_loadu_pd(block.Amount + i);
+			const auto num1 = _mm_mul_pd(t, t);
+			const auto num2 = _mm_mul_pd(num1, t);
+			const auto h00 = _mm_add_pd(_mm_sub_pd(_mm_mul_pd(two, num2), _mm_mul_pd(three, num1)), one);
+			const auto h01 = _mm_add_pd(_mm_mul_pd(minusTwo, num2), _mm_mul_pd(three, num1));
+			const auto h10 = _mm_add_pd(_mm_sub_pd(num2, _mm_mul_pd(two, num1)), t);
+			const auto h11 = _mm_sub_pd(num2, num1);
+
+			auto value = _mm_mul_pd(_mm_loadu_pd(block.Value0 + i), h00);
+			value = _mm_add_pd(value, _mm_mul_pd(_mm_loadu_pd(block.Value1 + i), h01));
+			value = _mm_add_pd(value, _mm_mul_pd(_mm_loadu_pd(block.TangentOut + i), h10));
+			value = _mm_add_pd(value, _mm_mul_pd(_mm_loadu_pd(block.TangentIn + i), h11));
+
+			_mm_storeu_pd(results + i, _mm_add_pd(_mm_loadu_pd(block.Offset + i), value));
+		}
+#endif
+		for (; i < count; ++i) {
+			const auto t = block.Amount[i];
+			const auto num1 = t * t;
+			const auto num2 = num1 * t;
+
+			results[i] = block.Offset[i] + (block.Value0[i] * (2.0 * num2 - 3.0 * num1 + 1.0)
+				+ block.Value1[i] * (-2.0 * num2 + 3.0 * num1)
+				+ block.TangentOut[i] * (num2 - 2.0 * num1 + t)
+				+ block.TangentIn[i] * (num2 - num1));
+		}
+	}
+
+	void Curve::Evaluate(std::span<const double> positions, std::span<double> results) {
+		const auto count = std::min(positions.size(), results.size());
+
+		if (keys.Count() <= 1) {
+			std::fill_n(results.begin(), count, keys.Count() == 0 ? 0.0 : keys.Index(0).Value());
+			return;
+		}
+
+		if (!keys.IsCacheAvailable())
+			keys.ComputeCacheValues();
+
+		auto const& firstKey = keys.Index(0);
+		auto const& lastKey = keys.Index(keys.Count() - 1);
+		const auto cycleOffset = lastKey.Value() - firstKey.Value();
+
+		const CurveLoopMap map{
+			firstKey.Position(),
+			lastKey.Position(),
+			keys.TimeRange(),
+			keys.InvTimeRange(),
+			preLoop == CurveLoopType::CycleOffset ? cycleOffset : 0.0,
+			postLoop == CurveLoopType::CycleOffset ? cycleOffset : 0.0,
+			preLoop == CurveLoopType::Oscillate,
+			postLoop == CurveLoopType::Oscillate,
+		};
+
+		//Constant and Linear give the value outright instead of a position.
+		const auto preValue = preLoop == CurveLoopType::Constant || preLoop == CurveLoopType::Linear;
+		const auto postValue = postLoop == CurveLoopType::Constant || postLoop == CurveLoopType::Linear;
+
+		const auto sorted = std::is_sorted(positions.begin(), positions.begin() + count);
+		CurveHermiteBlock block;
+		size_t segment = 0;
+		double previous = 0.0;
+
+		for (size_t begin = 0; begin < count; begin += CurveHermiteBlock::Size) {
+			const auto blockCount = std::min(CurveHermiteBlock::Size, count - begin);
+
+			MapLoopBlock(map, positions.data() + begin, blockCount, block);
+
+			for (size_t i = 0; i < blockCount; ++i) {
+				const auto position = positions[begin + i];
+
+				if (preValue && position < map.First) {
+					block.SetValue(i, preLoop == CurveLoopType::Constant
+						? firstKey.Value()
+						: firstKey.Value() - firstKey.TangentIn() * (firstKey.Position() - position));
+					continue;
+				}
+
+				if (postValue && map.Last < position) {
+					block.SetValue(i, postLoop == CurveLoopType::Constant
+						? lastKey.Value()
+						: lastKey.Value() - lastKey.TangentOut() * (lastKey.Position() - position));
+					continue;
+				}
+
+				const auto t = block.Position[i];
+				const auto offset = block.Offset[i];
+
+				//Cycling loop types wrap a sorted batch back to the first key. A
+				//cursor hint only costs mispredictions on unsorted positions.
+				segment = sorted && t >= previous ? WalkSegment(t, segment) : FindSegment(t, 0);
+				previous = t;
+
+				auto const& k0 = keys.Index(segment - 1);
+				auto const& k1 = keys.Index(segment);
+				const auto length = k1.Position() - k0.Position();
+				const auto amount = length > 1E-10 ? (t - k0.Position()) / length : 0.0;
+
+				if (k0.Continuity() == CurveContinuity::Step) {
+					block.SetValue(i, amount >= 1.0 ? k1.Value() : k0.Value());
+					block.Offset[i] = offset;
+					continue;
+				}
+
+				block.Amount[i] = amount;
+				block.Value0[i] = k0.Value();
+				block.Value1[i] = k1.Value();
+				block.TangentOut[i] = k0.TangentOut();
+				block.TangentIn[i] = k1.TangentIn();
+				block.Offset[i] = offset;
+			}
+
+			EvaluateHermiteBlock(block, blockCount, results.data() + begin);
+		}
+	}
+}
\ No newline at end of file
@@ -5,6 +5,7 @@
 #include "csharp/integralnumeric.hpp"
 #include <cmath>
 #include <algorithm>
+#include <span>
 #include <vector>
 
 namespace xna {
@@ -56,11 +57,11 @@ namespace xna {
         }
 
         constexpr double TangentOut() const {
-            return tangentIn;
+            return tangentOut;
         }
 
         constexpr void TangentOut(double value) {
-            tangentIn = value;
+            tangentOut = value;
         }
 
         constexpr CurveContinuity Continuity() const {
@@ -106,20 +107,16 @@ namespace xna {
         constexpr void IsCacheAvailable(bool value) { isCacheAvailable = value; }
 
         constexpr size_t IndexOf(CurveKey const& item) const {
-            auto it = std::find(keys.begin(), keys.end(), item);
-            size_t index = -1;
-
-            if (it != keys.end())
-                index = it - keys.begin();
-
-            return index;
+            return binarySearch(item);
         }
 
         constexpr void RemoveAt(size_t index) {
             keys.erase(keys.begin() + index);
+            ComputeCacheValues();
         }
 
         constexpr CurveKey& Index(size_t index) { return keys[index]; }
+        constexpr CurveKey const& Index(size_t index) const { return keys[index]; }
 
         constexpr void Index(size_t index, CurveKey const& value) {
             if (keys[index].Position() == value.Position()) {
@@ -131,30 +128,52 @@ namespace xna {
             }
         }
 
-        constexpr void Add(CurveKey const& item) {
-            size_t index = binarySearch(item);
+        //Keys with the same position keep their insertion order. Keys added in
+        //position order are appended without a search or a shift. Returns the
+        //index of the new key.
+        constexpr size_t Add(CurveKey const& item) {
+            size_t index = keys.size();
 
-            if (index >= 0) {
-                while (index < keys.size() && item.Position() == keys[index].Position())
-                    ++index;
-            }
-            else
-                index = ~index;
+            if (!keys.empty() && item.Position() < keys.back().Position())
+                index = UpperBound(item.Position());
 
             keys.insert(keys.begin() + index, item);
-            isCacheAvailable = false;
+
+            if (index == 0 || index + 1 == keys.size())
+                ComputeCacheValues();
+
+            return index;
+        }
+
+        //Adds every key in items, sorting them once and merging them with the
+        //keys already present, instead of one search and shift per key.
+        void AddRange(std::span<const CurveKey> items) {
+            const auto count = keys.size();
+            keys.insert(keys.end(), items.begin(), items.end());
+
+            const auto middle = keys.begin() + count;
+            std::stable_sort(middle, keys.end(), CurveKey::BinaryCompare);
+            std::inplace_merge(keys.begin(), middle, keys.end(), CurveKey::BinaryCompare);
+
+            ComputeCacheValues();
+        }
+
+        //Index of the first key whose position is greater than position.
+        constexpr size_t UpperBound(double position) const {
+            const auto it = std::upper_bound(keys.begin(), keys.end(), position,
+                [](double value, CurveKey const& key) { return value < key.Position(); });
+
+            return static_cast<size_t>(it - keys.begin());
         }
 
         constexpr void Clear() {
             keys.clear();
             timeRange = invTimeRange = 0.0;
-            isCacheAvailable = false;
+            isCacheAvailable = true;
         }
 
         constexpr bool Contains(CurveKey const& item) {
-            //keys.contains(item);
-            auto finder = std::find(keys.begin(), keys.end(), item);
-            return finder != keys.end();
+            return binarySearch(item) != static_cast<size_t>(-1);
         }
 
         constexpr void CopyTo(std::vector<CurveKey>& array, size_t arrayIndex) {
@@ -167,10 +186,13 @@ namespace xna {
         constexpr bool IsReadOnly() const { return false; }
 
         constexpr bool Remove(CurveKey const& item) {
-            isCacheAvailable = false;
-            auto it = std::find(keys.begin(), keys.end(), item);
-            keys.erase(it);
-            return false;
+            const auto index = binarySearch(item);
+
+            if (index == static_cast<size_t>(-1))
+                return false;
+
+            RemoveAt(index);
+            return true;
         }
 
         constexpr CurveKeyCollection Clone() const {
@@ -193,7 +215,7 @@ namespace xna {
                     invTimeRange = 1.0 / timeRange;
             }
 
-            isCacheAvailable = false;
+            isCacheAvailable = true;
         }
 
     private:
@@ -202,34 +224,67 @@ namespace xna {
         double invTimeRange{ 0.0 };
         bool isCacheAvailable{ true };
 
-        //https://www.geeksforgeeks.org/binary-search/
-        constexpr size_t binarySearch(CurveKey const& To_Find) const {
-            size_t lo = 0;
-            size_t hi = keys.size() - 1;
-            size_t mid = 0;
-
-            while (hi - lo > 1) {
-                const auto mid = (hi + lo) / 2;
+        //Index of the first key equal to item, or size_t(-1). Only keys at
+        //item's position are compared.
+        constexpr size_t binarySearch(CurveKey const& item) const {
+            auto it = std::lower_bound(keys.begin(), keys.end(), item, CurveKey::BinaryCompare);
 
-                if (CurveKey::BinaryCompare(keys[mid], To_Find)) {
-                    lo = mid + 1;
-                }
-                else {
-                    hi = mid;
-                }
+            for (; it != keys.end() && it->Position() == item.Position(); ++it) {
+                if (*it == item)
+                    return static_cast<size_t>(it - keys.begin());
             }
 
-            if (keys[lo] == To_Find)
-                return lo;
-            else if (keys[hi] == To_Find)
-                return hi;
-
-            return -1;
+            return static_cast<size_t>(-1);
         }
     };
 }
 
 namespace xna {
+    //Remembers the segment found by the last Curve::Evaluate call, so that
+    //sampling a curve at increasing (or repeated) positions skips the search.
+    //Keep one per caller; a default constructed cursor has no segment yet.
+    struct CurveCursor {
+        size_t Segment{ 0 };
+    };
+
+    //Returns the index of the key that ends the segment containing t, in
+    //[1, count - 1], for count >= 2 keys sorted by position(index). A hint
+    //from a previous call and the segment after it are tried before a binary
+    //search over the key positions.
+    template <typename PositionOf>
+    constexpr size_t FindCurveSegment(double t, size_t hint, size_t count, PositionOf const& position) {
+        const auto last = count - 1;
+
+        const auto contains = [&](size_t index) {
+            return (index == 1 || position(index - 1) < t)
+                && (index == last || t <= position(index));
+        };
+
+        if (hint > 0 && hint <= last) {
+            if (contains(hint))
+                return hint;
+
+            if (hint < last && contains(hint + 1))
+                return hint + 1;
+        }
+
+        if (last == 1)
+            return 1;
+
+        //Branchless lower bound over keys [1, last - 1]; random positions
+        //would mispredict a branch on every step.
+        size_t base = 1;
+        size_t length = last - 1;
+
+        while (length > 1) {
+            const auto half = length / 2;
+            base = position(base + half) < t ? base + half : base;
+            length -= half;
+        }
+
+        return base + (position(base) < t ? 1 : 0);
+    }
+
 	class Curve {
 	public:
         constexpr Curve() = default;
@@ -289,8 +344,8 @@ namespace xna {
             case CurveTangent::Smooth: {
                 const auto num8 = num1 - num3;
                 const auto num9 = num5 - num7;
-                key.TangentIn(abs(num9) >= 1.1920928955078125E-07 
-                    ? num9 * abs(num3 - num2) / num8 
+                key.TangentIn(std::abs(num9) >= 1.1920928955078125E-07 
+                    ? num9 * std::abs(num3 - num2) / num8 
                     : 0.0);
                 break;
             }                
@@ -307,11 +362,11 @@ namespace xna {
             case CurveTangent::Smooth:{
                 const auto num10 = num1 - num3;
                 const auto num11 = num5 - num7;
-                if (abs(num11) < 1.1920928955078125E-07) {
+                if (std::abs(num11) < 1.1920928955078125E-07) {
                     key.TangentOut(0.0);
                     break;
                 }
-                key.TangentOut(num11 * abs(num1 - num2) / num10);
+                key.TangentOut(num11 * std::abs(num1 - num2) / num10);
                 break;
             }
             default:
@@ -329,24 +384,119 @@ namespace xna {
                 ComputeTangent(keyIndex, tangentInType, tangentOutType);
         }
 
+        //A key's tangents depend only on it and the keys either side, so
+        //these recompute those three instead of the whole curve.
+        void ComputeTangentsAround(size_t keyIndex, CurveTangent const& tangentType) {
+            ComputeTangentsAround(keyIndex, tangentType, tangentType);
+        }
+
+        void ComputeTangentsAround(size_t keyIndex, CurveTangent const& tangentInType, CurveTangent const& tangentOutType) {
+            if (keyIndex > 0)
+                ComputeTangent(keyIndex - 1, tangentInType, tangentOutType);
+
+            ComputeTangent(keyIndex, tangentInType, tangentOutType);
+            ComputeTangent(keyIndex + 1, tangentInType, tangentOutType);
+        }
+
+        size_t AddKey(CurveKey const& key, CurveTangent const& tangentType) {
+            return AddKey(key, tangentType, tangentType);
+        }
+
+        //Returns the index of the new key.
+        size_t AddKey(CurveKey const& key, CurveTangent const& tangentInType, CurveTangent const& tangentOutType) {
+            const auto keyIndex = keys.Add(key);
+            ComputeTangentsAround(keyIndex, tangentInType, tangentOutType);
+            return keyIndex;
+        }
+
+        void RemoveKey(size_t keyIndex, CurveTangent const& tangentType) {
+            RemoveKey(keyIndex, tangentType, tangentType);
+        }
+
+        //The keys either side of the removed one become neighbours.
+        void RemoveKey(size_t keyIndex, CurveTangent const& tangentInType, CurveTangent const& tangentOutType) {
+            if (keyIndex >= keys.Count())
+                return;
+
+            keys.RemoveAt(keyIndex);
+
+            if (keyIndex > 0)
+                ComputeTangent(keyIndex - 1, tangentInType, tangentOutType);
+
+            ComputeTangent(keyIndex, tangentInType, tangentOutType);
+        }
+
+        void AddKeys(std::span<const CurveKey> items, CurveTangent const& tangentType) {
+            AddKeys(items, tangentType, tangentType);
+        }
+
+        //Merges items in with one sort and recomputes every tangent once.
+        void AddKeys(std::span<const CurveKey> items, CurveTangent const& tangentInType, CurveTangent const& tangentOutType) {
+            keys.AddRange(items);
+            ComputeTangents(tangentInType, tangentOutType);
+        }
+
         double Evaluate(double position) {
+            CurveCursor cursor;
+            return Evaluate(position, cursor);
+        }
+
+        double Evaluate(double position, CurveCursor& cursor) {
             if (keys.Count() == 0)
                 return 0.0;
 
             if (keys.Count() == 1)
                 return keys.Index(0).Value();
 
-            auto& key1 = keys.Index(0);
-            auto& key2 = keys.Index(keys.Count() - 1);
-            auto t = position;
-            auto num1 = 0.0;
+            double t = 0.0;
+            double num1 = 0.0;
+            double value = 0.0;
+
+            if (!MapPosition(position, t, num1, value))
+                return value;
+
+            cursor.Segment = FindSegment(t, cursor.Segment);
+
+            auto const& k0 = keys.Index(cursor.Segment - 1);
+            auto const& k1 = keys.Index(cursor.Segment);
+            const auto length = k1.Position() - k0.Position();
+            const auto segment = length > 1E-10 ? (t - k0.Position()) / length : 0.0;
+
+            return num1 + Curve::Hermite(k0, k1, segment);
+        }
+
+        //Evaluates the curve at each of positions into the matching element of
+        //results, as many as the shorter span holds. Loop types are resolved
+        //once for the whole batch; each block of samples is then mapped into
+        //the key range and run through the Hermite step with SSE2, leaving
+        //only the key lookup and Constant or Linear loops scalar. Sorted
+        //positions walk the keys instead of searching them.
+        void Evaluate(std::span<const double> positions, std::span<double> results);
+
+	private:
+		CurveLoopType preLoop{ CurveLoopType::Constant };
+		CurveLoopType postLoop{ CurveLoopType::Constant };
+		CurveKeyCollection keys;
+        
+        //Maps position into the key range according to the loop types. Returns
+        //false when the loop type gives the curve value directly, in value.
+        //Otherwise t is the mapped position and offset the CycleOffset shift.
+        bool MapPosition(double position, double& t, double& offset, double& value) {
+            auto const& key1 = keys.Index(0);
+            auto const& key2 = keys.Index(keys.Count() - 1);
+            t = position;
+            offset = 0.0;
 
             if (t < key1.Position()) {
-                if (preLoop == CurveLoopType::Constant)
-                    return key1.Value();
+                if (preLoop == CurveLoopType::Constant) {
+                    value = key1.Value();
+                    return false;
+                }
 
-                if (preLoop == CurveLoopType::Linear)
-                    return key1.Value() - key1.TangentIn() * (key1.Position() - t);
+                if (preLoop == CurveLoopType::Linear) {
+                    value = key1.Value() - key1.TangentIn() * (key1.Position() - t);
+                    return false;
+                }
 
                 if (!keys.IsCacheAvailable())
                     keys.ComputeCacheValues();
@@ -359,7 +509,7 @@ namespace xna {
 
                 else if (preLoop == CurveLoopType::CycleOffset) {
                     t = key1.Position() + num3;
-                    num1 = (key2.Value() - key1.Value()) * num2;
+                    offset = (key2.Value() - key1.Value()) * num2;
                 }
                 else {
                     t = (static_cast<csint>(num2) & 1) != 0 ? key2.Position() - num3 : key1.Position() + num3;
@@ -367,11 +517,15 @@ namespace xna {
             }
             else if (key2.Position() < t)
             {
-                if (postLoop == CurveLoopType::Constant)
-                    return key2.Value();
+                if (postLoop == CurveLoopType::Constant) {
+                    value = key2.Value();
+                    return false;
+                }
                
-                if (postLoop == CurveLoopType::Linear)
-                    return key2.Value() - key2.TangentOut() * (key2.Position() - t);
+                if (postLoop == CurveLoopType::Linear) {
+                    value = key2.Value() - key2.TangentOut() * (key2.Position() - t);
+                    return false;
+                }
                
                 if (!keys.IsCacheAvailable())
                     keys.ComputeCacheValues();
@@ -384,58 +538,39 @@ namespace xna {
 
                 else if (postLoop == CurveLoopType::CycleOffset) {
                     t = key1.Position() + num5;
-                    num1 = (key2.Value() - key1.Value()) * num4;
+                    offset = (key2.Value() - key1.Value()) * num4;
                 }
                 else
                     t = (static_cast<csint>(num4) & 1) != 0 ? key2.Position() - num5 : key1.Position() + num5;
             }
 
-            CurveKey k0;
-            CurveKey k1;
-            const auto segment = FindSegment(t, k0, k1);
-            return num1 + Curve::Hermite(k0, k1, segment);
+            return true;
         }
 
-	private:
-		CurveLoopType preLoop{ CurveLoopType::Constant };
-		CurveLoopType postLoop{ CurveLoopType::Constant };
-		CurveKeyCollection keys;
-        
         constexpr double CalcCycle(double t) {
             auto num = (t - keys.Index(0).Position()) * keys.InvTimeRange();
             
             if (num < 0.0)
                 --num;
 
-            return num;
+            return static_cast<double>(static_cast<cslong>(num));
         }
 
-        constexpr double FindSegment(double t, CurveKey& k0, CurveKey& k1) {
-            auto segment = t;
-            k0 = keys.Index(0);
-            const auto size = keys.Count();
-
-            for (size_t index = 1; index < size; ++index) {
-                k1 = keys.Index(index);
-
-                if (k1.Position() >= t) {
-                    auto position1 = k0.Position();
-                    auto position2 = k1.Position();
-                    auto num1 = t;
-                    auto num2 = position2 - position1;
+        constexpr size_t FindSegment(double t, size_t hint) const {
+            return FindCurveSegment(t, hint, keys.Count(),
+                [this](size_t index) { return keys.Index(index).Position(); });
+        }
 
-                    segment = 0.0;
+        //FindSegment for a t no smaller than the one that found segment:
+        //steps forward from there, so a sorted batch visits each key once.
+        constexpr size_t WalkSegment(double t, size_t segment) const {
+            if (segment == 0)
+                return FindSegment(t, 0);
 
-                    if (num2 > 1E-10) {
-                        segment = ((num1 - position1) / num2);
-                        break;
-                    }
+            const auto last = keys.Count() - 1;
 
-                    break;
-                }
-
-                k0 = k1;
-            }
+            while (segment < last && keys.Index(segment).Position() < t)
+                ++segment;
 
             return segment;
         }
@@ -0,0 +1 @@
+#include "enumerations.hpp"
\ No newline at end of file
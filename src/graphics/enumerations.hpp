@@ -0,0 +1,38 @@
+#ifndef XNA_GRAPHICS_ENUMERATIONS_HPP
+#define XNA_GRAPHICS_ENUMERATIONS_HPP
+
+namespace xna {
+	//Values match the SurfaceFormat stored in XNB Texture2D payloads.
+	enum class SurfaceFormat {
+		Color = 0,
+		Bgr565 = 1,
+		Bgra5551 = 2,
+		Bgra4444 = 3,
+		Dxt1 = 4,
+		Dxt3 = 5,
+		Dxt5 = 6,
+		NormalizedByte2 = 7,
+		NormalizedByte4 = 8,
+		Rgba1010102 = 9,
+		Rg32 = 10,
+		Rgba64 = 11,
+		Alpha8 = 12,
+		Single = 13,
+		Vector2 = 14,
+		Vector4 = 15,
+		HalfSingle = 16,
+		HalfVector2 = 17,
+		HalfVector4 = 18,
+		HdrBlendable = 19,
+	};
+
+	//Filter Texture2D::GenerateMipmaps downsamples each level with.
+	enum class MipmapFilter {
+		//Averages the texels each destination texel covers.
+		Box,
+		//Kaiser windowed sinc, sharper than Box at the cost of more taps.
+		Kaiser,
+	};
+}
+
+#endif
\ No newline at end of file
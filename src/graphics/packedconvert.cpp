@@ -0,0 +1 @@
+#include "packedconvert.hpp"
\ No newline at end of file
@@ -0,0 +1,444 @@
+#ifndef XNA_GRAPHICS_PACKEDCONVERT_HPP
+#define XNA_GRAPHICS_PACKEDCONVERT_HPP
+
+#include "packedvector.hpp"
+#include <algorithm>
+#include <span>
+#include <type_traits>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define XNA_PACKED_SSE2
+#endif
+
+//PackedLanes
+namespace xna {
+	//The type a packed vector stores its value in.
+	template <typename T>
+	using PackedValueType = typename T::PackedType;
+
+	//Per component constants the bulk kernels derive from a PackedFormat. A
+	//component the format doesn't store has a zero mask, packs to nothing
+	//and unpacks to its default.
+	struct PackedLanes {
+		PackedKind Kind{ PackedKind::UNorm };
+		csint Shift[4]{};
+		csulong Mask[4]{};
+		//Sign bit of SNorm and Signed channels.
+		csulong Sign[4]{};
+		//Pack multiplier and clamp range, as in PackUtils.
+		double Scale[4]{};
+		double Low[4]{};
+		double High[4]{};
+		//Added to negative values to give their two's complement bits.
+		double Wrap[4]{};
+		//Moves a channel to its shift within its 32 bit half.
+		double Weight[4]{};
+		double Divisor[4]{ 1.0, 1.0, 1.0, 1.0 };
+		double Defaults[4]{};
+		//Whether Z and W are stored above the low 32 bits.
+		bool Split{ false };
+
+		static constexpr PackedLanes From(PackedFormat const& format) {
+			PackedLanes lanes;
+			lanes.Kind = format.Kind;
+
+			for (size_t c = 0; c < 4; ++c) {
+				auto const& channel = format.Channels[c];
+
+				if (channel.Bits == 0) {
+					lanes.Defaults[c] = format.Defaults[c];
+					continue;
+				}
+
+				const auto mask = (1ULL << channel.Bits) - 1;
+				const auto positive = static_cast<double>(mask >> 1);
+
+				lanes.Shift[c] = channel.Shift;
+				lanes.Mask[c] = mask;
+				lanes.Weight[c] = static_cast<double>(1ULL << (channel.Shift % 32));
+				lanes.Split = lanes.Split || channel.Shift >= 32;
+
+				switch (format.Kind) {
+				case PackedKind::UNorm:
+					lanes.Scale[c] = static_cast<double>(mask);
+					lanes.High[c] = static_cast<double>(mask);
+					lanes.Divisor[c] = static_cast<double>(mask);
+					break;
+				case PackedKind::SNorm:
+					lanes.Sign[c] = 1ULL << (channel.Bits - 1);
+					lanes.Scale[c] = positive;
+					lanes.Low[c] = -positive;
+					lanes.High[c] = positive;
+					lanes.Wrap[c] = static_cast<double>(mask + 1);
+					lanes.Divisor[c] = positive;
+					break;
+				case PackedKind::Unsigned:
+					lanes.Scale[c] = 1.0;
+					lanes.High[c] = static_cast<double>(mask);
+					break;
+				case PackedKind::Signed:
+					lanes.Sign[c] = 1ULL << (channel.Bits - 1);
+					lanes.Scale[c] = 1.0;
+					lanes.Low[c] = -positive - 1.0;
+					lanes.High[c] = positive;
+					lanes.Wrap[c] = static_cast<double>(mask + 1);
+					break;
+				default:
+					break;
+				}
+			}
+
+			return lanes;
+		}
+	};
+
+	template <typename T>
+	inline constexpr PackedLanes PackedLanesOf = PackedLanes::From(T::Format);
+}
+
+//PackedConvert
+namespace xna {
+	//Bulk conversions between Vector4 and the packed vector types, and from
+	//one packed type to another, over spans of either the packed vectors
+	//or their packed values. Each converts as many values as both spans
+	//hold and gives the same values as converting them one at a time with
+	//PackFromVector4 and ToVector4.
+	struct PackedConvert {
+		template <typename T>
+		static void Pack(std::span<const Vector4> vectors, std::span<PackedValueType<T>> values) {
+			PackSpan<T>(vectors, values);
+		}
+
+		template <PackedVector T>
+		static void Pack(std::span<const Vector4> vectors, std::span<T> values) {
+			PackSpan<T>(vectors, values);
+		}
+
+		template <typename T>
+		static void Unpack(std::span<const PackedValueType<T>> values, std::span<Vector4> vectors) {
+			UnpackSpan<T>(values, vectors);
+		}
+
+		template <PackedVector T>
+		static void Unpack(std::span<const T> values, std::span<Vector4> vectors) {
+			UnpackSpan<T>(values, vectors);
+		}
+
+		//Converts source values of one format to another through the same
+		//components ToVector4 would give, without building a Vector4 per
+		//value. Half formats go through a block of Vector4 instead, to convert
+		//their halves in bulk. Destination may be the source when both formats
+		//store the same value type.
+		template <typename TSource, typename TDestination>
+		static void Convert(std::span<const PackedValueType<TSource>> source, std::span<PackedValueType<TDestination>> destination) {
+			ConvertSpan<TSource, TDestination>(source, destination);
+		}
+
+		template <PackedVector TSource, PackedVector TDestination>
+		static void Convert(std::span<const TSource> source, std::span<TDestination> destination) {
+			ConvertSpan<TSource, TDestination>(source, destination);
+		}
+
+	private:
+		//The kernels take spans of either T or its packed value as E.
+		template <typename T, typename E>
+		static constexpr PackedValueType<T> ValueOf(E const& element) {
+			if constexpr (std::is_same_v<E, T>)
+				return element.PackedValue();
+			else
+				return element;
+		}
+
+		template <typename T, typename E>
+		static constexpr void Assign(E& element, PackedValueType<T> value) {
+			if constexpr (std::is_same_v<E, T>)
+				element.PackedValue(value);
+			else
+				element = value;
+		}
+
+		template <typename T, typename E>
+		static void PackSpan(std::span<const Vector4> vectors, std::span<E> values) {
+			const auto count = std::min(vectors.size(), values.size());
+
+			if constexpr (PackedLanesOf<T>.Kind == PackedKind::Half) {
+				PackHalves<T>(vectors.first(count), values);
+				return;
+			}
+
+			for (size_t i = 0; i < count; ++i)
+				Assign<T>(values[i], PackComponents<T>(&vectors[i].X));
+		}
+
+		template <typename T, typename E>
+		static void UnpackSpan(std::span<const E> values, std::span<Vector4> vectors) {
+			const auto count = std::min(vectors.size(), values.size());
+
+			if constexpr (PackedLanesOf<T>.Kind == PackedKind::Half) {
+				UnpackHalves<T>(values.first(count), vectors);
+				return;
+			}
+
+			for (size_t i = 0; i < count; ++i)
+				UnpackComponents<T>(ValueOf<T>(values[i]), &vectors[i].X);
+		}
+
+		template <typename TSource, typename TDestination, typename ESource, typename EDestination>
+		static void ConvertSpan(std::span<const ESource> source, std::span<EDestination> destination) {
+			const auto count = std::min(source.size(), destination.size());
+
+			if constexpr (PackedLanesOf<TSource>.Kind == PackedKind::Half || PackedLanesOf<TDestination>.Kind == PackedKind::Half) {
+				Vector4 block[HalfBlockSize];
+
+				for (size_t begin = 0; begin < count; begin += HalfBlockSize) {
+					const auto blockCount = std::min(HalfBlockSize, count - begin);
+					UnpackSpan<TSource>(source.subspan(begin, blockCount), std::span<Vector4>(block, blockCount));
+					PackSpan<TDestination>(std::span<const Vector4>(block, blockCount), destination.subspan(begin, blockCount));
+				}
+
+				return;
+			}
+#ifdef XNA_PACKED_SSE2
+			for (size_t i = 0; i < count; ++i) {
+				__m128d xy, zw;
+				LoadLanes<TSource>(ValueOf<TSource>(source[i]), xy, zw);
+				Assign<TDestination>(destination[i], StoreLanes<TDestination>(xy, zw));
+			}
+#else
+			double components[4];
+
+			for (size_t i = 0; i < count; ++i) {
+				UnpackComponents<TSource>(ValueOf<TSource>(source[i]), components);
+				Assign<TDestination>(destination[i], PackComponents<TDestination>(components));
+			}
+#endif
+		}
+
+		static constexpr size_t HalfBlockSize = 256;
+
+		//Channels stored by a half format, which keeps them in order from X
+		//every 16 bits.
+		template <typename T>
+		static constexpr size_t HalfChannels() {
+			constexpr auto& lanes = PackedLanesOf<T>;
+			size_t channels = 0;
+
+			while (channels < 4 && lanes.Mask[channels] != 0) {
+				if (lanes.Shift[channels] != static_cast<csint>(channels * 16))
+					return 0;
+
+				++channels;
+			}
+
+			return channels;
+		}
+
+		//Gathers the components a half format stores into blocks of doubles
+		//and packs them with the bulk HalfUtils::Pack.
+		template <typename T, typename E>
+		static void PackHalves(std::span<const Vector4> vectors, std::span<E> values) {
+			constexpr auto channels = HalfChannels<T>();
+			static_assert(channels != 0);
+
+			double components[HalfBlockSize * channels];
+			csushort halves[HalfBlockSize * channels];
+
+			for (size_t begin = 0; begin < vectors.size(); begin += HalfBlockSize) {
+				const auto blockCount = std::min(HalfBlockSize, vectors.size() - begin);
+
+				for (size_t i = 0; i < blockCount; ++i) {
+					auto const* vector = &vectors[begin + i].X;
+
+					for (size_t c = 0; c < channels; ++c)
+						components[i * channels + c] = vector[c];
+				}
+
+				HalfUtils::Pack(std::span<const double>(components, blockCount * channels), std::span<csushort>(halves, blockCount * channels));
+
+				for (size_t i = 0; i < blockCount; ++i) {
+					csulong value = 0;
+
+					for (size_t c = 0; c < channels; ++c)
+						value |= static_cast<csulong>(halves[i * channels + c]) << (c * 16);
+
+					Assign<T>(values[begin + i], static_cast<PackedValueType<T>>(value));
+				}
+			}
+		}
+
+		template <typename T, typename E>
+		static void UnpackHalves(std::span<const E> values, std::span<Vector4> vectors) {
+			constexpr auto& lanes = PackedLanesOf<T>;
+			constexpr auto channels = HalfChannels<T>();
+			static_assert(channels != 0);
+
+			csushort halves[HalfBlockSize * channels];
+			double components[HalfBlockSize * channels];
+
+			for (size_t begin = 0; begin < values.size(); begin += HalfBlockSize) {
+				const auto blockCount = std::min(HalfBlockSize, values.size() - begin);
+
+				for (size_t i = 0; i < blockCount; ++i) {
+					for (size_t c = 0; c < channels; ++c)
+						halves[i * channels + c] = static_cast<csushort>(static_cast<csulong>(ValueOf<T>(values[begin + i])) >> (c * 16));
+				}
+
+				HalfUtils::Unpack(std::span<const csushort>(halves, blockCount * channels), std::span<double>(components, blockCount * channels));
+
+				for (size_t i = 0; i < blockCount; ++i) {
+					auto* vector = &vectors[begin + i].X;
+
+					for (size_t c = 0; c < 4; ++c)
+						vector[c] = c < channels ? components[i * channels + c] : lanes.Defaults[c];
+				}
+			}
+		}
+
+		template <typename T>
+		static PackedValueType<T> PackComponents(double const* components) {
+#ifdef XNA_PACKED_SSE2
+			if constexpr (PackedLanesOf<T>.Kind != PackedKind::Half)
+				return StoreLanes<T>(_mm_loadu_pd(components), _mm_loadu_pd(components + 2));
+#endif
+			constexpr auto& lanes = PackedLanesOf<T>;
+			csulong value = 0;
+
+			for (size_t c = 0; c < 4; ++c) {
+				if (lanes.Mask[c] == 0)
+					continue;
+
+				const auto mask = static_cast<csuint>(lanes.Mask[c]);
+				csuint bits = 0;
+
+				switch (lanes.Kind) {
+				case PackedKind::UNorm:
+					bits = PackUtils::PackUNorm(static_cast<double>(mask), components[c]);
+					break;
+				case PackedKind::SNorm:
+					bits = PackUtils::PackSNorm(mask, components[c]);
+					break;
+				case PackedKind::Unsigned:
+					bits = PackUtils::PackUnsigned(static_cast<double>(mask), components[c]);
+					break;
+				case PackedKind::Signed:
+					bits = PackUtils::PackSigned(mask, components[c]);
+					break;
+				case PackedKind::Half:
+					bits = HalfUtils::Pack(components[c]);
+					break;
+				}
+
+				value |= static_cast<csulong>(bits) << lanes.Shift[c];
+			}
+
+			return static_cast<PackedValueType<T>>(value);
+		}
+
+		template <typename T>
+		static void UnpackComponents(PackedValueType<T> value, double* components) {
+#ifdef XNA_PACKED_SSE2
+			if constexpr (PackedLanesOf<T>.Kind != PackedKind::Half) {
+				__m128d xy, zw;
+				LoadLanes<T>(value, xy, zw);
+				_mm_storeu_pd(components, xy);
+				_mm_storeu_pd(components + 2, zw);
+				return;
+			}
+#endif
+			constexpr auto& lanes = PackedLanesOf<T>;
+
+			for (size_t c = 0; c < 4; ++c) {
+				if (lanes.Mask[c] == 0) {
+					components[c] = lanes.Defaults[c];
+					continue;
+				}
+
+				const auto mask = static_cast<csuint>(lanes.Mask[c]);
+				const auto bits = static_cast<csuint>(static_cast<csulong>(value) >> lanes.Shift[c]);
+
+				switch (lanes.Kind) {
+				case PackedKind::UNorm:
+					components[c] = PackUtils::UnpackUNorm(mask, bits);
+					break;
+				case PackedKind::SNorm:
+					components[c] = PackUtils::UnpackSNorm(mask, bits);
+					break;
+				case PackedKind::Unsigned:
+					components[c] = static_cast<double>(bits & mask);
+					break;
+				case PackedKind::Signed:
+					components[c] = static_cast<double>(static_cast<csint>(((bits & mask) ^ lanes.Sign[c]) - lanes.Sign[c]));
+					break;
+				case PackedKind::Half:
+					components[c] = HalfUtils::Unpack(static_cast<csushort>(bits));
+					break;
+				}
+			}
+		}
+
+#ifdef XNA_PACKED_SSE2
+		//Scales, clamps and rounds two components half away from zero, as
+		//PackUtils::ClampAndRound does, and moves them to their bits.
+		static __m128d PackLanes(__m128d value, PackedLanes const& lanes, size_t c) {
+			const auto one = _mm_set1_pd(1.0);
+
+			value = _mm_and_pd(value, _mm_cmpord_pd(value, value));
+			value = _mm_mul_pd(value, _mm_loadu_pd(lanes.Scale + c));
+			value = _mm_min_pd(_mm_max_pd(value, _mm_loadu_pd(lanes.Low + c)), _mm_loadu_pd(lanes.High + c));
+
+			const auto truncated = _mm_cvtepi32_pd(_mm_cvttpd_epi32(value));
+			const auto fraction = _mm_sub_pd(value, truncated);
+			auto rounded = _mm_add_pd(truncated, _mm_and_pd(_mm_cmpge_pd(fraction, _mm_set1_pd(0.5)), one));
+			rounded = _mm_sub_pd(rounded, _mm_and_pd(_mm_cmple_pd(fraction, _mm_set1_pd(-0.5)), one));
+			rounded = _mm_add_pd(rounded, _mm_and_pd(_mm_cmplt_pd(rounded, _mm_setzero_pd()), _mm_loadu_pd(lanes.Wrap + c)));
+
+			return _mm_mul_pd(rounded, _mm_loadu_pd(lanes.Weight + c));
+		}
+
+		static csulong SumLanes(__m128d value) {
+			return static_cast<csulong>(_mm_cvtsd_f64(_mm_add_sd(value, _mm_unpackhi_pd(value, value))));
+		}
+
+		//Channels never overlap, so adding their shifted values is exact and
+		//equal to or-ing their bits.
+		template <typename T>
+		static PackedValueType<T> StoreLanes(__m128d xy, __m128d zw) {
+			constexpr auto& lanes = PackedLanesOf<T>;
+			static_assert(!lanes.Split || (lanes.Shift[0] < 32 && lanes.Shift[1] < 32 && lanes.Shift[2] >= 32 && lanes.Shift[3] >= 32));
+
+			xy = PackLanes(xy, lanes, 0);
+			zw = PackLanes(zw, lanes, 2);
+
+			if constexpr (lanes.Split)
+				return static_cast<PackedValueType<T>>(SumLanes(xy) | SumLanes(zw) << 32);
+			else
+				return static_cast<PackedValueType<T>>(SumLanes(_mm_add_pd(xy, zw)));
+		}
+
+		template <typename T>
+		static void LoadLanes(PackedValueType<T> value, __m128d& xy, __m128d& zw) {
+			constexpr auto& lanes = PackedLanesOf<T>;
+			const auto channel = [value](size_t c) {
+				const auto bits = static_cast<csulong>(value) >> lanes.Shift[c] & lanes.Mask[c];
+				return static_cast<csint>((bits ^ lanes.Sign[c]) - lanes.Sign[c]);
+			};
+
+			const auto integers = _mm_set_epi32(channel(3), channel(2), channel(1), channel(0));
+			xy = _mm_div_pd(_mm_cvtepi32_pd(integers), _mm_loadu_pd(lanes.Divisor));
+			zw = _mm_div_pd(_mm_cvtepi32_pd(_mm_shuffle_epi32(integers, _MM_SHUFFLE(3, 2, 3, 2))), _mm_loadu_pd(lanes.Divisor + 2));
+
+			//The most negative SNorm value unpacks to -1, like the one above it.
+			if constexpr (lanes.Kind == PackedKind::SNorm) {
+				xy = _mm_max_pd(xy, _mm_set1_pd(-1.0));
+				zw = _mm_max_pd(zw, _mm_set1_pd(-1.0));
+			}
+
+			xy = _mm_add_pd(xy, _mm_loadu_pd(lanes.Defaults));
+			zw = _mm_add_pd(zw, _mm_loadu_pd(lanes.Defaults + 2));
+		}
+#endif
+	};
+}
+
+#endif
\ No newline at end of file
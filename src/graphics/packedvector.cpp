@@ -1 +1,104 @@
-#include "packedvector.hpp"
\ No newline at end of file
+#include "packedvector.hpp"
+#include <algorithm>
+
+#if defined(_M_X64) || defined(__x86_64__) || defined(_M_IX86) || defined(__i386__)
+#include <immintrin.h>
+#define XNA_HALF_F16C
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#define XNA_TARGET_F16C
+#else
+#define XNA_TARGET_F16C __attribute__((target("avx,f16c")))
+#endif
+#endif
+
+namespace xna {
+#ifdef XNA_HALF_F16C
+	static bool DetectF16C() {
+#if defined(_MSC_VER) && !defined(__clang__)
+		int info[4]{};
+		__cpuid(info, 1);
+
+		//F16C is VEX encoded, so it also needs AVX and the OS saving YMM state.
+		const auto osxsave = (info[2] & (1 << 27)) != 0;
+		const auto avx = (info[2] & (1 << 28)) != 0;
+		const auto f16c = (info[2] & (1 << 29)) != 0;
+
+		return osxsave && avx && f16c && (_xgetbv(0) & 6) == 6;
+#else
+		__builtin_cpu_init();
+		return __builtin_cpu_supports("avx") && __builtin_cpu_supports("f16c");
+#endif
+	}
+
+	//One 32 bit lane per 64 bit lane of a comparison mask.
+	XNA_TARGET_F16C static __m128i NarrowMask(__m256d mask) {
+		const auto low = _mm_castpd_ps(_mm256_castpd256_pd128(mask));
+		const auto high = _mm_castpd_ps(_mm256_extractf128_pd(mask, 1));
+		return _mm_castps_si128(_mm_shuffle_ps(low, high, _MM_SHUFFLE(2, 0, 2, 0)));
+	}
+
+	//Same rounding to odd as HalfUtils::RoundToOdd, four values at a time.
+	XNA_TARGET_F16C static size_t PackF16C(double const* values, csushort* halves, size_t count) {
+		const auto sign = _mm256_set1_pd(-0.0);
+		size_t i = 0;
+
+		for (; i + 4 <= count; i += 4) {
+			const auto value = _mm256_loadu_pd(values + i);
+			const auto single = _mm256_cvtpd_ps(value);
+			const auto back = _mm256_cvtps_pd(single);
+			const auto inexact = _mm256_cmp_pd(back, value, _CMP_NEQ_OQ);
+			const auto larger = _mm256_cmp_pd(_mm256_andnot_pd(sign, back), _mm256_andnot_pd(sign, value), _CMP_GT_OQ);
+
+			auto bits = _mm_add_epi32(_mm_castps_si128(single), NarrowMask(larger));
+			bits = _mm_or_si128(bits, _mm_srli_epi32(NarrowMask(inexact), 31));
+
+			_mm_storel_epi64(reinterpret_cast<__m128i*>(halves + i), _mm_cvtps_ph(_mm_castsi128_ps(bits), _MM_FROUND_TO_NEAREST_INT));
+		}
+
+		return i;
+	}
+
+	XNA_TARGET_F16C static size_t UnpackF16C(csushort const* halves, double* values, size_t count) {
+		size_t i = 0;
+
+		for (; i + 4 <= count; i += 4) {
+			const auto half = _mm_loadl_epi64(reinterpret_cast<__m128i const*>(halves + i));
+			_mm256_storeu_pd(values + i, _mm256_cvtps_pd(_mm_cvtph_ps(half)));
+		}
+
+		return i;
+	}
+#endif
+
+	bool HalfUtils::HardwareAccelerated() {
+#ifdef XNA_HALF_F16C
+		static const bool available = DetectF16C();
+		return available;
+#else
+		return false;
+#endif
+	}
+
+	void HalfUtils::Pack(std::span<const double> values, std::span<csushort> halves) {
+		const auto count = std::min(values.size(), halves.size());
+		size_t i = 0;
+#ifdef XNA_HALF_F16C
+		if (HardwareAccelerated())
+			i = PackF16C(values.data(), halves.data(), count);
+#endif
+		for (; i < count; ++i)
+			halves[i] = Pack(values[i]);
+	}
+
+	void HalfUtils::Unpack(std::span<const csushort> halves, std::span<double> values) {
+		const auto count = std::min(values.size(), halves.size());
+		size_t i = 0;
+#ifdef XNA_HALF_F16C
+		if (HardwareAccelerated())
+			i = UnpackF16C(halves.data(), values.data(), count);
+#endif
+		for (; i < count; ++i)
+			values[i] = Unpack(halves[i]);
+	}
+}
\ No newline at end of file
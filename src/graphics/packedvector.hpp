@@ -1,7 +1,12 @@
 #ifndef XNA_GRAPHICS_PACKEDVECTOR_HPP
 #define XNA_GRAPHICS_PACKEDVECTOR_HPP
 
+#include <array>
+#include <bit>
 #include <cmath>
+#include <concepts>
+#include <span>
+#include <type_traits>
 #include "../csharp/integralnumeric.hpp"
 #include "../csharp/floatnumeric.hpp"
 #include "../basic-structs.hpp"
@@ -54,7 +59,7 @@ namespace xna{
 				value &= bitmask;
 
 			const auto num2 = todouble(bitmask >> 1);
-			const auto result = value / num2;
+			return todouble(toint(value)) / num2;
 		}
 
 		static constexpr double ClampAndRound(double value, double min, double max) {
@@ -71,124 +76,232 @@ namespace xna{
 		}
 	};
 
-	struct HalfUtils {
-		
-		//TODO rever operador >>> em C#
-		//https://stackoverflow.com/questions/5529443/what-is-operation-in-c
+	//How a float exponent maps to a half: the half bits it starts from, how
+	//far the significand shifts right into them and whether the significand
+	//keeps its implicit leading bit (for half denormals). Overflows and
+	//underflows shift everything out without rounding.
+	struct HalfPackEntry {
+		csuint Base{ 0 };
+		csuint Shift{ 25 };
+		csuint Implicit{ 0 };
+	};
 
+	//IEEE half precision conversions. Pack rounds to the nearest half, ties
+	//to even; values beyond the half range become infinities and NaNs stay
+	//NaNs. Unpack is exact.
+	struct HalfUtils {
 		static constexpr csushort Pack(double value) {
-			const auto num1 = *(csuint*)&value;
-			const csuint num2 = (num1 & 2147483648U) >> 16;
-			const csuint num3 = num1 & int_max;
-			csushort num4 = 0;
+			return PackSingle(RoundToOdd(value));
+		}
 
-			if (num3 > 1207955455U)
-				num4 = toushort(num2 | short_max);
+		static constexpr double Unpack(csushort value) {
+			const auto bits = Mantissas[Offsets[value >> 10] + (value & 1023U)] + Exponents[value >> 10];
+			return static_cast<double>(std::bit_cast<float>(bits));
+		}
 
-			else if (num3 < 947912704U)	{
-				const csuint num5 = num3 & 8388607 | 8388608;
-				const csint num6 = 113 - toint(num3 >> 23);
-				const csuint num7 = num6 > 31 ? 0U : num5 >> num6;
+		//Converts as many values as both spans hold, with the processor's F16C
+		//instructions when HardwareAccelerated and the tables otherwise. Gives
+		//the same halves and values as Pack and Unpack.
+		static void Pack(std::span<const double> values, std::span<csushort> halves);
+		static void Unpack(std::span<const csushort> halves, std::span<double> values);
 
-				num4 = toushort(num2 
-					| (num7 + 4095 + touint((num7 >> 13) & 1) >> 13));
-			}
-			else
-				num4 = toushort(num2 | touint(num3 - 939524096 + 4095 + touint((num3 >> 13) & 1) >> 13));
+		//Whether the processor and operating system support F16C.
+		static bool HardwareAccelerated();
+
+	private:
+		//Narrows value to the bits of a float, rounding to odd: an inexact
+		//result is truncated and keeps its lowest bit set, so rounding it
+		//again to half precision gives the same half as rounding value
+		//directly would.
+		static constexpr csuint RoundToOdd(double value) {
+			const auto bits = std::bit_cast<csulong>(value);
+			const auto magnitude = bits & 9223372036854775807ULL;
+			const auto ordered = magnitude <= 9218868437227405312ULL;
 
-			return num4;			
+			//Finite but beyond the float range: the largest float, which is
+			//odd and still overflows to an infinite half.
+			if (ordered && magnitude > 5183643170566569984ULL)
+				return (static_cast<csuint>(bits >> 32) & 2147483648U) | 2139095039U;
+
+			const auto single = static_cast<float>(value);
+			const auto back = std::bit_cast<csulong>(static_cast<double>(single)) & 9223372036854775807ULL;
+			const auto larger = static_cast<csuint>(ordered && back > magnitude);
+			const auto inexact = static_cast<csuint>(ordered && back != magnitude);
+
+			return (std::bit_cast<csuint>(single) - larger) | inexact;
 		}
 
-		static constexpr double Unpack(csushort value)	{
-			csuint num1 = 0;
-			
-			const auto valueAsInt = toint(value);
+		static constexpr csushort PackSingle(csuint bits) {
+			const auto sign = bits >> 16 & 32768U;
+			const auto exponent = bits >> 23 & 255U;
+			const auto mantissa = bits & 8388607U;
+
+			if (exponent == 255U && mantissa != 0)
+				return static_cast<csushort>(sign | 32256U | mantissa >> 13);
+
+			auto const& entry = PackEntries[exponent];
+			const auto significand = mantissa | entry.Implicit;
+			const auto rest = significand & ((1U << entry.Shift) - 1U);
+			const auto halfway = 1U << (entry.Shift - 1);
+			const auto half = entry.Base + (significand >> entry.Shift);
+			const auto roundUp = static_cast<csuint>(rest > halfway) | (static_cast<csuint>(rest == halfway) & half);
+
+			return static_cast<csushort>(sign | (half + roundUp));
+		}
+
+		static constexpr std::array<HalfPackEntry, 256> PackEntries = [] {
+			std::array<HalfPackEntry, 256> entries{};
+
+			for (csuint e = 0; e < 256; ++e) {
+				HalfPackEntry entry{ 0, 25, 0 };
 
-			if ((valueAsInt & -33792) == 0) {
-				if ((valueAsInt & 1023) != 0) {
-					csuint num2 = 4294967282;
-					csuint num3 = 0;
-					
-					for (num3 = touint(value) & 1023U; (toint(num3) & 1024) == 0; num3 <<= 1)
-						--num2;
-
-					csuint num4 = num3 & 4294966271U;
-					
-					num1 = touint(
-						(valueAsInt & 32768) << 16 
-						| toint(num2) + toint(sbyte_max) << 23 
-						| toint(num4) << 13);
+				if (e >= 102 && e <= 112) {
+					entry.Shift = 126 - e;
+					entry.Implicit = 8388608U;
 				}
-				else
-					num1 = touint((toint(value) & 32768) << 16);
+				else if (e >= 113 && e <= 142) {
+					entry.Base = (e - 112) << 10;
+					entry.Shift = 13;
+				}
+				else if (e >= 143)
+					entry.Base = 31744U;
+
+				entries[e] = entry;
 			}
-			else
-				num1 = touint(
-					(valueAsInt & 32768) << 16 
-					| (valueAsInt >> 10 & 31) - 15 + toint(sbyte_max) << 23 
-					| (valueAsInt & 1023) << 13);
-			
-			return *(double*)&num1;
-		}
 
-	private:
+			return entries;
+		}();
+
+		//Half to float bits as Mantissas[Offsets[e] + m] + Exponents[e], with
+		//e the half's sign and exponent and m its mantissa. Denormal halves
+		//are normalized ahead of time.
+		static constexpr std::array<csuint, 2048> Mantissas = [] {
+			std::array<csuint, 2048> mantissas{};
+
+			for (csuint i = 1; i < 1024; ++i) {
+				auto mantissa = i << 13;
+				csuint exponent = 0;
+
+				while ((mantissa & 8388608U) == 0) {
+					exponent -= 8388608U;
+					mantissa <<= 1;
+				}
+
+				mantissas[i] = (mantissa & ~8388608U) | (exponent + 947912704U);
+			}
+
+			for (csuint i = 1024; i < 2048; ++i)
+				mantissas[i] = 939524096U + ((i - 1024) << 13);
+
+			return mantissas;
+		}();
+
+		static constexpr std::array<csuint, 64> Exponents = [] {
+			std::array<csuint, 64> exponents{};
+
+			for (csuint i = 1; i < 31; ++i) {
+				exponents[i] = i << 23;
+				exponents[i + 32] = 2147483648U + (i << 23);
+			}
+
+			exponents[31] = 1199570944U;
+			exponents[32] = 2147483648U;
+			exponents[63] = 3347054592U;
+
+			return exponents;
+		}();
 
-		//Variveis no usadas no cdigo C#!
-
-		static constexpr csint cFracBits = 10;
-		static constexpr csint cExpBits = 5;
-		static constexpr csint cSignBit = 15;
-		static constexpr csuint cSignMask = 32768;
-		static constexpr csuint cFracMask = 1023;
-		static constexpr csint cExpBias = 15;
-		static constexpr csuint cRoundBit = 4096;
-		static constexpr csuint eMax = 16;
-		static constexpr csint eMin = -14;
-		static constexpr csuint wMaxNormal = 1207955455;
-		static constexpr csuint wMinNormal = 947912704;
-		static constexpr csuint BiasDiffo = 3355443200;
-		static constexpr csint cFracBitsDiff = 13;
+		static constexpr std::array<csushort, 64> Offsets = [] {
+			std::array<csushort, 64> offsets{};
+			offsets.fill(1024);
+			offsets[0] = 0;
+			offsets[32] = 0;
+			return offsets;
+		}();
 	};
 }
 
-//Interfaces
+//Formats
 namespace xna {
-	struct IPackedVector {
-		virtual constexpr Vector4 ToVector4() const = 0;
-		virtual constexpr void PackFromVector4(xna::Vector4 const& vector) = 0;
+	//How every channel of a packed format encodes its value.
+	enum class PackedKind {
+		//[0, 1] scaled to the channel's range.
+		UNorm,
+		//[-1, 1] scaled to the channel's positive range, two's complement.
+		SNorm,
+		//Integers from 0 up to the channel's range.
+		Unsigned,
+		//Two's complement integers.
+		Signed,
+		//IEEE half precision floats.
+		Half,
+	};
+
+	struct PackedChannel {
+		csint Shift{ 0 };
+		csint Bits{ 0 };
 	};
 
+	//The bit layout of a packed vector type, with one channel per Vector4
+	//component from X to W. A component with no bits isn't stored and
+	//unpacks to its default.
+	struct PackedFormat {
+		PackedKind Kind{ PackedKind::UNorm };
+		PackedChannel Channels[4]{};
+		double Defaults[4]{ 0.0, 0.0, 0.0, 1.0 };
+	};
+}
+
+//Interfaces
+namespace xna {
+	//Base of the packed vector types. It stores nothing and has no virtual
+	//functions, so a packed vector is exactly as large as its packed value
+	//and arrays of them can be copied as memory.
 	template <typename T>
-	struct IPackedVectorT : public IPackedVector {
+	struct IPackedVectorT {
+		using PackedType = T;
+	};
 
-		virtual constexpr T PackedValue() const = 0;
-		virtual constexpr void PackedValue(T const& value) = 0;
-	};		
+	//What every packed vector type provides. Generic code takes a
+	//PackedVector template parameter instead of calling through a virtual
+	//interface; AnyPackedVector covers code that only knows the type at
+	//run time.
+	template <typename T>
+	concept PackedVector = std::is_trivially_copyable_v<T>
+		&& sizeof(T) == sizeof(typename T::PackedType)
+		&& requires(T& value, T const& constant, Vector4 const& vector, typename T::PackedType packed) {
+			{ constant.ToVector4() } -> std::same_as<Vector4>;
+			value.PackFromVector4(vector);
+			{ constant.PackedValue() } -> std::same_as<typename T::PackedType>;
+			value.PackedValue(packed);
+		};
 }
 
 //Alpha8
 namespace xna {
 	struct Alpha8 : IPackedVectorT<csbyte> {
 
+		static constexpr PackedFormat Format{ PackedKind::UNorm, { { 0, 0 }, { 0, 0 }, { 0, 0 }, { 0, 8 } }, { 0.0, 0.0, 0.0, 0.0 } };
+
 		constexpr Alpha8() = default;
 
 		constexpr Alpha8(double alpha) :
 			packedValue(PackHelper(alpha)) {
 		}
 
-		virtual constexpr csbyte PackedValue() const override {
+		constexpr csbyte PackedValue() const {
 			return packedValue;
 		}
 
-		virtual constexpr void PackedValue(csbyte const& value) override {
+		constexpr void PackedValue(csbyte const& value) {
 			packedValue = value;
 		}
 
-		virtual constexpr xna::Vector4 ToVector4() const override {
+		constexpr xna::Vector4 ToVector4() const {
 			return Vector4(0.0, 0.0, 0.0, ToAlpha());
 		}
 
-		virtual constexpr void PackFromVector4(xna::Vector4 const& vector) override {
+		constexpr void PackFromVector4(xna::Vector4 const& vector) {
 			packedValue = PackHelper(vector.W);
 		}
 
@@ -223,6 +336,8 @@ namespace xna {
 //Bgr565
 namespace xna {
 	struct Bgr565 : IPackedVectorT<csushort> {
+		static constexpr PackedFormat Format{ PackedKind::UNorm, { { 11, 5 }, { 5, 6 }, { 0, 5 }, { 0, 0 } } };
+
 		constexpr Bgr565() = default;
 
 		constexpr Bgr565(double x, double y, double z) :
@@ -233,20 +348,20 @@ namespace xna {
 			packedValue(PackHelper(vector.X, vector.Y, vector.Z)) {
 		}
 
-		virtual constexpr csushort PackedValue() const override {
+		constexpr csushort PackedValue() const {
 			return packedValue;
 		}
 
-		virtual constexpr void PackedValue(csushort const& value) override {
+		constexpr void PackedValue(csushort const& value) {
 			packedValue = value;
 		}
 
-		virtual constexpr xna::Vector4 ToVector4() const override {
+		constexpr xna::Vector4 ToVector4() const {
 			const auto vector3 = ToVector3();
 			return Vector4(vector3, 1.0);
 		}
 
-		virtual constexpr void PackFromVector4(xna::Vector4 const& vector) override {
+		constexpr void PackFromVector4(xna::Vector4 const& vector) {
 			packedValue = PackHelper(vector.X, vector.Y, vector.Z);
 		}
 
@@ -285,6 +400,8 @@ namespace xna {
 //Bgra4444
 namespace xna {
 	struct Bgra4444 : IPackedVectorT<csushort> {
+		static constexpr PackedFormat Format{ PackedKind::UNorm, { { 8, 4 }, { 4, 4 }, { 0, 4 }, { 12, 4 } } };
+
 		constexpr Bgra4444() = default;
 
 		constexpr Bgra4444(double x, double y, double z, double w) :
@@ -295,15 +412,15 @@ namespace xna {
 			packedValue(PackHelper(vector.X, vector.Y, vector.Z, vector.W)) {
 		}
 
-		virtual constexpr csushort PackedValue() const override {
+		constexpr csushort PackedValue() const {
 			return packedValue;
 		}
 
-		virtual constexpr void PackedValue(csushort const& value) override {
+		constexpr void PackedValue(csushort const& value) {
 			packedValue = value;
 		}
 
-		virtual constexpr xna::Vector4 ToVector4() const override {
+		constexpr xna::Vector4 ToVector4() const {
 			Vector4 vector4;
 			vector4.X = PackUtils::UnpackUNorm(15U, static_cast<csuint>(packedValue) >> 8);
 			vector4.Y = PackUtils::UnpackUNorm(15U, static_cast<csuint>(packedValue) >> 4);
@@ -312,7 +429,7 @@ namespace xna {
 			return vector4;
 		}
 
-		virtual constexpr void PackFromVector4(xna::Vector4 const& vector) override {
+		constexpr void PackFromVector4(xna::Vector4 const& vector) {
 			packedValue = Bgra4444::PackHelper(vector.X, vector.Y, vector.Z, vector.W);
 		}
 
@@ -344,6 +461,8 @@ namespace xna {
 //Bgra5551
 namespace xna {
 	struct Bgra5551 : IPackedVectorT<csushort> {
+		static constexpr PackedFormat Format{ PackedKind::UNorm, { { 10, 5 }, { 5, 5 }, { 0, 5 }, { 15, 1 } } };
+
 		constexpr Bgra5551() = default;
 
 		constexpr Bgra5551(double x, double y, double z, double w) :
@@ -354,15 +473,15 @@ namespace xna {
 			packedValue(PackHelper(vector.X, vector.Y, vector.Z, vector.W)) {
 		}
 
-		virtual constexpr csushort PackedValue() const override {
+		constexpr csushort PackedValue() const {
 			return packedValue;
 		}
 
-		virtual constexpr void PackedValue(csushort const& value) override {
+		constexpr void PackedValue(csushort const& value) {
 			packedValue = value;
 		}
 
-		virtual constexpr xna::Vector4 ToVector4() const override {
+		constexpr xna::Vector4 ToVector4() const {
 			Vector4 vector4;
 			vector4.X = PackUtils::UnpackUNorm(31U, static_cast<csuint>(packedValue) >> 10);
 			vector4.Y = PackUtils::UnpackUNorm(31U, static_cast<csuint>(packedValue) >> 5);
@@ -371,7 +490,7 @@ namespace xna {
 			return vector4;
 		}
 
-		virtual constexpr void PackFromVector4(xna::Vector4 const& vector) override {
+		constexpr void PackFromVector4(xna::Vector4 const& vector) {
 			packedValue = Bgra5551::PackHelper(vector.X, vector.Y, vector.Z, vector.W);
 		}
 
@@ -403,6 +522,8 @@ namespace xna {
 //Byte4
 namespace xna {
 	struct Byte4 : IPackedVectorT<csuint> {
+		static constexpr PackedFormat Format{ PackedKind::Unsigned, { { 0, 8 }, { 8, 8 }, { 16, 8 }, { 24, 8 } } };
+
 		constexpr Byte4() = default;
 
 		constexpr Byte4(double x, double y, double z, double w) :
@@ -413,15 +534,15 @@ namespace xna {
 			packedValue(PackHelper(vector.X, vector.Y, vector.Z, vector.W)) {
 		}
 
-		virtual constexpr csuint PackedValue() const override {
+		constexpr csuint PackedValue() const {
 			return packedValue;
 		}
 
-		virtual constexpr void PackedValue(csuint const& value) override {
+		constexpr void PackedValue(csuint const& value) {
 			packedValue = value;
 		}
 
-		virtual constexpr xna::Vector4 ToVector4() const override {
+		constexpr xna::Vector4 ToVector4() const {
 			Vector4 vector4;
 			vector4.X = todouble(packedValue & touint(byte_max));
 			vector4.Y = todouble(packedValue >> 8 & touint(byte_max));
@@ -430,7 +551,7 @@ namespace xna {
 			return vector4;
 		}
 
-		virtual constexpr void PackFromVector4(xna::Vector4 const& vector) override {
+		constexpr void PackFromVector4(xna::Vector4 const& vector) {
 			packedValue = Byte4::PackHelper(vector.X, vector.Y, vector.Z, vector.W);
 		}
 
@@ -447,9 +568,9 @@ namespace xna {
 		}
 
 	private:
-		csushort packedValue{ 0 };
+		csuint packedValue{ 0 };
 
-		static constexpr csushort PackHelper(double vectorX, double vectorY, double vectorZ, double vectorW) {
+		static constexpr csuint PackHelper(double vectorX, double vectorY, double vectorZ, double vectorW) {
 			return PackUtils::PackUnsigned(static_cast<double>(byte_max), vectorX)
 				| PackUtils::PackUnsigned(static_cast<double>(byte_max), vectorY) << 8
 				| PackUtils::PackUnsigned(static_cast<double>(byte_max), vectorZ) << 16
@@ -462,25 +583,27 @@ namespace xna {
 namespace xna {
 	struct HalfSingle : IPackedVectorT<csushort> {
 
+		static constexpr PackedFormat Format{ PackedKind::Half, { { 0, 16 }, { 0, 0 }, { 0, 0 }, { 0, 0 } } };
+
 		constexpr HalfSingle() = default;
 
 		constexpr HalfSingle(double value) :
 			packedValue(HalfUtils::Pack(value)) {
 		}
 
-		virtual constexpr csushort PackedValue() const override {
+		constexpr csushort PackedValue() const {
 			return packedValue;
 		}
 
-		virtual constexpr void PackedValue(csushort const& value) override {
+		constexpr void PackedValue(csushort const& value) {
 			packedValue = value;
 		}
 
-		virtual constexpr xna::Vector4 ToVector4() const override {
+		constexpr xna::Vector4 ToVector4() const {
 			return Vector4(ToSingle(), 0.0, 0.0, 1.0);
 		}
 
-		virtual constexpr void PackFromVector4(xna::Vector4 const& vector) override {
+		constexpr void PackFromVector4(xna::Vector4 const& vector) {
 			packedValue = HalfUtils::Pack(vector.X);
 		}
 
@@ -508,6 +631,8 @@ namespace xna {
 //HalfVector2
 namespace xna {
 	struct HalfVector2 : IPackedVectorT<csuint> {
+		static constexpr PackedFormat Format{ PackedKind::Half, { { 0, 16 }, { 16, 16 }, { 0, 0 }, { 0, 0 } } };
+
 		constexpr HalfVector2() = default;
 
 		constexpr HalfVector2(double x, double y) :
@@ -518,20 +643,20 @@ namespace xna {
 			packedValue(PackHelper(vector.X, vector.Y)) {
 		}
 
-		virtual constexpr csuint PackedValue() const override {
+		constexpr csuint PackedValue() const {
 			return packedValue;
 		}
 
-		virtual constexpr void PackedValue(csuint const& value) override {
+		constexpr void PackedValue(csuint const& value) {
 			packedValue = value;
 		}
 
-		virtual constexpr xna::Vector4 ToVector4() const override {
+		constexpr xna::Vector4 ToVector4() const {
 			Vector2 vector2 = ToVector2();
 			return Vector4(vector2.X, vector2.Y, 0.0, 1.0);
 		}
 
-		virtual constexpr void PackFromVector4(xna::Vector4 const& vector) override {
+		constexpr void PackFromVector4(xna::Vector4 const& vector) {
 			packedValue = PackHelper(vector.X, vector.Y);
 		}
 
@@ -563,9 +688,71 @@ namespace xna {
 	};
 }
 
+//HalfVector4
+namespace xna {
+	struct HalfVector4 : IPackedVectorT<csulong> {
+		static constexpr PackedFormat Format{ PackedKind::Half, { { 0, 16 }, { 16, 16 }, { 32, 16 }, { 48, 16 } } };
+
+		constexpr HalfVector4() = default;
+
+		constexpr HalfVector4(double x, double y, double z, double w) :
+			packedValue(PackHelper(x, y, z, w)) {
+		}
+
+		constexpr HalfVector4(Vector4 const& vector) :
+			packedValue(PackHelper(vector.X, vector.Y, vector.Z, vector.W)) {
+		}
+
+		constexpr csulong PackedValue() const {
+			return packedValue;
+		}
+
+		constexpr void PackedValue(csulong const& value) {
+			packedValue = value;
+		}
+
+		constexpr xna::Vector4 ToVector4() const {
+			Vector4 vector4;
+			vector4.X = HalfUtils::Unpack(static_cast<csushort>(packedValue));
+			vector4.Y = HalfUtils::Unpack(static_cast<csushort>(packedValue >> 16));
+			vector4.Z = HalfUtils::Unpack(static_cast<csushort>(packedValue >> 32));
+			vector4.W = HalfUtils::Unpack(static_cast<csushort>(packedValue >> 48));
+			return vector4;
+		}
+
+		constexpr void PackFromVector4(xna::Vector4 const& vector) {
+			packedValue = PackHelper(vector.X, vector.Y, vector.Z, vector.W);
+		}
+
+		constexpr bool Equals(HalfVector4 other) const {
+			return packedValue == other.packedValue;
+		}
+
+		friend constexpr bool operator ==(HalfVector4 const& a, HalfVector4 const& b) {
+			return a.Equals(b);
+		}
+
+		friend constexpr bool operator !=(HalfVector4 const& a, HalfVector4 const& b) {
+			return !a.Equals(b);
+		}
+
+	private:
+		csulong packedValue{ 0 };
+
+		static constexpr csulong PackHelper(double vectorX, double vectorY, double vectorZ, double vectorW) {
+			return toulong(HalfUtils::Pack(vectorX))
+				| toulong(HalfUtils::Pack(vectorY)) << 16
+				| toulong(HalfUtils::Pack(vectorZ)) << 32
+				| toulong(HalfUtils::Pack(vectorW)) << 48;
+		}
+	};
+}
+
 //NormalizedByte2
 namespace xna {
 	struct NormalizedByte2 : IPackedVectorT<csushort> {
+		static constexpr PackedFormat Format{ PackedKind::SNorm, { { 0, 8 }, { 8, 8 }, { 0, 0 }, { 0, 0 } } };
+
 		constexpr NormalizedByte2() = default;
 
 		constexpr NormalizedByte2(double x, double y) :
@@ -576,20 +763,20 @@ namespace xna {
 			packedValue(PackHelper(vector.X, vector.Y)) {
 		}
 
-		virtual constexpr csushort PackedValue() const override {
+		constexpr csushort PackedValue() const {
 			return packedValue;
 		}
 
-		virtual constexpr void PackedValue(csushort const& value) override {
+		constexpr void PackedValue(csushort const& value) {
 			packedValue = value;
 		}
 
-		virtual constexpr xna::Vector4 ToVector4() const override {
+		constexpr xna::Vector4 ToVector4() const {
 			Vector2 vector2 = ToVector2();
 			return Vector4(vector2.X, vector2.Y, 0.0, 1.0);
 		}
 
-		virtual constexpr void PackFromVector4(xna::Vector4 const& vector) override {
+		constexpr void PackFromVector4(xna::Vector4 const& vector) {
 			packedValue = PackHelper(vector.X, vector.Y);
 		}
 
@@ -625,6 +812,8 @@ namespace xna {
 //NormalizedByte4
 namespace xna {
 	struct NormalizedByte4 : IPackedVectorT<csuint> {
+		static constexpr PackedFormat Format{ PackedKind::SNorm, { { 0, 8 }, { 8, 8 }, { 16, 8 }, { 24, 8 } } };
+
 		constexpr NormalizedByte4() = default;
 
 		constexpr NormalizedByte4(double x, double y, double z, double w) :
@@ -635,15 +824,15 @@ namespace xna {
 			packedValue(PackHelper(vector.X, vector.Y, vector.Z, vector.W)) {
 		}
 
-		virtual constexpr csuint PackedValue() const override {
+		constexpr csuint PackedValue() const {
 			return packedValue;
 		}
 
-		virtual constexpr void PackedValue(csuint const& value) override {
+		constexpr void PackedValue(csuint const& value) {
 			packedValue = value;
 		}
 
-		virtual constexpr xna::Vector4 ToVector4() const override {
+		constexpr xna::Vector4 ToVector4() const {
 			Vector4 vector4;
 			vector4.X = PackUtils::UnpackSNorm(touint(byte_max), packedValue);
 			vector4.Y = PackUtils::UnpackSNorm(touint(byte_max), packedValue >> 8);
@@ -652,7 +841,7 @@ namespace xna {
 			return vector4;
 		}
 
-		virtual constexpr void PackFromVector4(xna::Vector4 const& vector) override {
+		constexpr void PackFromVector4(xna::Vector4 const& vector) {
 			packedValue = NormalizedByte4::PackHelper(vector.X, vector.Y, vector.Z, vector.W);
 		}		
 
@@ -684,6 +873,8 @@ namespace xna {
 //NormalizedShort2
 namespace xna {
 	struct NormalizedShort2 : IPackedVectorT<csuint> {
+		static constexpr PackedFormat Format{ PackedKind::SNorm, { { 0, 16 }, { 16, 16 }, { 0, 0 }, { 0, 0 } } };
+
 		constexpr NormalizedShort2() = default;
 
 		constexpr NormalizedShort2(double x, double y) :
@@ -694,20 +885,20 @@ namespace xna {
 			packedValue(PackHelper(vector.X, vector.Y)) {
 		}
 
-		virtual constexpr csuint PackedValue() const override {
+		constexpr csuint PackedValue() const {
 			return packedValue;
 		}
 
-		virtual constexpr void PackedValue(csuint const& value) override {
+		constexpr void PackedValue(csuint const& value) {
 			packedValue = value;
 		}
 
-		virtual constexpr xna::Vector4 ToVector4() const override {
+		constexpr xna::Vector4 ToVector4() const {
 			Vector2 vector2 = ToVector2();
 			return Vector4(vector2.X, vector2.Y, 0.0, 1.0);
 		}
 
-		virtual constexpr void PackFromVector4(xna::Vector4 const& vector) override {
+		constexpr void PackFromVector4(xna::Vector4 const& vector) {
 			packedValue = NormalizedShort2::PackHelper(vector.X, vector.Y);
 		}
 
@@ -744,6 +935,8 @@ namespace xna {
 //NormalizedShort4
 namespace xna {
 	struct NormalizedShort4 : IPackedVectorT<csulong> {
+		static constexpr PackedFormat Format{ PackedKind::SNorm, { { 0, 16 }, { 16, 16 }, { 32, 16 }, { 48, 16 } } };
+
 		constexpr NormalizedShort4() = default;
 
 		constexpr NormalizedShort4(double x, double y, double z, double w) :
@@ -754,15 +947,15 @@ namespace xna {
 			packedValue(PackHelper(vector.X, vector.Y, vector.Z, vector.W)) {
 		}
 
-		virtual constexpr csulong PackedValue() const override {
+		constexpr csulong PackedValue() const {
 			return packedValue;
 		}
 
-		virtual constexpr void PackedValue(csulong const& value) override {
+		constexpr void PackedValue(csulong const& value) {
 			packedValue = value;
 		}
 
-		virtual constexpr xna::Vector4 ToVector4() const override {
+		constexpr xna::Vector4 ToVector4() const {
 			Vector4 vector4;
 			vector4.X = PackUtils::UnpackSNorm(touint(ushort_max), touint(packedValue));
 			vector4.Y = PackUtils::UnpackSNorm(touint(ushort_max), touint(packedValue >> 16));
@@ -771,7 +964,7 @@ namespace xna {
 			return vector4;
 		}
 
-		virtual constexpr void PackFromVector4(xna::Vector4 const& vector) override {
+		constexpr void PackFromVector4(xna::Vector4 const& vector) {
 			packedValue = PackHelper(vector.X, vector.Y, vector.Z, vector.W);
 		}
 
@@ -809,6 +1002,8 @@ namespace xna {
 //Rg32
 namespace xna {
 	struct Rg32 : IPackedVectorT<csuint> {
+		static constexpr PackedFormat Format{ PackedKind::UNorm, { { 0, 16 }, { 16, 16 }, { 0, 0 }, { 0, 0 } } };
+
 		constexpr Rg32() = default;
 
 		constexpr Rg32(double x, double y) :
@@ -819,20 +1014,20 @@ namespace xna {
 			packedValue(PackHelper(vector.X, vector.Y)) {
 		}
 
-		virtual constexpr csuint PackedValue() const override {
+		constexpr csuint PackedValue() const {
 			return packedValue;
 		}
 
-		virtual constexpr void PackedValue(csuint const& value) override {
+		constexpr void PackedValue(csuint const& value) {
 			packedValue = value;
 		}
 
-		virtual constexpr xna::Vector4 ToVector4() const override {
+		constexpr xna::Vector4 ToVector4() const {
 			Vector2 vector2 = ToVector2();
-			return Vector4(vector2.X, vector2.Y);
+			return Vector4(vector2.X, vector2.Y, 0.0, 1.0);
 		}
 
-		virtual constexpr void PackFromVector4(xna::Vector4 const& vector) override {
+		constexpr void PackFromVector4(xna::Vector4 const& vector) {
 			packedValue = PackHelper(vector.X, vector.Y);
 		}
 
@@ -868,6 +1063,8 @@ namespace xna {
 //Rgba64
 namespace xna {
 	struct Rgba64 : IPackedVectorT<csulong> {
+		static constexpr PackedFormat Format{ PackedKind::UNorm, { { 0, 16 }, { 16, 16 }, { 32, 16 }, { 48, 16 } } };
+
 		constexpr Rgba64() = default;
 
 		constexpr Rgba64(double x, double y, double z, double w) :
@@ -875,18 +1072,18 @@ namespace xna {
 		}
 
 		constexpr Rgba64(Vector4 const& vector) :
-			packedValue(PackHelper(vector.X, vector.Y, vector.X, vector.W)) {
+			packedValue(PackHelper(vector.X, vector.Y, vector.Z, vector.W)) {
 		}
 
-		virtual constexpr csulong PackedValue() const override {
+		constexpr csulong PackedValue() const {
 			return packedValue;
 		}
 
-		virtual constexpr void PackedValue(csulong const& value) override {
+		constexpr void PackedValue(csulong const& value) {
 			packedValue = value;
 		}
 
-		virtual constexpr xna::Vector4 ToVector4() const override {
+		constexpr xna::Vector4 ToVector4() const {
 			Vector4 vector4;
 			vector4.X = PackUtils::UnpackUNorm(touint(ushort_max), touint(packedValue));
 			vector4.Y = PackUtils::UnpackUNorm(touint(ushort_max), touint(packedValue >> 16));
@@ -895,7 +1092,7 @@ namespace xna {
 			return vector4;
 		}
 
-		virtual constexpr void PackFromVector4(xna::Vector4 const& vector) override {
+		constexpr void PackFromVector4(xna::Vector4 const& vector) {
 			packedValue = PackHelper(vector.X, vector.Y, vector.Z, vector.W);
 		}
 
@@ -926,6 +1123,8 @@ namespace xna {
 //Rgba1010102
 namespace xna {
 	struct Rgba1010102 : IPackedVectorT<csuint> {
+		static constexpr PackedFormat Format{ PackedKind::UNorm, { { 0, 10 }, { 10, 10 }, { 20, 10 }, { 30, 2 } } };
+
 		constexpr Rgba1010102() = default;
 
 		constexpr Rgba1010102(double x, double y, double z, double w) :
@@ -933,18 +1132,18 @@ namespace xna {
 		}
 
 		constexpr Rgba1010102(Vector4 const& vector) :
-			packedValue(PackHelper(vector.X, vector.Y, vector.X, vector.W)) {
+			packedValue(PackHelper(vector.X, vector.Y, vector.Z, vector.W)) {
 		}
 
-		virtual constexpr csuint PackedValue() const override {
+		constexpr csuint PackedValue() const {
 			return packedValue;
 		}
 
-		virtual constexpr void PackedValue(csuint const& value) override {
+		constexpr void PackedValue(csuint const& value) {
 			packedValue = value;
 		}
 
-		virtual constexpr xna::Vector4 ToVector4() const override {
+		constexpr xna::Vector4 ToVector4() const {
 			Vector4 vector4;
 			vector4.X = PackUtils::UnpackUNorm(1023U, packedValue);
 			vector4.Y = PackUtils::UnpackUNorm(1023U, packedValue >> 10);
@@ -953,7 +1152,7 @@ namespace xna {
 			return vector4;
 		}
 
-		virtual constexpr void PackFromVector4(xna::Vector4 const& vector) override {
+		constexpr void PackFromVector4(xna::Vector4 const& vector) {
 			packedValue = PackHelper(vector.X, vector.Y, vector.Z, vector.W);
 		}
 
@@ -984,6 +1183,8 @@ namespace xna {
 //Short2
 namespace xna {
 	struct Short2 : IPackedVectorT<csuint> {
+		static constexpr PackedFormat Format{ PackedKind::Signed, { { 0, 16 }, { 16, 16 }, { 0, 0 }, { 0, 0 } } };
+
 		constexpr Short2() = default;
 
 		constexpr Short2(double x, double y) :
@@ -994,30 +1195,41 @@ namespace xna {
 			packedValue(PackHelper(vector.X, vector.Y)) {
 		}
 
-		virtual constexpr csuint PackedValue() const override {
+		constexpr csuint PackedValue() const {
 			return packedValue;
 		}
 
-		virtual constexpr void PackedValue(csuint const& value) override {
+		constexpr void PackedValue(csuint const& value) {
 			packedValue = value;
 		}
 
-		virtual constexpr Vector4 ToVector4() const override {
+		constexpr Vector4 ToVector4() const {
 			Vector2 vector2 = ToVector2();
 			return Vector4(vector2.X, vector2.Y, 0.0, 1.0);
 		}
 
-		virtual constexpr void PackFromVector4(xna::Vector4 const& vector) override {
+		constexpr void PackFromVector4(xna::Vector4 const& vector) {
 			packedValue = PackHelper(vector.X, vector.Y);
 		}
 
 		constexpr Vector2 ToVector2() const	{
 			Vector2 vector2;
-			vector2.X = todouble(packedValue);
-			vector2.Y = todouble(packedValue >> 16);
+			vector2.X = todouble(static_cast<csshort>(packedValue));
+			vector2.Y = todouble(static_cast<csshort>(packedValue >> 16));
 			return vector2;
 		}
 
+		constexpr bool Equals(Short2 other) const {
+			return packedValue == other.packedValue;
+		}
+
+		friend constexpr bool operator ==(Short2 const& a, Short2 const& b) {
+			return a.Equals(b);
+		}
+
+		friend constexpr bool operator !=(Short2 const& a, Short2 const& b) {
+			return !a.Equals(b);
+		}
 
 	private:
 		csuint packedValue{ 0 };
@@ -1034,6 +1246,8 @@ namespace xna {
 //Short4
 namespace xna {
 	struct Short4 : IPackedVectorT<csulong> {
+		static constexpr PackedFormat Format{ PackedKind::Signed, { { 0, 16 }, { 16, 16 }, { 32, 16 }, { 48, 16 } } };
+
 		constexpr Short4() = default;
 
 		constexpr Short4(double x, double y, double z, double w) :
@@ -1044,27 +1258,38 @@ namespace xna {
 			packedValue(PackHelper(vector.X, vector.Y, vector.Z, vector.W)) {
 		}
 
-		virtual constexpr csulong PackedValue() const override {
+		constexpr csulong PackedValue() const {
 			return packedValue;
 		}
 
-		virtual constexpr void PackedValue(csulong const& value) override {
+		constexpr void PackedValue(csulong const& value) {
 			packedValue = value;
 		}
 
-		virtual constexpr Vector4 ToVector4() const override {
+		constexpr Vector4 ToVector4() const {
 			Vector4 vector4;
-			vector4.X = todouble(packedValue);
-			vector4.Y = todouble(packedValue >> 16);
-			vector4.Z = todouble(packedValue >> 32);
-			vector4.W = todouble(packedValue >> 48);
+			vector4.X = todouble(static_cast<csshort>(packedValue));
+			vector4.Y = todouble(static_cast<csshort>(packedValue >> 16));
+			vector4.Z = todouble(static_cast<csshort>(packedValue >> 32));
+			vector4.W = todouble(static_cast<csshort>(packedValue >> 48));
 			return vector4;
 		}
 
-		virtual constexpr void PackFromVector4(xna::Vector4 const& vector) override {
+		constexpr void PackFromVector4(xna::Vector4 const& vector) {
 			packedValue = PackHelper(vector.X, vector.Y, vector.Z, vector.W);
-		}		
+		}
 
+		constexpr bool Equals(Short4 other) const {
+			return packedValue == other.packedValue;
+		}
+
+		friend constexpr bool operator ==(Short4 const& a, Short4 const& b) {
+			return a.Equals(b);
+		}
+
+		friend constexpr bool operator !=(Short4 const& a, Short4 const& b) {
+			return !a.Equals(b);
+		}
 
 	private:
 		csulong packedValue{ 0 };
@@ -1079,4 +1304,94 @@ namespace xna {
 	};
 }
 
+
+//AnyPackedVector
+namespace xna {
+	static_assert(PackedVector<Alpha8> && sizeof(Alpha8) == 1);
+	static_assert(PackedVector<Bgr565> && sizeof(Bgr565) == 2);
+	static_assert(PackedVector<Bgra4444> && sizeof(Bgra4444) == 2);
+	static_assert(PackedVector<Bgra5551> && sizeof(Bgra5551) == 2);
+	static_assert(PackedVector<Byte4> && sizeof(Byte4) == 4);
+	static_assert(PackedVector<HalfSingle> && sizeof(HalfSingle) == 2);
+	static_assert(PackedVector<HalfVector2> && sizeof(HalfVector2) == 4);
+	static_assert(PackedVector<HalfVector4> && sizeof(HalfVector4) == 8);
+	static_assert(PackedVector<NormalizedByte2> && sizeof(NormalizedByte2) == 2);
+	static_assert(PackedVector<NormalizedByte4> && sizeof(NormalizedByte4) == 4);
+	static_assert(PackedVector<NormalizedShort2> && sizeof(NormalizedShort2) == 4);
+	static_assert(PackedVector<NormalizedShort4> && sizeof(NormalizedShort4) == 8);
+	static_assert(PackedVector<Rg32> && sizeof(Rg32) == 4);
+	static_assert(PackedVector<Rgba64> && sizeof(Rgba64) == 8);
+	static_assert(PackedVector<Rgba1010102> && sizeof(Rgba1010102) == 4);
+	static_assert(PackedVector<Short2> && sizeof(Short2) == 4);
+	static_assert(PackedVector<Short4> && sizeof(Short4) == 8);
+
+	//A value of any packed vector type, with the type chosen at run time.
+	//The packed bits are held inline and every conversion is an indirect
+	//call, as with a virtual interface.
+	class AnyPackedVector {
+	public:
+		constexpr AnyPackedVector() = default;
+
+		template <PackedVector T>
+		constexpr AnyPackedVector(T const& value) :
+			operations(&OperationsOf<T>),
+			packedValue(static_cast<csulong>(value.PackedValue())) {
+		}
+
+		//Whether this holds a T.
+		template <PackedVector T>
+		constexpr bool Is() const {
+			return operations == &OperationsOf<T>;
+		}
+
+		//The value as a T, reading its bits as T's packed value.
+		template <PackedVector T>
+		constexpr T As() const {
+			T value;
+			value.PackedValue(static_cast<typename T::PackedType>(packedValue));
+			return value;
+		}
+
+		constexpr Vector4 ToVector4() const {
+			return operations ? operations->ToVector4(packedValue) : Vector4();
+		}
+
+		constexpr void PackFromVector4(Vector4 const& vector) {
+			if (operations)
+				packedValue = operations->PackFromVector4(vector);
+		}
+
+		constexpr csulong PackedValue() const {
+			return packedValue;
+		}
+
+		constexpr void PackedValue(csulong const& value) {
+			packedValue = value;
+		}
+
+	private:
+		struct Operations {
+			Vector4(*ToVector4)(csulong packedValue);
+			csulong(*PackFromVector4)(Vector4 const& vector);
+		};
+
+		template <PackedVector T>
+		static constexpr Operations OperationsOf{
+			[](csulong packedValue) {
+				T value;
+				value.PackedValue(static_cast<typename T::PackedType>(packedValue));
+				return value.ToVector4();
+			},
+			[](Vector4 const& vector) {
+				T value;
+				value.PackFromVector4(vector);
+				return static_cast<csulong>(value.PackedValue());
+			}
+		};
+
+		Operations const* operations{ nullptr };
+		csulong packedValue{ 0 };
+	};
+}
+
 #endif
\ No newline at end of file
@@ -1 +1,650 @@
-#include "texture.hpp"
\ No newline at end of file
+#include "texture.hpp"
+#include "packedconvert.hpp"
+#include "../color.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <thread>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define XNA_TEXTURE_SSE2
+#endif
+
+//Texture2D
+namespace xna {
+	Texture2D::Texture2D(csint width, csint height, bool mipMap, SurfaceFormat format) :
+		Texture2D(width, height, mipMap ? FullLevelCount(width, height) : 1, format) {
+	}
+
+	Texture2D::Texture2D(csint width, csint height, csint levelCount, SurfaceFormat format) {
+		if (width <= 0 || height <= 0 || ElementSize(format) == 0 || levelCount < 1 || levelCount > FullLevelCount(width, height))
+			return;
+
+		std::vector<size_t> offsets(static_cast<size_t>(levelCount) + 1);
+		size_t size = 0;
+
+		for (csint level = 0; level < levelCount; ++level) {
+			const auto levelBytes = LevelByteCount(LevelSize(width, level), LevelSize(height, level), format);
+
+			if (levelBytes == 0 || levelBytes > std::numeric_limits<size_t>::max() - size)
+				return;
+
+			offsets[level] = size;
+			size += levelBytes;
+		}
+
+		offsets[levelCount] = size;
+
+		_width = width;
+		_height = height;
+		_levelCount = levelCount;
+		_format = format;
+		_offsets = std::move(offsets);
+		_data.resize(size);
+	}
+
+	std::span<csbyte> Texture2D::LevelData(csint level) {
+		if (level < 0 || level >= _levelCount)
+			return {};
+
+		return std::span<csbyte>(_data.data() + _offsets[level], _offsets[level + 1] - _offsets[level]);
+	}
+
+	std::span<const csbyte> Texture2D::LevelData(csint level) const {
+		if (level < 0 || level >= _levelCount)
+			return {};
+
+		return std::span<const csbyte>(_data.data() + _offsets[level], _offsets[level + 1] - _offsets[level]);
+	}
+
+	bool Texture2D::Region(csint level, Rectangle const* rect, size_t bytes, size_t elementSize, DataRegion& region) const {
+		const auto formatSize = static_cast<size_t>(ElementSize(_format));
+
+		if (level < 0 || level >= _levelCount || elementSize == 0 || formatSize % elementSize != 0)
+			return false;
+
+		const auto width = LevelWidth(level);
+		const auto height = LevelHeight(level);
+		const auto area = rect ? *rect : Rectangle(0, 0, width, height);
+		const auto right = static_cast<cslong>(area.X) + area.Width;
+		const auto bottom = static_cast<cslong>(area.Y) + area.Height;
+
+		if (area.X < 0 || area.Y < 0 || area.Width < 0 || area.Height < 0 || right > width || bottom > height)
+			return false;
+
+		const auto block = IsCompressed(_format) ? 4 : 1;
+
+		//Dxt rects start on a block and end on one, or on the level's edge.
+		if (block > 1) {
+			if (area.X % block != 0 || area.Y % block != 0)
+				return false;
+
+			if ((area.Width % block != 0 && right != width) || (area.Height % block != 0 && bottom != height))
+				return false;
+		}
+
+		region.RowBytes = BlockCount(area.Width, _format) * formatSize;
+		region.Rows = BlockCount(area.Height, _format);
+		region.Stride = BlockCount(width, _format) * formatSize;
+		region.Offset = _offsets[level] + static_cast<size_t>(area.Y / block) * region.Stride + static_cast<size_t>(area.X / block) * formatSize;
+
+		return bytes == region.RowBytes * region.Rows;
+	}
+
+	bool Texture2D::GetBytes(csint level, Rectangle const* rect, std::span<std::byte> data, size_t elementSize) const {
+		DataRegion region;
+
+		if (!Region(level, rect, data.size(), elementSize, region))
+			return false;
+
+		auto source = _data.data() + region.Offset;
+		auto destination = data.data();
+
+		if (region.RowBytes == region.Stride) {
+			std::memcpy(destination, source, data.size());
+			return true;
+		}
+
+		for (size_t row = 0; row < region.Rows; ++row)
+			std::memcpy(destination + row * region.RowBytes, source + row * region.Stride, region.RowBytes);
+
+		return true;
+	}
+
+	bool Texture2D::SetBytes(csint level, Rectangle const* rect, std::span<const std::byte> data, size_t elementSize) {
+		DataRegion region;
+
+		if (!Region(level, rect, data.size(), elementSize, region))
+			return false;
+
+		auto source = data.data();
+		auto destination = _data.data() + region.Offset;
+
+		if (region.RowBytes == region.Stride) {
+			std::memcpy(destination, source, data.size());
+			return true;
+		}
+
+		for (size_t row = 0; row < region.Rows; ++row)
+			std::memcpy(destination + row * region.Stride, source + row * region.RowBytes, region.RowBytes);
+
+		return true;
+	}
+}
+
+//Mipmap generation
+namespace xna {
+	//One level as the mip filters see it.
+	struct MipSurface {
+		csbyte* Data{ nullptr };
+		csint Width{ 0 };
+		csint Height{ 0 };
+		size_t Stride{ 0 };
+	};
+
+	//For each destination texel along one axis, the Count source texels it
+	//is filtered from, clamped to the edge, and their weights. Texels with
+	//fewer taps are padded with zero weights.
+	struct MipTaps {
+		csint Count{ 0 };
+		std::vector<csint> Index;
+		std::vector<float> Weight;
+	};
+
+	using MipTapList = std::vector<std::vector<std::pair<csint, double>>>;
+
+	static MipTaps FlattenTaps(MipTapList const& list) {
+		MipTaps taps;
+
+		for (auto const& texel : list)
+			taps.Count = std::max(taps.Count, static_cast<csint>(texel.size()));
+
+		taps.Index.resize(list.size() * taps.Count);
+		taps.Weight.resize(list.size() * taps.Count);
+
+		for (size_t x = 0; x < list.size(); ++x) {
+			for (csint k = 0; k < taps.Count; ++k) {
+				const auto tap = x * taps.Count + k;
+
+				if (k < static_cast<csint>(list[x].size())) {
+					taps.Index[tap] = list[x][k].first;
+					taps.Weight[tap] = static_cast<float>(list[x][k].second);
+				}
+				else {
+					taps.Index[tap] = list[x][0].first;
+				}
+			}
+		}
+
+		return taps;
+	}
+
+	//Weights each source texel by how much of the destination texel it covers.
+	static MipTaps BoxTaps(csint source, csint destination) {
+		const auto scale = static_cast<double>(source) / destination;
+		MipTapList list(static_cast<size_t>(destination));
+
+		for (csint x = 0; x < destination; ++x) {
+			const auto begin = x * scale;
+			const auto end = (x + 1) * scale;
+
+			for (auto i = static_cast<csint>(begin); i < end && i < source; ++i) {
+				const auto cover = std::min(end, i + 1.0) - std::max(begin, static_cast<double>(i));
+
+				if (cover > 1e-9)
+					list[x].emplace_back(i, cover / scale);
+			}
+		}
+
+		return FlattenTaps(list);
+	}
+
+	static double Bessel0(double x) {
+		const auto half = x * 0.5;
+		double sum = 1.0;
+		double term = 1.0;
+
+		for (csint k = 1; k < 64 && term > sum * 1e-16; ++k) {
+			term *= (half / k) * (half / k);
+			sum += term;
+		}
+
+		return sum;
+	}
+
+	//Kaiser windowed sinc over three destination texels either side, with
+	//the usual alpha of 4.
+	static MipTaps KaiserTaps(csint source, csint destination) {
+		if (source == destination)
+			return BoxTaps(source, destination);
+
+		constexpr double width = 3.0;
+		constexpr double alpha = 4.0;
+		constexpr double pi = 3.14159265358979323846;
+
+		const auto scale = static_cast<double>(source) / destination;
+		const auto normal = 1.0 / Bessel0(alpha);
+		MipTapList list(static_cast<size_t>(destination));
+
+		for (csint x = 0; x < destination; ++x) {
+			const auto center = (x + 0.5) * scale;
+			const auto first = static_cast<csint>(std::ceil(center - width * scale - 0.5));
+			const auto last = static_cast<csint>(std::floor(center + width * scale - 0.5));
+			double total = 0.0;
+
+			for (auto i = first; i <= last; ++i) {
+				const auto distance = (i + 0.5 - center) / scale;
+				const auto ratio = distance / width;
+
+				if (ratio <= -1.0 || ratio >= 1.0)
+					continue;
+
+				const auto sinc = distance == 0.0 ? 1.0 : std::sin(pi * distance) / (pi * distance);
+				const auto weight = sinc * Bessel0(alpha * std::sqrt(1.0 - ratio * ratio)) * normal;
+
+				list[x].emplace_back(std::clamp(i, 0, source - 1), weight);
+				total += weight;
+			}
+
+			for (auto& tap : list[x])
+				tap.second /= total;
+		}
+
+		return FlattenTaps(list);
+	}
+
+	static MipTaps MakeTaps(MipmapFilter filter, csint source, csint destination) {
+		return filter == MipmapFilter::Kaiser ? KaiserTaps(source, destination) : BoxTaps(source, destination);
+	}
+
+	//Texels are filtered as four floats, which fits one SSE register and
+	//keeps the precision of every format's components.
+	struct MipTexel {
+		float X{ 0.0F };
+		float Y{ 0.0F };
+		float Z{ 0.0F };
+		float W{ 0.0F };
+	};
+
+	//destination[x] = sum of weight * source[index] over the taps of x.
+	static void FilterRow(MipTexel const* source, MipTexel* destination, MipTaps const& taps, csint count) {
+		for (csint x = 0; x < count; ++x) {
+			const auto index = taps.Index.data() + static_cast<size_t>(x) * taps.Count;
+			const auto weight = taps.Weight.data() + static_cast<size_t>(x) * taps.Count;
+#ifdef XNA_TEXTURE_SSE2
+			//Two sums, so consecutive taps do not wait on each other's add.
+			auto even = _mm_setzero_ps();
+			auto odd = _mm_setzero_ps();
+			csint k = 0;
+
+			for (; k + 2 <= taps.Count; k += 2) {
+				even = _mm_add_ps(even, _mm_mul_ps(_mm_set1_ps(weight[k]), _mm_loadu_ps(&source[index[k]].X)));
+				odd = _mm_add_ps(odd, _mm_mul_ps(_mm_set1_ps(weight[k + 1]), _mm_loadu_ps(&source[index[k + 1]].X)));
+			}
+
+			if (k < taps.Count)
+				even = _mm_add_ps(even, _mm_mul_ps(_mm_set1_ps(weight[k]), _mm_loadu_ps(&source[index[k]].X)));
+
+			_mm_storeu_ps(&destination[x].X, _mm_add_ps(even, odd));
+#else
+			MipTexel sum;
+
+			for (csint k = 0; k < taps.Count; ++k) {
+				auto const& texel = source[index[k]];
+
+				sum.X += weight[k] * texel.X;
+				sum.Y += weight[k] * texel.Y;
+				sum.Z += weight[k] * texel.Z;
+				sum.W += weight[k] * texel.W;
+			}
+
+			destination[x] = sum;
+#endif
+		}
+	}
+
+	static void AddScaled(MipTexel* destination, MipTexel const* source, float weight, csint count) {
+#ifdef XNA_TEXTURE_SSE2
+		const auto w = _mm_set1_ps(weight);
+
+		for (csint x = 0; x < count; ++x)
+			_mm_storeu_ps(&destination[x].X, _mm_add_ps(_mm_loadu_ps(&destination[x].X), _mm_mul_ps(w, _mm_loadu_ps(&source[x].X))));
+#else
+		for (csint x = 0; x < count; ++x) {
+			destination[x].X += weight * source[x].X;
+			destination[x].Y += weight * source[x].Y;
+			destination[x].Z += weight * source[x].Z;
+			destination[x].W += weight * source[x].W;
+		}
+#endif
+	}
+
+	//Rows of a packed vector format, converted in bulk by PackedConvert
+	//through a row of Vector4.
+	template <typename T>
+	struct PackedMipCodec {
+		using Value = PackedValueType<T>;
+
+		std::vector<Vector4> Vectors;
+
+		explicit PackedMipCodec(csint width) :
+			Vectors(static_cast<size_t>(width)) {
+		}
+
+		void Unpack(csbyte const* source, MipTexel* destination, csint count) {
+			PackedConvert::Unpack<T>(std::span<const Value>(reinterpret_cast<Value const*>(source), count), std::span<Vector4>(Vectors.data(), count));
+
+			for (csint i = 0; i < count; ++i) {
+				auto const& vector = Vectors[i];
+#ifdef XNA_TEXTURE_SSE2
+				const auto xy = _mm_cvtpd_ps(_mm_loadu_pd(&vector.X));
+				const auto zw = _mm_cvtpd_ps(_mm_loadu_pd(&vector.Z));
+				_mm_storeu_ps(&destination[i].X, _mm_movelh_ps(xy, zw));
+#else
+				destination[i] = MipTexel{ static_cast<float>(vector.X), static_cast<float>(vector.Y), static_cast<float>(vector.Z), static_cast<float>(vector.W) };
+#endif
+			}
+		}
+
+		void Pack(MipTexel const* source, csbyte* destination, csint count) {
+			for (csint i = 0; i < count; ++i) {
+				auto& vector = Vectors[i];
+#ifdef XNA_TEXTURE_SSE2
+				const auto texel = _mm_loadu_ps(&source[i].X);
+				_mm_storeu_pd(&vector.X, _mm_cvtps_pd(texel));
+				_mm_storeu_pd(&vector.Z, _mm_cvtps_pd(_mm_movehl_ps(texel, texel)));
+#else
+				vector = Vector4(source[i].X, source[i].Y, source[i].Z, source[i].W);
+#endif
+			}
+
+			PackedConvert::Pack<T>(std::span<const Vector4>(Vectors.data(), count), std::span<Value>(reinterpret_cast<Value*>(destination), count));
+		}
+	};
+
+	//Color rows straight to and from floats, rounding like PackFromVector4.
+	struct ColorMipCodec {
+		explicit ColorMipCodec(csint) {
+		}
+
+		void Unpack(csbyte const* source, MipTexel* destination, csint count) {
+			constexpr auto scale = 1.0F / 255.0F;
+			csint i = 0;
+#ifdef XNA_TEXTURE_SSE2
+			const auto zero = _mm_setzero_si128();
+			const auto factor = _mm_set1_ps(scale);
+
+			for (; i + 4 <= count; i += 4) {
+				const auto texels = _mm_loadu_si128(reinterpret_cast<__m128i const*>(source + i * 4));
+				const auto low = _mm_unpacklo_epi8(texels, zero);
+				const auto high = _mm_unpackhi_epi8(texels, zero);
+
+				_mm_storeu_ps(&destination[i].X, _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(low, zero)), factor));
+				_mm_storeu_ps(&destination[i + 1].X, _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(low, zero)), factor));
+				_mm_storeu_ps(&destination[i + 2].X, _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(high, zero)), factor));
+				_mm_storeu_ps(&destination[i + 3].X, _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(high, zero)), factor));
+			}
+#endif
+			for (; i < count; ++i) {
+				const auto texel = source + i * 4;
+				destination[i] = MipTexel{ texel[0] * scale, texel[1] * scale, texel[2] * scale, texel[3] * scale };
+			}
+		}
+
+		void Pack(MipTexel const* source, csbyte* destination, csint count) {
+			csint i = 0;
+#ifdef XNA_TEXTURE_SSE2
+			const auto zero = _mm_setzero_ps();
+			const auto one = _mm_set1_ps(1.0F);
+			const auto scale = _mm_set1_ps(255.0F);
+			const auto half = _mm_set1_ps(0.5F);
+
+			const auto channels = [&](csint texel) {
+				const auto clamped = _mm_min_ps(_mm_max_ps(_mm_loadu_ps(&source[texel].X), zero), one);
+				return _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(clamped, scale), half));
+			};
+
+			for (; i + 4 <= count; i += 4) {
+				const auto low = _mm_packs_epi32(channels(i), channels(i + 1));
+				const auto high = _mm_packs_epi32(channels(i + 2), channels(i + 3));
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(destination + i * 4), _mm_packus_epi16(low, high));
+			}
+#endif
+			for (; i < count; ++i) {
+				const float texel[4]{ source[i].X, source[i].Y, source[i].Z, source[i].W };
+
+				for (size_t c = 0; c < 4; ++c)
+					destination[i * 4 + c] = static_cast<csbyte>(std::clamp(texel[c], 0.0F, 1.0F) * 255.0F + 0.5F);
+			}
+		}
+	};
+
+	//Rows of Single, Vector2 or Vector4, Components floats per texel.
+	template <size_t Components>
+	struct SingleMipCodec {
+		explicit SingleMipCodec(csint) {
+		}
+
+		void Unpack(csbyte const* source, MipTexel* destination, csint count) {
+			for (csint i = 0; i < count; ++i) {
+				float values[4]{ 0.0F, 0.0F, 0.0F, 1.0F };
+				std::memcpy(values, source + i * Components * sizeof(float), Components * sizeof(float));
+				destination[i] = MipTexel{ values[0], values[1], values[2], values[3] };
+			}
+		}
+
+		void Pack(MipTexel const* source, csbyte* destination, csint count) {
+			for (csint i = 0; i < count; ++i)
+				std::memcpy(destination + i * Components * sizeof(float), &source[i].X, Components * sizeof(float));
+		}
+	};
+
+	//Filters rows [begin, end) of destination. Source rows are unpacked and
+	//filtered horizontally once each, into a ring holding the rows the
+	//vertical taps of one destination row can reach.
+	template <typename Codec>
+	static void ResampleRows(MipSurface const& source, MipSurface const& destination, MipTaps const& columns, MipTaps const& rows, csint begin, csint end) {
+		const auto width = static_cast<size_t>(destination.Width);
+		const auto ring = static_cast<size_t>(rows.Count);
+		Codec codec(std::max(source.Width, destination.Width));
+		std::vector<MipTexel> texels(static_cast<size_t>(source.Width));
+		std::vector<MipTexel> filtered(ring * width);
+		std::vector<csint> loaded(ring, -1);
+		std::vector<MipTexel> sum(width);
+
+		for (auto y = begin; y < end; ++y) {
+			std::fill(sum.begin(), sum.end(), MipTexel());
+
+			for (csint k = 0; k < rows.Count; ++k) {
+				const auto tap = static_cast<size_t>(y) * rows.Count + k;
+				const auto weight = rows.Weight[tap];
+
+				if (weight == 0.0F)
+					continue;
+
+				const auto row = rows.Index[tap];
+				const auto slot = static_cast<size_t>(row) % ring;
+				auto line = filtered.data() + slot * width;
+
+				if (loaded[slot] != row) {
+					codec.Unpack(source.Data + row * source.Stride, texels.data(), source.Width);
+					FilterRow(texels.data(), line, columns, destination.Width);
+					loaded[slot] = row;
+				}
+
+				AddScaled(sum.data(), line, weight, destination.Width);
+			}
+
+			codec.Pack(sum.data(), destination.Data + y * destination.Stride, destination.Width);
+		}
+	}
+
+	//Box filter for Color when each axis halves or stays at 1. Channels are
+	//summed in 16 bits, so each rounds exactly to (a + b + c + d + 2) / 4.
+	static void BoxColorRows(MipSurface const& source, MipSurface const& destination, csint begin, csint end) {
+		const auto pairX = source.Width > 1 ? 1 : 0;
+		const auto pairY = source.Height > 1 ? 1 : 0;
+
+		for (auto y = begin; y < end; ++y) {
+			const auto top = source.Data + static_cast<size_t>(y << pairY) * source.Stride;
+			const auto bottom = top + pairY * source.Stride;
+			auto out = destination.Data + y * destination.Stride;
+			csint x = 0;
+#ifdef XNA_TEXTURE_SSE2
+			if (pairX) {
+				const auto zero = _mm_setzero_si128();
+				const auto two = _mm_set1_epi16(2);
+
+				for (; x + 4 <= destination.Width; x += 4) {
+					const auto a0 = _mm_loadu_si128(reinterpret_cast<__m128i const*>(top + x * 8));
+					const auto a1 = _mm_loadu_si128(reinterpret_cast<__m128i const*>(top + x * 8 + 16));
+					const auto b0 = _mm_loadu_si128(reinterpret_cast<__m128i const*>(bottom + x * 8));
+					const auto b1 = _mm_loadu_si128(reinterpret_cast<__m128i const*>(bottom + x * 8 + 16));
+
+					//Two texels per register, each column summed over both rows.
+					const auto s0 = _mm_add_epi16(_mm_unpacklo_epi8(a0, zero), _mm_unpacklo_epi8(b0, zero));
+					const auto s1 = _mm_add_epi16(_mm_unpackhi_epi8(a0, zero), _mm_unpackhi_epi8(b0, zero));
+					const auto s2 = _mm_add_epi16(_mm_unpacklo_epi8(a1, zero), _mm_unpacklo_epi8(b1, zero));
+					const auto s3 = _mm_add_epi16(_mm_unpackhi_epi8(a1, zero), _mm_unpackhi_epi8(b1, zero));
+
+					//Then each even column added to the odd one after it.
+					auto p0 = _mm_add_epi16(_mm_unpacklo_epi64(s0, s1), _mm_unpackhi_epi64(s0, s1));
+					auto p1 = _mm_add_epi16(_mm_unpacklo_epi64(s2, s3), _mm_unpackhi_epi64(s2, s3));
+					p0 = _mm_srli_epi16(_mm_add_epi16(p0, two), 2);
+					p1 = _mm_srli_epi16(_mm_add_epi16(p1, two), 2);
+
+					_mm_storeu_si128(reinterpret_cast<__m128i*>(out + x * 4), _mm_packus_epi16(p0, p1));
+				}
+			}
+#endif
+			for (; x < destination.Width; ++x) {
+				const auto left = static_cast<size_t>(x << pairX) * 4;
+				const auto right = left + pairX * 4;
+
+				for (size_t c = 0; c < 4; ++c)
+					out[x * 4 + c] = static_cast<csbyte>((top[left + c] + top[right + c] + bottom[left + c] + bottom[right + c] + 2) >> 2);
+			}
+		}
+	}
+
+	//Runs body over [0, rows) in one contiguous range per thread. Small
+	//levels stay on the calling thread, where starting threads would cost
+	//more than it saves.
+	template <typename Body>
+	static void ParallelRows(csint rows, size_t texels, csint threadCount, Body const& body) {
+		constexpr size_t texelsPerThread = 1 << 15;
+
+		const auto useful = std::max<size_t>(1, texels / texelsPerThread);
+		const auto count = static_cast<csint>(std::min({ static_cast<size_t>(threadCount), useful, static_cast<size_t>(rows) }));
+
+		if (count <= 1) {
+			body(0, rows);
+			return;
+		}
+
+		const auto split = [rows, count](csint part) {
+			return static_cast<csint>(static_cast<cslong>(rows) * part / count);
+		};
+
+		std::vector<std::thread> workers;
+		workers.reserve(static_cast<size_t>(count) - 1);
+
+		for (csint part = 1; part < count; ++part)
+			workers.emplace_back([&body, &split, part] { body(split(part), split(part + 1)); });
+
+		body(0, split(1));
+
+		for (auto& worker : workers)
+			worker.join();
+	}
+
+	template <typename Codec>
+	static void Resample(MipSurface const& source, MipSurface const& destination, MipmapFilter filter, csint threadCount) {
+		const auto columns = MakeTaps(filter, source.Width, destination.Width);
+		const auto rows = MakeTaps(filter, source.Height, destination.Height);
+		const auto texels = static_cast<size_t>(destination.Width) * destination.Height * rows.Count;
+
+		ParallelRows(destination.Height, texels, threadCount, [&](csint begin, csint end) {
+			ResampleRows<Codec>(source, destination, columns, rows, begin, end);
+		});
+	}
+
+	static void Downsample(SurfaceFormat format, MipSurface const& source, MipSurface const& destination, MipmapFilter filter, csint threadCount) {
+		switch (format) {
+		case SurfaceFormat::Color: {
+			const auto halvesX = source.Width == 1 || source.Width % 2 == 0;
+			const auto halvesY = source.Height == 1 || source.Height % 2 == 0;
+
+			if (filter == MipmapFilter::Box && halvesX && halvesY) {
+				const auto texels = static_cast<size_t>(destination.Width) * destination.Height;
+
+				ParallelRows(destination.Height, texels, threadCount, [&](csint begin, csint end) {
+					BoxColorRows(source, destination, begin, end);
+				});
+				return;
+			}
+
+			Resample<ColorMipCodec>(source, destination, filter, threadCount);
+			return;
+		}
+		case SurfaceFormat::Bgr565:
+			return Resample<PackedMipCodec<Bgr565>>(source, destination, filter, threadCount);
+		case SurfaceFormat::Bgra5551:
+			return Resample<PackedMipCodec<Bgra5551>>(source, destination, filter, threadCount);
+		case SurfaceFormat::Bgra4444:
+			return Resample<PackedMipCodec<Bgra4444>>(source, destination, filter, threadCount);
+		case SurfaceFormat::NormalizedByte2:
+			return Resample<PackedMipCodec<NormalizedByte2>>(source, destination, filter, threadCount);
+		case SurfaceFormat::NormalizedByte4:
+			return Resample<PackedMipCodec<NormalizedByte4>>(source, destination, filter, threadCount);
+		case SurfaceFormat::Rgba1010102:
+			return Resample<PackedMipCodec<Rgba1010102>>(source, destination, filter, threadCount);
+		case SurfaceFormat::Rg32:
+			return Resample<PackedMipCodec<Rg32>>(source, destination, filter, threadCount);
+		case SurfaceFormat::Rgba64:
+			return Resample<PackedMipCodec<Rgba64>>(source, destination, filter, threadCount);
+		case SurfaceFormat::Alpha8:
+			return Resample<PackedMipCodec<Alpha8>>(source, destination, filter, threadCount);
+		case SurfaceFormat::Single:
+			return Resample<SingleMipCodec<1>>(source, destination, filter, threadCount);
+		case SurfaceFormat::Vector2:
+			return Resample<SingleMipCodec<2>>(source, destination, filter, threadCount);
+		case SurfaceFormat::Vector4:
+			return Resample<SingleMipCodec<4>>(source, destination, filter, threadCount);
+		case SurfaceFormat::HalfSingle:
+			return Resample<PackedMipCodec<HalfSingle>>(source, destination, filter, threadCount);
+		case SurfaceFormat::HalfVector2:
+			return Resample<PackedMipCodec<HalfVector2>>(source, destination, filter, threadCount);
+		case SurfaceFormat::HalfVector4:
+		case SurfaceFormat::HdrBlendable:
+			return Resample<PackedMipCodec<HalfVector4>>(source, destination, filter, threadCount);
+		default:
+			return;
+		}
+	}
+
+	bool Texture2D::GenerateMipmaps(MipmapFilter filter, csint threadCount) {
+		if (IsCompressed(_format))
+			return false;
+
+		if (threadCount <= 0)
+			threadCount = std::max(1, static_cast<csint>(std::thread::hardware_concurrency()));
+
+		const auto elementSize = static_cast<size_t>(ElementSize(_format));
+
+		const auto surface = [this, elementSize](csint level) {
+			MipSurface result;
+			result.Data = _data.data() + _offsets[level];
+			result.Width = LevelWidth(level);
+			result.Height = LevelHeight(level);
+			result.Stride = static_cast<size_t>(result.Width) * elementSize;
+			return result;
+		};
+
+		for (csint level = 1; level < _levelCount; ++level)
+			Downsample(_format, surface(level - 1), surface(level), filter, threadCount);
+
+		return true;
+	}
+}
\ No newline at end of file
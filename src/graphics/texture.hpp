@@ -1,4 +1,227 @@
 #ifndef XNA_TEXTURE_HPP
 #define XNA_TEXTURE_HPP
 
+#include <cstddef>
+#include <limits>
+#include <span>
+#include <type_traits>
+#include <vector>
+#include "../basic-structs.hpp"
+#include "../csharp/integralnumeric.hpp"
+#include "enumerations.hpp"
+
+//Texture2D
+namespace xna {
+	//CPU side 2D texture: a chain of mip levels stored back to back in one
+	//buffer, each row after row in the texture's SurfaceFormat. Elements are
+	//texels, or 4x4 blocks for the Dxt formats. Nothing here touches a
+	//graphics device, so textures can be loaded, edited and mipmapped by
+	//headless content tools.
+	class Texture2D {
+	public:
+		Texture2D() = default;
+
+		//mipMap allocates the full chain down to 1x1.
+		Texture2D(csint width, csint height, bool mipMap = false, SurfaceFormat format = SurfaceFormat::Color);
+
+		//Gives an empty texture when the size is not positive, levelCount is
+		//outside 1 to the full chain or the chain's bytes do not fit in size_t.
+		Texture2D(csint width, csint height, csint levelCount, SurfaceFormat format);
+
+		constexpr csint Width() const {
+			return _width;
+		}
+
+		constexpr csint Height() const {
+			return _height;
+		}
+
+		constexpr csint LevelCount() const {
+			return _levelCount;
+		}
+
+		constexpr SurfaceFormat Format() const {
+			return _format;
+		}
+
+		constexpr Rectangle Bounds() const {
+			return Rectangle(0, 0, _width, _height);
+		}
+
+		constexpr bool IsEmpty() const {
+			return _levelCount == 0;
+		}
+
+		constexpr csint LevelWidth(csint level) const {
+			return LevelSize(_width, level);
+		}
+
+		constexpr csint LevelHeight(csint level) const {
+			return LevelSize(_height, level);
+		}
+
+		//The raw bytes of a level, empty when there is no such level.
+		std::span<csbyte> LevelData(csint level);
+		std::span<const csbyte> LevelData(csint level) const;
+
+		//The elements of a level as T, without copying. Empty when there is
+		//no such level or T is not the size of the format's elements.
+		template <typename T>
+		std::span<T> LevelData(csint level) {
+			static_assert(std::is_trivially_copyable_v<T>);
+
+			if (sizeof(T) != static_cast<size_t>(ElementSize(_format)))
+				return {};
+
+			const auto bytes = LevelData(level);
+			return std::span<T>(reinterpret_cast<T*>(bytes.data()), bytes.size() / sizeof(T));
+		}
+
+		template <typename T>
+		std::span<const T> LevelData(csint level) const {
+			static_assert(std::is_trivially_copyable_v<T>);
+
+			if (sizeof(T) != static_cast<size_t>(ElementSize(_format)))
+				return {};
+
+			const auto bytes = LevelData(level);
+			return std::span<const T>(reinterpret_cast<T const*>(bytes.data()), bytes.size() / sizeof(T));
+		}
+
+		//Copies level 0 into data.
+		template <typename T>
+		bool GetData(std::span<T> data) const {
+			return GetData(0, nullptr, data);
+		}
+
+		//Copies rect of a level, or the whole level when rect is null, into
+		//data. The format's element size must be a multiple of sizeof(T) and
+		//data must hold exactly the bytes of rect; Dxt rects must be on block
+		//boundaries. Returns false, copying nothing, otherwise.
+		template <typename T>
+		bool GetData(csint level, Rectangle const* rect, std::span<T> data) const {
+			static_assert(std::is_trivially_copyable_v<T> && !std::is_const_v<T>);
+			return GetBytes(level, rect, std::as_writable_bytes(data), sizeof(T));
+		}
+
+		template <typename T>
+		bool SetData(std::span<T> data) {
+			return SetData(0, nullptr, data);
+		}
+
+		//Copies data into rect of a level, with the same rules as GetData.
+		template <typename T>
+		bool SetData(csint level, Rectangle const* rect, std::span<T> data) {
+			static_assert(std::is_trivially_copyable_v<T>);
+			return SetBytes(level, rect, std::as_bytes(data), sizeof(T));
+		}
+
+		//Rebuilds levels 1 and up from level 0, each level from the one above
+		//it. Rows of a level are split over threadCount threads, or one per
+		//hardware thread when threadCount is 0. Returns false for the Dxt
+		//formats, which are left untouched.
+		bool GenerateMipmaps(MipmapFilter filter = MipmapFilter::Box, csint threadCount = 0);
+
+		//Bytes per element of format, where Dxt elements are 4x4 blocks.
+		static constexpr csint ElementSize(SurfaceFormat format) {
+			switch (format) {
+			case SurfaceFormat::Alpha8:
+				return 1;
+			case SurfaceFormat::Bgr565:
+			case SurfaceFormat::Bgra5551:
+			case SurfaceFormat::Bgra4444:
+			case SurfaceFormat::NormalizedByte2:
+			case SurfaceFormat::HalfSingle:
+				return 2;
+			case SurfaceFormat::Color:
+			case SurfaceFormat::NormalizedByte4:
+			case SurfaceFormat::Rgba1010102:
+			case SurfaceFormat::Rg32:
+			case SurfaceFormat::Single:
+			case SurfaceFormat::HalfVector2:
+				return 4;
+			case SurfaceFormat::Dxt1:
+			case SurfaceFormat::Rgba64:
+			case SurfaceFormat::Vector2:
+			case SurfaceFormat::HalfVector4:
+			case SurfaceFormat::HdrBlendable:
+				return 8;
+			case SurfaceFormat::Dxt3:
+			case SurfaceFormat::Dxt5:
+			case SurfaceFormat::Vector4:
+				return 16;
+			default:
+				return 0;
+			}
+		}
+
+		static constexpr bool IsCompressed(SurfaceFormat format) {
+			return format == SurfaceFormat::Dxt1 || format == SurfaceFormat::Dxt3 || format == SurfaceFormat::Dxt5;
+		}
+
+		//Bytes of one width x height level in format, or 0 when the size is not
+		//positive, the format has no element size or the count overflows size_t.
+		static constexpr size_t LevelByteCount(csint width, csint height, SurfaceFormat format) {
+			const auto elementSize = static_cast<size_t>(ElementSize(format));
+
+			if (width <= 0 || height <= 0 || elementSize == 0)
+				return 0;
+
+			const auto columns = BlockCount(width, format);
+			const auto rows = BlockCount(height, format);
+			constexpr auto max = std::numeric_limits<size_t>::max();
+
+			if (rows > max / columns || columns * rows > max / elementSize)
+				return 0;
+
+			return columns * rows * elementSize;
+		}
+
+		//Levels in the chain from width x height down to 1x1.
+		static constexpr csint FullLevelCount(csint width, csint height) {
+			auto size = width > height ? width : height;
+			csint count = 1;
+
+			while (size > 1) {
+				size >>= 1;
+				++count;
+			}
+
+			return count;
+		}
+
+	private:
+		csint _width{ 0 };
+		csint _height{ 0 };
+		csint _levelCount{ 0 };
+		SurfaceFormat _format{ SurfaceFormat::Color };
+		//Byte offset of each level in _data, plus the total size at the end.
+		std::vector<size_t> _offsets;
+		std::vector<csbyte> _data;
+
+		static constexpr csint LevelSize(csint size, csint level) {
+			return level < 0 || level >= 31 || (size >> level) < 1 ? 1 : size >> level;
+		}
+
+		//Elements across size texels, rounding Dxt blocks up without overflowing.
+		static constexpr size_t BlockCount(csint size, SurfaceFormat format) {
+			return IsCompressed(format)
+				? static_cast<size_t>(size / 4 + (size % 4 != 0 ? 1 : 0))
+				: static_cast<size_t>(size);
+		}
+
+		//Where the rows of a rect are in _data.
+		struct DataRegion {
+			size_t Offset{ 0 };
+			size_t RowBytes{ 0 };
+			size_t Stride{ 0 };
+			size_t Rows{ 0 };
+		};
+
+		bool Region(csint level, Rectangle const* rect, size_t bytes, size_t elementSize, DataRegion& region) const;
+		bool GetBytes(csint level, Rectangle const* rect, std::span<std::byte> data, size_t elementSize) const;
+		bool SetBytes(csint level, Rectangle const* rect, std::span<const std::byte> data, size_t elementSize);
+	};
+}
+
 #endif
\ No newline at end of file
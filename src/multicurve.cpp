@@ -0,0 +1 @@
+#include "multicurve.hpp"
\ No newline at end of file
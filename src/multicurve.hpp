@@ -0,0 +1,384 @@
+#ifndef XNA_MULTICURVE_HPP
+#define XNA_MULTICURVE_HPP
+
+#include "curve.hpp"
+#include "basic-structs.hpp"
+#include "color.hpp"
+#include <array>
+#include <span>
+#include <vector>
+
+namespace xna {
+	//How MultiCurve splits a value into scalar channels and back. Spherical
+	//types are interpolated with Slerp instead of per-channel Hermite.
+	template <typename T>
+	struct CurveChannels;
+
+	template <>
+	struct CurveChannels<Vector2> {
+		static constexpr size_t Count = 2;
+		static constexpr bool Spherical = false;
+
+		static constexpr void Split(Vector2 const& value, double* channels) {
+			channels[0] = value.X;
+			channels[1] = value.Y;
+		}
+
+		static constexpr Vector2 Join(double const* channels) {
+			return Vector2(channels[0], channels[1]);
+		}
+	};
+
+	template <>
+	struct CurveChannels<Vector3> {
+		static constexpr size_t Count = 3;
+		static constexpr bool Spherical = false;
+
+		static constexpr void Split(Vector3 const& value, double* channels) {
+			channels[0] = value.X;
+			channels[1] = value.Y;
+			channels[2] = value.Z;
+		}
+
+		static constexpr Vector3 Join(double const* channels) {
+			return Vector3(channels[0], channels[1], channels[2]);
+		}
+	};
+
+	template <>
+	struct CurveChannels<Vector4> {
+		static constexpr size_t Count = 4;
+		static constexpr bool Spherical = false;
+
+		static constexpr void Split(Vector4 const& value, double* channels) {
+			channels[0] = value.X;
+			channels[1] = value.Y;
+			channels[2] = value.Z;
+			channels[3] = value.W;
+		}
+
+		static constexpr Vector4 Join(double const* channels) {
+			return Vector4(channels[0], channels[1], channels[2], channels[3]);
+		}
+	};
+
+	template <>
+	struct CurveChannels<Quaternion> {
+		static constexpr size_t Count = 4;
+		static constexpr bool Spherical = true;
+
+		static constexpr void Split(Quaternion const& value, double* channels) {
+			channels[0] = value.X;
+			channels[1] = value.Y;
+			channels[2] = value.Z;
+			channels[3] = value.W;
+		}
+
+		static constexpr Quaternion Join(double const* channels) {
+			return Quaternion(channels[0], channels[1], channels[2], channels[3]);
+		}
+	};
+
+	//Colors are animated as their 0-1 components and packed again, clamped.
+	template <>
+	struct CurveChannels<Color> {
+		static constexpr size_t Count = 4;
+		static constexpr bool Spherical = false;
+
+		static constexpr void Split(Color const& value, double* channels) {
+			CurveChannels<Vector4>::Split(value.ToVector4(), channels);
+		}
+
+		static constexpr Color Join(double const* channels) {
+			return Color(CurveChannels<Vector4>::Join(channels));
+		}
+	};
+}
+
+namespace xna {
+	//A curve over a multi-component value whose channels share one key
+	//timeline. Key positions live in one sorted array, and values and tangents
+	//in one array per channel, so an evaluation does a single segment search
+	//and computes the Hermite basis once for every channel. Keys, tangents and
+	//loop types behave as on Curve. Quaternion keys are Slerped and ignore
+	//tangents, so their Linear and CycleOffset loops behave as Constant and
+	//Cycle.
+	template <typename T>
+	class MultiCurve {
+	public:
+		using Channels = CurveChannels<T>;
+		static constexpr size_t ChannelCount = Channels::Count;
+
+		constexpr MultiCurve() = default;
+
+		constexpr CurveLoopType PreLoop() const { return preLoop; }
+		constexpr void PreLoop(CurveLoopType const& value) { preLoop = value; }
+
+		constexpr CurveLoopType PostLoop() const { return postLoop; }
+		constexpr void PostLoop(CurveLoopType const& value) { postLoop = value; }
+
+		constexpr size_t Count() const { return positions.size(); }
+		constexpr bool IsConstant() const { return positions.size() <= 1; }
+
+		constexpr double Position(size_t index) const { return positions[index]; }
+		constexpr std::span<const double> Positions() const { return positions; }
+		constexpr std::span<const double> Values(size_t channel) const { return values[channel]; }
+
+		constexpr T Value(size_t index) const { return Get(values, index); }
+		constexpr void Value(size_t index, T const& value) { Set(values, index, value); }
+
+		constexpr T TangentIn(size_t index) const { return Get(tangentsIn, index); }
+		constexpr void TangentIn(size_t index, T const& value) { Set(tangentsIn, index, value); }
+
+		constexpr T TangentOut(size_t index) const { return Get(tangentsOut, index); }
+		constexpr void TangentOut(size_t index, T const& value) { Set(tangentsOut, index, value); }
+
+		constexpr CurveContinuity Continuity(size_t index) const { return continuities[index]; }
+		constexpr void Continuity(size_t index, CurveContinuity const& value) { continuities[index] = value; }
+
+		//Inserts a key after any key at the same position and returns its index.
+		constexpr size_t Add(double position, T const& value, CurveContinuity continuity = CurveContinuity::Smooth) {
+			return Add(position, value, T(), T(), continuity);
+		}
+
+		constexpr size_t Add(double position, T const& value, T const& tangentIn, T const& tangentOut,
+			CurveContinuity continuity = CurveContinuity::Smooth) {
+
+			const auto index = static_cast<size_t>(std::upper_bound(positions.begin(), positions.end(), position) - positions.begin());
+
+			positions.insert(positions.begin() + index, position);
+			continuities.insert(continuities.begin() + index, continuity);
+			Insert(values, index, value);
+			Insert(tangentsIn, index, tangentIn);
+			Insert(tangentsOut, index, tangentOut);
+
+			return index;
+		}
+
+		constexpr void RemoveAt(size_t index) {
+			positions.erase(positions.begin() + index);
+			continuities.erase(continuities.begin() + index);
+
+			for (size_t channel = 0; channel < ChannelCount; ++channel) {
+				values[channel].erase(values[channel].begin() + index);
+				tangentsIn[channel].erase(tangentsIn[channel].begin() + index);
+				tangentsOut[channel].erase(tangentsOut[channel].begin() + index);
+			}
+		}
+
+		constexpr void Clear() {
+			positions.clear();
+			continuities.clear();
+
+			for (size_t channel = 0; channel < ChannelCount; ++channel) {
+				values[channel].clear();
+				tangentsIn[channel].clear();
+				tangentsOut[channel].clear();
+			}
+		}
+
+		void ComputeTangent(size_t keyIndex, CurveTangent const& tangentType) {
+			ComputeTangent(keyIndex, tangentType, tangentType);
+		}
+
+		//Curve::ComputeTangent applied to every channel of one key.
+		void ComputeTangent(size_t keyIndex, CurveTangent const& tangentInType, CurveTangent const& tangentOutType) {
+			if (keyIndex >= positions.size())
+				return;
+
+			const auto position = positions[keyIndex];
+			const auto previous = keyIndex > 0 ? keyIndex - 1 : keyIndex;
+			const auto next = keyIndex + 1 < positions.size() ? keyIndex + 1 : keyIndex;
+			const auto previousPosition = positions[previous];
+			const auto nextPosition = positions[next];
+
+			for (size_t channel = 0; channel < ChannelCount; ++channel) {
+				auto const& channelValues = values[channel];
+				const auto value = channelValues[keyIndex];
+				const auto previousValue = channelValues[previous];
+				const auto nextValue = channelValues[next];
+				const auto delta = nextValue - previousValue;
+				const auto smooth = std::abs(delta) >= 1.1920928955078125E-07;
+
+				switch (tangentInType) {
+				case CurveTangent::Linear:
+					tangentsIn[channel][keyIndex] = value - previousValue;
+					break;
+				case CurveTangent::Smooth:
+					tangentsIn[channel][keyIndex] = smooth ? delta * std::abs(previousPosition - position) / (nextPosition - previousPosition) : 0.0;
+					break;
+				default:
+					tangentsIn[channel][keyIndex] = 0.0;
+					break;
+				}
+
+				switch (tangentOutType) {
+				case CurveTangent::Linear:
+					tangentsOut[channel][keyIndex] = nextValue - value;
+					break;
+				case CurveTangent::Smooth:
+					tangentsOut[channel][keyIndex] = smooth ? delta * std::abs(nextPosition - position) / (nextPosition - previousPosition) : 0.0;
+					break;
+				default:
+					tangentsOut[channel][keyIndex] = 0.0;
+					break;
+				}
+			}
+		}
+
+		void ComputeTangents(CurveTangent const& tangentType) {
+			ComputeTangents(tangentType, tangentType);
+		}
+
+		void ComputeTangents(CurveTangent const& tangentInType, CurveTangent const& tangentOutType) {
+			for (size_t keyIndex = 0; keyIndex < positions.size(); ++keyIndex)
+				ComputeTangent(keyIndex, tangentInType, tangentOutType);
+		}
+
+		T Evaluate(double position) const {
+			CurveCursor cursor;
+			return Evaluate(position, cursor);
+		}
+
+		T Evaluate(double position, CurveCursor& cursor) const {
+			const auto count = positions.size();
+
+			if (count == 0)
+				return T();
+
+			if (count == 1)
+				return Value(0);
+
+			const auto first = positions.front();
+			const auto last = positions.back();
+			auto t = position;
+			double cycle = 0.0;
+
+			if (t < first || last < t) {
+				const auto before = t < first;
+				const auto loop = before ? preLoop : postLoop;
+				const auto end = before ? 0 : count - 1;
+
+				if (loop == CurveLoopType::Constant || (Channels::Spherical && loop == CurveLoopType::Linear))
+					return Value(end);
+
+				if (loop == CurveLoopType::Linear) {
+					auto const& tangents = before ? tangentsIn : tangentsOut;
+					std::array<double, ChannelCount> result;
+
+					for (size_t channel = 0; channel < ChannelCount; ++channel)
+						result[channel] = values[channel][end] - tangents[channel][end] * (positions[end] - t);
+
+					return Channels::Join(result.data());
+				}
+
+				//Curve::CalcCycle
+				const auto range = last - first;
+				auto num = (t - first) * (range > 1.4012984643248171E-45 ? 1.0 / range : 0.0);
+
+				if (num < 0.0)
+					--num;
+
+				const auto cycles = static_cast<double>(static_cast<cslong>(num));
+				const auto local = t - (first + cycles * range);
+
+				t = loop == CurveLoopType::Oscillate && (static_cast<cslong>(cycles) & 1) != 0 ? last - local : first + local;
+
+				if (loop == CurveLoopType::CycleOffset && !Channels::Spherical)
+					cycle = cycles;
+			}
+
+			cursor.Segment = FindCurveSegment(t, cursor.Segment, count,
+				[this](size_t index) { return positions[index]; });
+
+			const auto index1 = cursor.Segment;
+			const auto index0 = index1 - 1;
+			const auto length = positions[index1] - positions[index0];
+			const auto amount = length > 1E-10 ? (t - positions[index0]) / length : 0.0;
+			const auto step = continuities[index0] == CurveContinuity::Step;
+
+			if constexpr (Channels::Spherical) {
+				if (step)
+					return Value(amount >= 1.0 ? index1 : index0);
+
+				return T::Slerp(Value(index0), Value(index1), amount);
+			}
+			else {
+				std::array<double, ChannelCount> result;
+
+				if (step) {
+					const auto key = amount >= 1.0 ? index1 : index0;
+
+					for (size_t channel = 0; channel < ChannelCount; ++channel) {
+						auto const& channelValues = values[channel];
+						result[channel] = (channelValues[count - 1] - channelValues[0]) * cycle + channelValues[key];
+					}
+
+					return Channels::Join(result.data());
+				}
+
+				//The Hermite basis of Curve::Hermite, shared by every channel.
+				const auto num1 = amount * amount;
+				const auto num2 = num1 * amount;
+				const auto h00 = 2.0 * num2 - 3.0 * num1 + 1.0;
+				const auto h01 = -2.0 * num2 + 3.0 * num1;
+				const auto h10 = num2 - 2.0 * num1 + amount;
+				const auto h11 = num2 - num1;
+
+				for (size_t channel = 0; channel < ChannelCount; ++channel) {
+					auto const& channelValues = values[channel];
+
+					result[channel] = (channelValues[count - 1] - channelValues[0]) * cycle
+						+ (channelValues[index0] * h00 + channelValues[index1] * h01
+						+ tangentsOut[channel][index0] * h10 + tangentsIn[channel][index1] * h11);
+				}
+
+				return Channels::Join(result.data());
+			}
+		}
+
+	private:
+		using ChannelArrays = std::array<std::vector<double>, ChannelCount>;
+
+		CurveLoopType preLoop{ CurveLoopType::Constant };
+		CurveLoopType postLoop{ CurveLoopType::Constant };
+		std::vector<double> positions;
+		std::vector<CurveContinuity> continuities;
+		ChannelArrays values;
+		ChannelArrays tangentsIn;
+		ChannelArrays tangentsOut;
+
+		static constexpr T Get(ChannelArrays const& arrays, size_t index) {
+			std::array<double, ChannelCount> channels;
+
+			for (size_t channel = 0; channel < ChannelCount; ++channel)
+				channels[channel] = arrays[channel][index];
+
+			return Channels::Join(channels.data());
+		}
+
+		static constexpr void Set(ChannelArrays& arrays, size_t index, T const& value) {
+			std::array<double, ChannelCount> channels;
+			Channels::Split(value, channels.data());
+
+			for (size_t channel = 0; channel < ChannelCount; ++channel)
+				arrays[channel][index] = channels[channel];
+		}
+
+		static constexpr void Insert(ChannelArrays& arrays, size_t index, T const& value) {
+			std::array<double, ChannelCount> channels;
+			Channels::Split(value, channels.data());
+
+			for (size_t channel = 0; channel < ChannelCount; ++channel)
+				arrays[channel].insert(arrays[channel].begin() + index, channels[channel]);
+		}
+	};
+
+	using Vector2Curve = MultiCurve<Vector2>;
+	using Vector3Curve = MultiCurve<Vector3>;
+	using Vector4Curve = MultiCurve<Vector4>;
+	using QuaternionCurve = MultiCurve<Quaternion>;
+	using ColorCurve = MultiCurve<Color>;
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,121 @@
+//Checks HalfUtils against an exact reference over every half.
+//
+//	halfutils-test
+//
+//Unpack must give the exact value of all 65536 halves and Pack must round
+//every value halfway between two halves, and its neighbours, to the nearest
+//half with ties to even. The bulk functions, which use F16C when the
+//processor has it, must agree bit for bit with the scalar table path.
+//Returns nonzero on the first category that fails.
+
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+#include "../graphics/packedvector.hpp"
+
+using xna::HalfUtils;
+
+static csint failures = 0;
+
+static void Check(bool condition, char const* what, csuint half) {
+	if (condition)
+		return;
+
+	if (failures++ < 10)
+		std::printf("FAIL %s at 0x%04X\n", what, half);
+}
+
+static bool SameBits(double a, double b) {
+	return std::memcmp(&a, &b, sizeof(double)) == 0;
+}
+
+//The value of a half, decoded field by field.
+static double Reference(csuint half) {
+	const auto sign = (half & 0x8000) != 0 ? -1.0 : 1.0;
+	const auto exponent = static_cast<csint>(half >> 10 & 31);
+	const auto mantissa = static_cast<double>(half & 1023);
+
+	if (exponent == 0)
+		return sign * std::ldexp(mantissa, -24);
+
+	if (exponent == 31)
+		return mantissa != 0 ? std::nan("") : sign * INFINITY;
+
+	return sign * std::ldexp(1024.0 + mantissa, exponent - 25);
+}
+
+static bool IsNaN(csuint half) {
+	return (half & 0x7C00) == 0x7C00 && (half & 1023) != 0;
+}
+
+int main() {
+	std::printf("F16C: %s\n", HalfUtils::HardwareAccelerated() ? "yes" : "no, bulk paths use the tables");
+
+	std::vector<csushort> halves(65536);
+
+	for (csuint half = 0; half < 65536; ++half)
+		halves[half] = static_cast<csushort>(half);
+
+	std::vector<double> values(halves.size());
+	HalfUtils::Unpack(halves, values);
+
+	for (csuint half = 0; half < 65536; ++half) {
+		const auto value = HalfUtils::Unpack(static_cast<csushort>(half));
+
+		if (IsNaN(half)) {
+			Check(std::isnan(value), "unpack NaN", half);
+			Check(IsNaN(HalfUtils::Pack(value)), "round trip NaN", half);
+		}
+		else {
+			Check(SameBits(value, Reference(half)), "unpack", half);
+			Check(HalfUtils::Pack(value) == half, "round trip", half);
+		}
+
+		Check(SameBits(value, values[half]), "bulk unpack", half);
+	}
+
+	//Each half, the midpoint to the next one and the doubles either side of
+	//that midpoint, with both signs.
+	std::vector<double> probes;
+	std::vector<csushort> expected;
+
+	const auto add = [&](double value, csuint half) {
+		probes.push_back(value);
+		expected.push_back(static_cast<csushort>(half));
+		probes.push_back(-value);
+		expected.push_back(static_cast<csushort>(half | 0x8000));
+	};
+
+	for (csuint half = 0; half < 0x7C00; ++half) {
+		const auto low = Reference(half);
+		const auto high = half == 0x7BFF ? 65536.0 : Reference(half + 1);
+		const auto middle = (low + high) / 2;
+
+		add(low, half);
+		add(std::nextafter(middle, 0.0), half);
+		add(middle, (half & 1) != 0 ? half + 1 : half);
+		add(std::nextafter(middle, INFINITY), half + 1);
+	}
+
+	add(INFINITY, 0x7C00);
+	add(1e300, 0x7C00);
+	add(3.5e38, 0x7C00);
+	add(5e-324, 0);
+
+	std::vector<csushort> packed(probes.size());
+	HalfUtils::Pack(probes, packed);
+
+	for (size_t i = 0; i < probes.size(); ++i) {
+		Check(HalfUtils::Pack(probes[i]) == expected[i], "pack", expected[i]);
+		Check(packed[i] == expected[i], "bulk pack", expected[i]);
+	}
+
+	const double nan = std::nan("");
+	csushort nanHalf = 0;
+	HalfUtils::Pack(std::span<const double>(&nan, 1), std::span<csushort>(&nanHalf, 1));
+	Check(IsNaN(nanHalf) && IsNaN(HalfUtils::Pack(nan)), "pack NaN", nanHalf);
+
+	std::printf("%d failures over 65536 halves and %zu pack probes\n", failures, probes.size());
+	return failures == 0 ? 0 : 1;
+}
\ No newline at end of file
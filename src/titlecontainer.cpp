@@ -1 +1,5 @@
-#include "titlecontainer.hpp"
\ No newline at end of file
+#include "titlecontainer.hpp"
+
+namespace xna {
+	std::string TitleContainer::location;
+}
\ No newline at end of file
@@ -1,12 +1,15 @@
 #ifndef XNA_TITLECONTAINER_HPP
 #define XNA_TITLECONTAINER_HPP
 
+#include <future>
 #include <string>
+#include <vector>
 #include "csharp/stream/stream.hpp"
 #include "csharp/uri/uri.hpp"
 #include "utilities/stringhelper.hpp"
 #include "utilities/filehelpers.hpp"
 #include "csharp/io/file.hpp"
+#include "utilities/asyncio.hpp"
 
 namespace xna {
 	struct TitleContainer {
@@ -18,18 +21,33 @@ namespace xna {
 			if (cs::Path::IsPathRooted(name))
 				return nullptr;
 
-			auto safeName = name;
-			NormalizeRelativePath(safeName);
+			const auto safeName = NormalizeRelativePath(name);
 			auto stream = PlatformOpenStream(safeName);
 
 			return stream;
 		}
 
+		//Starts reading all the named files in one batch, for instance every asset
+		//of a level manifest. Each future yields nullptr when OpenStream would fail.
+		static std::vector<std::future<std::shared_ptr<cs::MemoryStream>>> OpenStreamsAsync(std::vector<std::string> const& names) {
+			std::vector<std::string> paths;
+			paths.reserve(names.size());
+
+			for (auto const& name : names) {
+				if (name.empty() || cs::Path::IsPathRooted(name)) {
+					paths.push_back(std::string());
+					continue;
+				}
+
+				paths.push_back(cs::Path::Combine(location, NormalizeRelativePath(name)));
+			}
+
+			return AsyncIO::Default().ReadFiles(paths);
+		}
+
 		static cs::PtrStream PlatformOpenStream(std::string const& safeName) {
 			auto absolutePath = cs::Path::Combine(location, safeName);
-			auto stream = std::make_shared<cs::FileStream>(absolutePath);
-
-			return std::dynamic_pointer_cast<cs::Stream>(stream);
+			return cs::File::OpenRead(absolutePath);
 		}
 
 		static void PlatformInit() {
@@ -41,14 +59,9 @@ namespace xna {
 			return location;
 		}
 
-		static std::string NormalizeRelativePath(std::string& name) {
-			FileHelpers::UrlEncode(name);
-			auto uri = cs::Uri("file:///" + name);
-			auto path = uri.LocalPath();
-			auto subPath = path.substr(1);
-			Replace(path, FileHelpers::NotSeparator, FileHelpers::Separator);
-
-			return path;
+		//new Uri("file:///" + name).LocalPath without the leading separator.
+		static std::string NormalizeRelativePath(std::string const& name) {
+			return FileHelpers::ResolveRelativePath(std::string(), name);
 		}
 
 	private:
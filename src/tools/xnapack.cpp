@@ -0,0 +1,91 @@
+//Packs a content directory into a content package.
+//
+//	xnapack [--lz4] [--align N] <output> <directory>
+//
+//Entries are named "<directory name>/<relative path>" with '/' separators, the
+//same path ContentManager builds from RootDirectory and the asset name.
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+#include "../content/contentpackage.hpp"
+
+namespace fs = std::filesystem;
+
+static bool ReadFile(fs::path const& path, std::vector<csbyte>& data) {
+	std::ifstream file(path, std::ios::binary | std::ios::ate);
+
+	if (!file.is_open())
+		return false;
+
+	data.resize(static_cast<size_t>(file.tellg()));
+	file.seekg(0);
+	file.read(reinterpret_cast<char*>(data.data()), static_cast<std::streamsize>(data.size()));
+
+	return file.good();
+}
+
+int main(int argc, char* argv[]) {
+	auto compression = xna::ContentPackageCompression::None;
+	csuint alignment = 16;
+	std::vector<std::string> arguments;
+
+	for (int i = 1; i < argc; ++i) {
+		const std::string argument = argv[i];
+
+		if (argument == "--lz4")
+			compression = xna::ContentPackageCompression::Lz4;
+		else if (argument == "--align" && i + 1 < argc)
+			alignment = static_cast<csuint>(std::strtoul(argv[++i], nullptr, 10));
+		else
+			arguments.push_back(argument);
+	}
+
+	if (arguments.size() != 2) {
+		std::fprintf(stderr, "usage: xnapack [--lz4] [--align N] <output> <directory>\n");
+		return 1;
+	}
+
+	const fs::path root = fs::path(arguments[1]).lexically_normal();
+	const auto prefix = (root.has_filename() ? root.filename() : root.parent_path().filename()).generic_string();
+
+	std::vector<fs::path> files;
+	std::error_code error;
+
+	for (auto const& item : fs::recursive_directory_iterator(root, error)) {
+		if (item.is_regular_file())
+			files.push_back(item.path());
+	}
+
+	if (error) {
+		std::fprintf(stderr, "xnapack: cannot read %s\n", root.string().c_str());
+		return 1;
+	}
+
+	//Sorted so the same directory always produces the same package.
+	std::sort(files.begin(), files.end());
+
+	xna::ContentPackageWriter writer(alignment);
+	std::vector<csbyte> data;
+
+	for (auto const& file : files) {
+		const auto name = prefix + "/" + file.lexically_relative(root).generic_string();
+
+		if (!ReadFile(file, data) || !writer.Add(name, data, compression)) {
+			std::fprintf(stderr, "xnapack: cannot add %s\n", file.string().c_str());
+			return 1;
+		}
+	}
+
+	if (!writer.Save(arguments[0])) {
+		std::fprintf(stderr, "xnapack: cannot write %s\n", arguments[0].c_str());
+		return 1;
+	}
+
+	std::printf("%zu entries written to %s\n", files.size(), arguments[0].c_str());
+	return 0;
+}
\ No newline at end of file
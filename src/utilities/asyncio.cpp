@@ -0,0 +1,521 @@
+#include "asyncio.hpp"
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#if defined(__linux__) && __has_include(<linux/io_uring.h>)
+#define XNA_ASYNCIO_IO_URING
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#endif
+
+//AsyncFile
+namespace xna {
+#ifdef _WIN32
+	std::shared_ptr<AsyncFile> AsyncFile::Open(std::string const& path) {
+		auto file = std::make_shared<AsyncFile>();
+
+		file->_handle = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+
+		if (file->_handle == INVALID_HANDLE_VALUE) {
+			file->_handle = nullptr;
+			return nullptr;
+		}
+
+		LARGE_INTEGER size;
+
+		if (!GetFileSizeEx(file->_handle, &size))
+			return nullptr;
+
+		file->_length = size.QuadPart;
+		return file;
+	}
+
+	AsyncFile::~AsyncFile() {
+		if (_handle)
+			CloseHandle(_handle);
+	}
+
+	csint AsyncFile::Read(cslong offset, std::span<csbyte> buffer) const {
+		size_t n = 0;
+
+		while (n < buffer.size()) {
+			OVERLAPPED overlapped{};
+			const auto position = static_cast<csulong>(offset) + n;
+			overlapped.Offset = static_cast<DWORD>(position);
+			overlapped.OffsetHigh = static_cast<DWORD>(position >> 32);
+
+			DWORD read = 0;
+			const auto count = static_cast<DWORD>(std::min<size_t>(buffer.size() - n, 1u << 30));
+
+			if (!ReadFile(_handle, buffer.data() + n, count, &read, &overlapped))
+				return GetLastError() == ERROR_HANDLE_EOF ? static_cast<csint>(n) : -1;
+
+			if (read == 0)
+				break;
+
+			n += read;
+		}
+
+		return static_cast<csint>(n);
+	}
+#else
+	std::shared_ptr<AsyncFile> AsyncFile::Open(std::string const& path) {
+		auto file = std::make_shared<AsyncFile>();
+
+		file->_descriptor = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+
+		if (file->_descriptor < 0)
+			return nullptr;
+
+		struct stat status;
+
+		if (fstat(file->_descriptor, &status) != 0)
+			return nullptr;
+
+		file->_length = static_cast<cslong>(status.st_size);
+		return file;
+	}
+
+	AsyncFile::~AsyncFile() {
+		if (_descriptor >= 0)
+			close(_descriptor);
+	}
+
+	csint AsyncFile::Read(cslong offset, std::span<csbyte> buffer) const {
+		size_t n = 0;
+
+		while (n < buffer.size()) {
+			const auto read = pread(_descriptor, buffer.data() + n, buffer.size() - n, static_cast<off_t>(offset + n));
+
+			if (read < 0 && errno == EINTR)
+				continue;
+
+			if (read < 0)
+				return -1;
+
+			if (read == 0)
+				break;
+
+			n += static_cast<size_t>(read);
+		}
+
+		return static_cast<csint>(n);
+	}
+#endif
+
+	std::future<csint> AsyncFile::ReadAsync(cslong offset, std::span<csbyte> buffer) {
+		return AsyncIO::Default().ReadAsync(shared_from_this(), offset, buffer);
+	}
+}
+
+//Thread pool backend
+namespace xna {
+	class ThreadPoolIO : public AsyncIO {
+	public:
+		ThreadPoolIO(csint threads) {
+			for (csint i = 0; i < threads; ++i)
+				workers.emplace_back([this] { Work(); });
+		}
+
+		~ThreadPoolIO() override {
+			{
+				std::lock_guard lock(mutex);
+				stopping = true;
+			}
+
+			wake.notify_all();
+
+			for (auto& worker : workers)
+				worker.join();
+		}
+
+		bool IsIoUring() const override {
+			return false;
+		}
+
+		std::vector<std::future<csint>> Submit(std::span<const AsyncReadRequest> requests) override {
+			std::vector<std::future<csint>> futures;
+			futures.reserve(requests.size());
+
+			{
+				std::lock_guard lock(mutex);
+
+				for (auto const& request : requests) {
+					queue.push_back(Operation{ request, std::promise<csint>() });
+					futures.push_back(queue.back().Promise.get_future());
+				}
+			}
+
+			wake.notify_all();
+			return futures;
+		}
+
+	private:
+		struct Operation {
+			AsyncReadRequest Request;
+			std::promise<csint> Promise;
+		};
+
+		std::vector<std::thread> workers;
+		std::mutex mutex;
+		std::condition_variable wake;
+		std::deque<Operation> queue;
+		bool stopping{ false };
+
+		void Work() {
+			for (;;) {
+				std::unique_lock lock(mutex);
+				wake.wait(lock, [this] { return stopping || !queue.empty(); });
+
+				if (queue.empty())
+					return;
+
+				auto operation = std::move(queue.front());
+				queue.pop_front();
+				lock.unlock();
+
+				auto const& request = operation.Request;
+				operation.Promise.set_value(request.File ? request.File->Read(request.Offset, request.Buffer) : -1);
+			}
+		}
+	};
+
+	std::unique_ptr<AsyncIO> AsyncIO::CreateThreadPool(csint threads) {
+		return std::make_unique<ThreadPoolIO>(threads < 1 ? 1 : threads);
+	}
+}
+
+//io_uring backend
+namespace xna {
+#ifdef XNA_ASYNCIO_IO_URING
+	//Talks to the kernel through the raw syscalls: one submission queue guarded by
+	//a mutex, and one thread reaping completions.
+	class IoUringIO : public AsyncIO {
+	public:
+		~IoUringIO() override {
+			if (completer.joinable()) {
+				{
+					//user_data 0 tells the completion thread to stop.
+					std::lock_guard lock(mutex);
+					const auto sqe = NextEntry();
+					std::memset(sqe, 0, sizeof(io_uring_sqe));
+					sqe->opcode = IORING_OP_NOP;
+					Enter();
+				}
+
+				completer.join();
+			}
+
+			if (sqes)
+				munmap(sqes, sqesSize);
+
+			if (cqRing && cqRing != sqRing)
+				munmap(cqRing, cqRingSize);
+
+			if (sqRing)
+				munmap(sqRing, sqRingSize);
+
+			if (ring >= 0)
+				close(ring);
+		}
+
+		static std::unique_ptr<IoUringIO> Create(csuint entries) {
+			auto io = std::unique_ptr<IoUringIO>(new IoUringIO());
+
+			io_uring_params params;
+			std::memset(&params, 0, sizeof(params));
+
+			io->ring = static_cast<int>(syscall(__NR_io_uring_setup, entries, &params));
+
+			if (io->ring < 0)
+				return nullptr;
+
+			io->sqRingSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+			io->cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+
+			const auto singleMap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+
+			if (singleMap)
+				io->sqRingSize = io->cqRingSize = std::max(io->sqRingSize, io->cqRingSize);
+
+			io->sqRing = Map(io->ring, io->sqRingSize, IORING_OFF_SQ_RING);
+			io->cqRing = singleMap ? io->sqRing : Map(io->ring, io->cqRingSize, IORING_OFF_CQ_RING);
+			io->sqesSize = params.sq_entries * sizeof(io_uring_sqe);
+			io->sqes = static_cast<io_uring_sqe*>(Map(io->ring, io->sqesSize, IORING_OFF_SQES));
+
+			if (!io->sqRing || !io->cqRing || !io->sqes)
+				return nullptr;
+
+			const auto sq = static_cast<char*>(io->sqRing);
+			io->sqHead = reinterpret_cast<unsigned*>(sq + params.sq_off.head);
+			io->sqTail = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+			io->sqMask = *reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+			io->sqArray = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+			io->sqEntries = params.sq_entries;
+
+			const auto cq = static_cast<char*>(io->cqRing);
+			io->cqHead = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+			io->cqTail = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+			io->cqMask = *reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+			io->cqes = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+			io->cqEntries = params.cq_entries;
+
+			io->completer = std::thread([raw = io.get()] { raw->Complete(); });
+			return io;
+		}
+
+		bool IsIoUring() const override {
+			return true;
+		}
+
+		std::vector<std::future<csint>> Submit(std::span<const AsyncReadRequest> requests) override {
+			std::vector<std::future<csint>> futures;
+			futures.reserve(requests.size());
+
+			std::unique_lock lock(mutex);
+
+			for (auto const& request : requests) {
+				auto operation = new Operation{ request, std::promise<csint>() };
+				futures.push_back(operation->Promise.get_future());
+
+				if (!request.File) {
+					operation->Promise.set_value(-1);
+					delete operation;
+					continue;
+				}
+
+				//The completion queue must never overflow; hand what is queued to
+				//the kernel before waiting for room.
+				if (inFlight >= cqEntries) {
+					Enter();
+					space.wait(lock, [this] { return inFlight < cqEntries; });
+				}
+
+				++inFlight;
+				Queue(operation);
+			}
+
+			Enter();
+			return futures;
+		}
+
+	private:
+		struct Operation {
+			AsyncReadRequest Request;
+			std::promise<csint> Promise;
+			size_t Done{ 0 };
+			iovec Vector{};
+		};
+
+		int ring{ -1 };
+		void* sqRing{ nullptr };
+		void* cqRing{ nullptr };
+		io_uring_sqe* sqes{ nullptr };
+		size_t sqRingSize{ 0 };
+		size_t cqRingSize{ 0 };
+		size_t sqesSize{ 0 };
+
+		unsigned* sqHead{ nullptr };
+		unsigned* sqTail{ nullptr };
+		unsigned* sqArray{ nullptr };
+		unsigned sqMask{ 0 };
+		unsigned sqEntries{ 0 };
+		unsigned* cqHead{ nullptr };
+		unsigned* cqTail{ nullptr };
+		io_uring_cqe* cqes{ nullptr };
+		unsigned cqMask{ 0 };
+		unsigned cqEntries{ 0 };
+
+		std::mutex mutex;
+		std::condition_variable space;
+		unsigned inFlight{ 0 };
+		unsigned pending{ 0 };
+		std::thread completer;
+
+		IoUringIO() = default;
+
+		static void* Map(int ring, size_t size, off_t offset) {
+			const auto memory = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring, offset);
+			return memory == MAP_FAILED ? nullptr : memory;
+		}
+
+		//Requires mutex. Flushes the ring to the kernel when it is full.
+		io_uring_sqe* NextEntry() {
+			const auto tail = *sqTail;
+
+			if (tail - std::atomic_ref(*sqHead).load(std::memory_order_acquire) == sqEntries)
+				Enter();
+
+			const auto index = tail & sqMask;
+			sqArray[index] = index;
+			std::atomic_ref(*sqTail).store(tail + 1, std::memory_order_release);
+			++pending;
+
+			return &sqes[index];
+		}
+
+		//Requires mutex.
+		void Queue(Operation* operation) {
+			auto const& request = operation->Request;
+
+			operation->Vector.iov_base = request.Buffer.data() + operation->Done;
+			operation->Vector.iov_len = request.Buffer.size() - operation->Done;
+
+			const auto sqe = NextEntry();
+			std::memset(sqe, 0, sizeof(io_uring_sqe));
+			sqe->opcode = IORING_OP_READV;
+			sqe->fd = request.File->_descriptor;
+			sqe->off = static_cast<csulong>(request.Offset) + operation->Done;
+			sqe->addr = reinterpret_cast<csulong>(&operation->Vector);
+			sqe->len = 1;
+			sqe->user_data = reinterpret_cast<csulong>(operation);
+		}
+
+		//Requires mutex.
+		void Enter() {
+			while (pending > 0) {
+				const auto submitted = syscall(__NR_io_uring_enter, ring, pending, 0, 0, nullptr, 0);
+
+				if (submitted < 0 && errno == EINTR)
+					continue;
+
+				if (submitted <= 0)
+					break;
+
+				pending -= static_cast<unsigned>(submitted);
+			}
+		}
+
+		void Complete() {
+			for (;;) {
+				if (syscall(__NR_io_uring_enter, ring, 0, 1, IORING_ENTER_GETEVENTS, nullptr, 0) < 0 && errno != EINTR)
+					return;
+
+				auto head = *cqHead;
+				const auto tail = std::atomic_ref(*cqTail).load(std::memory_order_acquire);
+				bool stop = false;
+
+				for (; head != tail; ++head) {
+					auto const& cqe = cqes[head & cqMask];
+
+					if (cqe.user_data == 0)
+						stop = true;
+					else
+						Finish(reinterpret_cast<Operation*>(cqe.user_data), cqe.res);
+				}
+
+				std::atomic_ref(*cqHead).store(head, std::memory_order_release);
+
+				if (stop)
+					return;
+			}
+		}
+
+		void Finish(Operation* operation, int result) {
+			if (result == -EINTR || result == -EAGAIN) {
+				std::lock_guard lock(mutex);
+				Queue(operation);
+				Enter();
+				return;
+			}
+
+			if (result > 0) {
+				operation->Done += static_cast<size_t>(result);
+
+				//Short read before the end of the file: ask for the rest.
+				if (operation->Done < operation->Request.Buffer.size()) {
+					std::lock_guard lock(mutex);
+					Queue(operation);
+					Enter();
+					return;
+				}
+			}
+
+			operation->Promise.set_value(result < 0 ? -1 : static_cast<csint>(operation->Done));
+			delete operation;
+
+			{
+				std::lock_guard lock(mutex);
+				--inFlight;
+			}
+
+			space.notify_one();
+		}
+	};
+
+	std::unique_ptr<AsyncIO> AsyncIO::CreateIoUring(csuint entries) {
+		return IoUringIO::Create(entries);
+	}
+#else
+	std::unique_ptr<AsyncIO> AsyncIO::CreateIoUring(csuint entries) {
+		return nullptr;
+	}
+#endif
+}
+
+//AsyncIO
+namespace xna {
+	AsyncIO& AsyncIO::Default() {
+		static const auto instance = [] {
+			auto io = CreateIoUring();
+			return io ? std::move(io) : CreateThreadPool();
+		}();
+
+		return *instance;
+	}
+
+	std::vector<std::future<std::shared_ptr<cs::MemoryStream>>> AsyncIO::ReadFiles(std::vector<std::string> const& paths) {
+		std::vector<std::shared_ptr<std::vector<csbyte>>> buffers(paths.size());
+		std::vector<AsyncReadRequest> requests;
+
+		for (size_t i = 0; i < paths.size(); ++i) {
+			auto file = AsyncFile::Open(paths[i]);
+
+			if (!file)
+				continue;
+
+			buffers[i] = std::make_shared<std::vector<csbyte>>(static_cast<size_t>(file->Length()));
+			requests.push_back({ file, 0, *buffers[i], buffers[i] });
+		}
+
+		auto reads = Submit(requests);
+		std::vector<std::future<std::shared_ptr<cs::MemoryStream>>> streams;
+		size_t next = 0;
+
+		for (auto& buffer : buffers) {
+			if (!buffer) {
+				std::promise<std::shared_ptr<cs::MemoryStream>> missing;
+				missing.set_value(nullptr);
+				streams.push_back(missing.get_future());
+				continue;
+			}
+
+			//Deferred: the stream is built by whoever calls get(), no extra thread.
+			streams.push_back(std::async(std::launch::deferred,
+				[read = std::move(reads[next++]), buffer]() mutable -> std::shared_ptr<cs::MemoryStream> {
+					if (read.get() != static_cast<csint>(buffer->size()))
+						return nullptr;
+
+					return std::make_shared<cs::MemoryStream>(std::move(*buffer), false);
+				}));
+		}
+
+		return streams;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,89 @@
+#ifndef XNA_UTILITIES_ASYNCIO_HPP
+#define XNA_UTILITIES_ASYNCIO_HPP
+
+#include <future>
+#include <memory>
+#include <span>
+#include <string>
+#include <vector>
+#include "../csharp/integralnumeric.hpp"
+#include "../csharp/stream/stream.hpp"
+
+//AsyncFile
+namespace xna {
+	//Read-only file handle for positional reads issued through AsyncIO.
+	class AsyncFile : public std::enable_shared_from_this<AsyncFile> {
+	public:
+		AsyncFile() = default;
+		AsyncFile(AsyncFile const&) = delete;
+		AsyncFile& operator=(AsyncFile const&) = delete;
+
+		~AsyncFile();
+
+		//Returns nullptr when the file cannot be opened.
+		static std::shared_ptr<AsyncFile> Open(std::string const& path);
+
+		constexpr cslong Length() const {
+			return _length;
+		}
+
+		//Reads up to buffer.size() bytes at offset through AsyncIO::Default().
+		//The future yields the number of bytes read, or -1 on error; buffer
+		//must stay alive until then.
+		std::future<csint> ReadAsync(cslong offset, std::span<csbyte> buffer);
+
+		//Blocking positional read, used by the thread pool backend.
+		csint Read(cslong offset, std::span<csbyte> buffer) const;
+
+	private:
+		cslong _length{ 0 };
+#ifdef _WIN32
+		void* _handle{ nullptr };
+#else
+		int _descriptor{ -1 };
+#endif
+
+		friend class IoUringIO;
+	};
+
+	struct AsyncReadRequest {
+		std::shared_ptr<AsyncFile> File;
+		cslong Offset{ 0 };
+		std::span<csbyte> Buffer;
+		//Kept alive until the read completes, for when Buffer may outlive its future.
+		std::shared_ptr<void> Owner;
+	};
+}
+
+//AsyncIO
+namespace xna {
+	//Runs file reads off the calling thread. The default backend is io_uring where
+	//the kernel provides it, otherwise a small pool of threads doing blocking reads.
+	class AsyncIO {
+	public:
+		virtual ~AsyncIO() = default;
+
+		static AsyncIO& Default();
+
+		//nullptr when io_uring is not available on this system.
+		static std::unique_ptr<AsyncIO> CreateIoUring(csuint entries = 256);
+		static std::unique_ptr<AsyncIO> CreateThreadPool(csint threads = 4);
+
+		virtual bool IsIoUring() const = 0;
+
+		//Queues every request before waking the backend once; the futures come
+		//back in request order.
+		virtual std::vector<std::future<csint>> Submit(std::span<const AsyncReadRequest> requests) = 0;
+
+		std::future<csint> ReadAsync(std::shared_ptr<AsyncFile> const& file, cslong offset, std::span<csbyte> buffer) {
+			const AsyncReadRequest request{ file, offset, buffer, nullptr };
+			return std::move(Submit(std::span<const AsyncReadRequest>(&request, 1)).front());
+		}
+
+		//Reads each file whole in one batch. A future yields nullptr when its
+		//file could not be opened or read completely.
+		std::vector<std::future<std::shared_ptr<cs::MemoryStream>>> ReadFiles(std::vector<std::string> const& paths);
+	};
+}
+
+#endif
\ No newline at end of file
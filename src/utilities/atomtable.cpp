@@ -0,0 +1,112 @@
+#include "atomtable.hpp"
+#include <atomic>
+#include <cstring>
+#include <mutex>
+
+namespace xna {
+	static std::atomic<csulong> nextTableId{ 1 };
+
+	AtomTable::AtomTable() :
+		_id(nextTableId++) {
+		_names.push_back(std::string_view());
+		_atoms.emplace(std::string_view(), Empty);
+	}
+
+	AtomTable& AtomTable::Default() {
+		static AtomTable table;
+		return table;
+	}
+
+	std::unordered_map<std::string_view, Atom>& AtomTable::ThreadCache() const {
+		thread_local csulong cachedTable = 0;
+		thread_local std::unordered_map<std::string_view, Atom> cache;
+
+		//The cache serves one table at a time; in practice that is Default().
+		if (cachedTable != _id) {
+			cache.clear();
+			cachedTable = _id;
+		}
+
+		return cache;
+	}
+
+	Atom AtomTable::Intern(std::string_view value) {
+		auto& cache = ThreadCache();
+		const auto cached = cache.find(value);
+
+		if (cached != cache.end())
+			return cached->second;
+
+		std::string_view name;
+		Atom atom;
+
+		{
+			std::unique_lock lock(_mutex);
+			const auto found = _atoms.find(value);
+
+			if (found != _atoms.end()) {
+				name = found->first;
+				atom = found->second;
+			}
+			else {
+				name = Store(value);
+				atom = static_cast<Atom>(_names.size());
+
+				_names.push_back(name);
+				_atoms.emplace(name, atom);
+			}
+		}
+
+		//Keyed by the arena copy, which lives as long as the table.
+		cache.emplace(name, atom);
+		return atom;
+	}
+
+	Atom AtomTable::Find(std::string_view value) const {
+		auto& cache = ThreadCache();
+		const auto cached = cache.find(value);
+
+		if (cached != cache.end())
+			return cached->second;
+
+		std::shared_lock lock(_mutex);
+		const auto found = _atoms.find(value);
+
+		if (found == _atoms.end())
+			return None;
+
+		cache.emplace(found->first, found->second);
+		return found->second;
+	}
+
+	std::string_view AtomTable::Name(Atom atom) const {
+		std::shared_lock lock(_mutex);
+		return atom < _names.size() ? _names[atom] : std::string_view();
+	}
+
+	csint AtomTable::Count() const {
+		std::shared_lock lock(_mutex);
+		return static_cast<csint>(_names.size());
+	}
+
+	std::string_view AtomTable::Store(std::string_view value) {
+		if (value.size() > BlockSize / 4) {
+			//Large strings get a block of their own, leaving the arena block in use.
+			_blocks.push_back(std::make_unique<char[]>(value.size()));
+			std::memcpy(_blocks.back().get(), value.data(), value.size());
+			return std::string_view(_blocks.back().get(), value.size());
+		}
+
+		if (BlockSize - _blockUsed < value.size()) {
+			_blocks.push_back(std::make_unique<char[]>(BlockSize));
+			_block = _blocks.back().get();
+			_blockUsed = 0;
+		}
+
+		const auto data = _block + _blockUsed;
+		std::memcpy(data, value.data(), value.size());
+		_blockUsed += value.size();
+
+		return std::string_view(data, value.size());
+	}
+}
\ No newline at end of file
@@ -0,0 +1,62 @@
+#ifndef XNA_UTILITIES_ATOMTABLE_HPP
+#define XNA_UTILITIES_ATOMTABLE_HPP
+
+#include <memory>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "../csharp/integralnumeric.hpp"
+
+namespace xna {
+	//Identifier of an interned string. Equal strings intern to the same atom, so
+	//atoms compare and hash as integers. Atom 0 is the empty string.
+	using Atom = csuint;
+
+	//Thread-safe string interning. Strings are copied once into arena blocks and
+	//live as long as the table, so the views handed out never dangle; nothing is
+	//ever removed. Each thread also remembers the atoms it has looked up, so
+	//repeated lookups of the same names take no lock.
+	class AtomTable {
+	public:
+		static constexpr Atom Empty = 0;
+		//Returned by Find for strings that were never interned.
+		static constexpr Atom None = 0xFFFFFFFF;
+
+		AtomTable();
+		AtomTable(AtomTable const&) = delete;
+		AtomTable& operator=(AtomTable const&) = delete;
+
+		//The process-wide table used by the content pipeline.
+		static AtomTable& Default();
+
+		//Returns the atom of value, adding it on first use.
+		Atom Intern(std::string_view value);
+
+		//Returns the atom of value, or None without adding it.
+		Atom Find(std::string_view value) const;
+
+		//Returns the interned string, or an empty view for an unknown atom.
+		std::string_view Name(Atom atom) const;
+
+		csint Count() const;
+
+	private:
+		static constexpr size_t BlockSize = 64 * 1024;
+
+		//Distinguishes tables in the per-thread caches, which outlive any one table.
+		const csulong _id;
+		mutable std::shared_mutex _mutex;
+		std::unordered_map<std::string_view, Atom> _atoms;
+		std::vector<std::string_view> _names;
+		std::vector<std::unique_ptr<char[]>> _blocks;
+		char* _block{ nullptr };
+		size_t _blockUsed{ BlockSize };
+
+		std::string_view Store(std::string_view value);
+		std::unordered_map<std::string_view, Atom>& ThreadCache() const;
+	};
+}
+
+#endif
\ No newline at end of file
@@ -5,7 +5,7 @@
 #include <string>
 #include "stringhelper.hpp"
 #include "../csharp/io/path.hpp"
-#include "../csharp/uri/uri.hpp";
+#include "../csharp/uri/uri.hpp"
 
 namespace xna {
 	class FileHelpers {
@@ -27,29 +27,38 @@ namespace xna {
 			Replace(name, NotSeparator, Separator);
 		}
 
-		static void ResolveRelativePath(std::string& filePath, std::string& relativeFile) {
-			Replace(filePath, BackwardSlash, ForwardSlash);
-			Replace(relativeFile, BackwardSlash, ForwardSlash);			
+		//Resolves relativeFile against the folder of filePath, the way
+		//Uri("file://" + filePath) combined with relativeFile would.
+		static std::string ResolveRelativePath(std::string const& filePath, std::string const& relativeFile) {
+			auto basePath = filePath;
+			auto relativePath = relativeFile;
 
-			while (Contains(filePath, "//"))
-				Replace(filePath, "//", "/");
+			Replace(basePath, BackwardSlash, ForwardSlash);
+			Replace(relativePath, BackwardSlash, ForwardSlash);
 
-			const auto hasForwardSlash = StartWith(filePath, ForwardSlashString());			
+			while (Contains(basePath, "//"))
+				Replace(basePath, "//", "/");
 
-			if (!hasForwardSlash) {			
-				filePath = ForwardSlashString() + filePath;
+			const auto hasForwardSlash = StartWith(basePath, ForwardSlashString());
+
+			if (!hasForwardSlash) {
+				basePath = ForwardSlashString() + basePath;
 			}
-			
-			auto src = cs::Uri("file://" + relativeFile); //TODO: Uri("file://" + UrlEncode(filePath));			
-			auto dst = cs::Uri(src, relativeFile); //TODO: Uri(src, UrlEncode(relativeFile));
-			auto localPath = dst.LocalPath();
 
-			if (!hasForwardSlash && StartWith(localPath, "/")) {				
-				localPath == localPath;
-			}				
+			auto localPath = StartWith(relativePath, ForwardSlashString())
+				? relativePath
+				: basePath.substr(0, basePath.rfind(ForwardSlash) + 1) + relativePath;
+
+			localPath = RemoveDotSegments(localPath);
+
+			if (!hasForwardSlash && StartWith(localPath, "/")) {
+				localPath = localPath.substr(1);
+			}
 
 			NormalizeFilePathSeparators(localPath);
 			TrimPath(localPath);
+
+			return localPath;
 		}
 
 		static constexpr void UrlEncode(std::string& url) {
@@ -64,6 +73,42 @@ namespace xna {
 		static constexpr std::vector<char> UrlSafeChars() {
 			return { '.', '_', '-', ';', '/', '?', '\\', ':' };
 		}
+
+		//Collapses "." and ".." segments of a forward slash separated path.
+		static std::string RemoveDotSegments(std::string const& path) {
+			std::vector<std::string> segments;
+			size_t start = 0;
+
+			while (start <= path.size()) {
+				auto end = path.find(ForwardSlash, start);
+
+				if (end == std::string::npos)
+					end = path.size();
+
+				const auto segment = path.substr(start, end - start);
+
+				if (segment == "..") {
+					if (segments.size() > 1)
+						segments.pop_back();
+				}
+				else if (segment != "." && (!segment.empty() || segments.empty())) {
+					segments.push_back(segment);
+				}
+
+				start = end + 1;
+			}
+
+			std::string result;
+
+			for (size_t i = 0; i < segments.size(); ++i) {
+				if (i > 0)
+					result += ForwardSlash;
+
+				result += segments[i];
+			}
+
+			return result;
+		}
 	};
 }
 
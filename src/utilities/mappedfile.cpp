@@ -0,0 +1,87 @@
+#include "mappedfile.hpp"
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace xna {
+#ifdef _WIN32
+	std::shared_ptr<MappedFile> MappedFile::Open(std::string const& path) {
+		auto file = std::make_shared<MappedFile>();
+
+		file->_file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_RANDOM_ACCESS, nullptr);
+
+		if (file->_file == INVALID_HANDLE_VALUE) {
+			file->_file = nullptr;
+			return nullptr;
+		}
+
+		LARGE_INTEGER size;
+
+		if (!GetFileSizeEx(file->_file, &size) || size.QuadPart == 0)
+			return nullptr;
+
+		file->_mapping = CreateFileMappingA(file->_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+
+		if (!file->_mapping)
+			return nullptr;
+
+		file->_data = MapViewOfFile(file->_mapping, FILE_MAP_READ, 0, 0, 0);
+
+		if (!file->_data)
+			return nullptr;
+
+		file->_size = static_cast<size_t>(size.QuadPart);
+		return file;
+	}
+
+	MappedFile::~MappedFile() {
+		if (_data)
+			UnmapViewOfFile(_data);
+
+		if (_mapping)
+			CloseHandle(_mapping);
+
+		if (_file)
+			CloseHandle(_file);
+	}
+#else
+	std::shared_ptr<MappedFile> MappedFile::Open(std::string const& path) {
+		auto file = std::make_shared<MappedFile>();
+
+		file->_descriptor = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+
+		if (file->_descriptor < 0)
+			return nullptr;
+
+		struct stat status;
+
+		if (fstat(file->_descriptor, &status) != 0 || status.st_size == 0)
+			return nullptr;
+
+		const auto size = static_cast<size_t>(status.st_size);
+		const auto data = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, file->_descriptor, 0);
+
+		if (data == MAP_FAILED)
+			return nullptr;
+
+		file->_data = data;
+		file->_size = size;
+
+		return file;
+	}
+
+	MappedFile::~MappedFile() {
+		if (_data)
+			munmap(_data, _size);
+
+		if (_descriptor >= 0)
+			close(_descriptor);
+	}
+#endif
+}
\ No newline at end of file
@@ -0,0 +1,42 @@
+#ifndef XNA_UTILITIES_MAPPEDFILE_HPP
+#define XNA_UTILITIES_MAPPEDFILE_HPP
+
+#include <memory>
+#include <span>
+#include <string>
+#include "../csharp/integralnumeric.hpp"
+
+namespace xna {
+	//Read-only memory mapping of a whole file.
+	class MappedFile {
+	public:
+		MappedFile() = default;
+		MappedFile(MappedFile const&) = delete;
+		MappedFile& operator=(MappedFile const&) = delete;
+
+		~MappedFile();
+
+		//Returns nullptr when the file cannot be opened or mapped.
+		static std::shared_ptr<MappedFile> Open(std::string const& path);
+
+		std::span<const csbyte> Data() const {
+			return std::span<const csbyte>(static_cast<csbyte const*>(_data), _size);
+		}
+
+		constexpr size_t Size() const {
+			return _size;
+		}
+
+	private:
+		void* _data{ nullptr };
+		size_t _size{ 0 };
+#ifdef _WIN32
+		void* _file{ nullptr };
+		void* _mapping{ nullptr };
+#else
+		int _descriptor{ -1 };
+#endif
+	};
+}
+
+#endif
\ No newline at end of file